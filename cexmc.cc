@@ -17,6 +17,8 @@
  */
 
 #include <set>
+#include <vector>
+#include <algorithm>
 #ifdef CEXMC_USE_PERSISTENCY
 #include <boost/algorithm/string.hpp>
 #include <boost/archive/archive_exception.hpp>
@@ -37,6 +39,7 @@
 #include <G4VisExecutive.hh>
 #include "CexmcRunManager.hh"
 #include "CexmcHistoManager.hh"
+#include "CexmcStageProfiler.hh"
 #include "CexmcSetup.hh"
 #include "CexmcPhysicsList.hh"
 #include "CexmcPhysicsManager.hh"
@@ -62,18 +65,23 @@ struct  CexmcCmdLineData
     CexmcCmdLineData() : isInteractive( false ), startQtSession( false ),
                          preinitMacro( "" ), initMacro( "" ), rProject( "" ),
                          wProject( "" ), overrideExistingProject( false ),
-                         customFilter( "" )
+                         resumeFromCheckpoint( false ), customFilter( "" )
     {}
 
-    G4bool                  isInteractive;
-    G4bool                  startQtSession;
-    G4String                preinitMacro;
-    G4String                initMacro;
-    G4String                rProject;
-    G4String                wProject;
-    G4bool                  overrideExistingProject;
-    CexmcOutputDataTypeSet  outputData;
-    G4String                customFilter;
+    G4bool                   isInteractive;
+    G4bool                   startQtSession;
+    G4String                 preinitMacro;
+    G4String                 initMacro;
+    G4String                 rProject;
+    G4String                 wProject;
+    G4bool                   overrideExistingProject;
+    G4bool                   resumeFromCheckpoint;
+    CexmcOutputDataTypeSet   outputData;
+    G4String                 customFilter;
+    /* projects written in the same replay pass as wProject, each with
+     * its own custom filter */
+    std::vector< G4String >  extraWProjects;
+    std::vector< G4String >  extraCustomFilters;
 };
 
 
@@ -91,7 +99,7 @@ void  printUsage( void )
 #endif
                            "[-p preinit_macro] [-m init_macro] "
 #ifdef CEXMC_USE_PERSISTENCY
-                           "[[-y] -w project]" << G4endl <<
+                           "[[-y] [-c] -w project]" << G4endl <<
               "             [-r project "
 #ifdef CEXMC_USE_CUSTOM_FILTER
                            "[-f filter_script] "
@@ -113,11 +121,18 @@ void  printUsage( void )
               G4endl;
 #ifdef CEXMC_USE_CUSTOM_FILTER
     G4cout << "           -f - use specified custom filter script" << G4endl;
+    G4cout << "                (pairs -f filter_script -w project can be "
+                              "repeated to write" << G4endl <<
+              "                several projects in one pass over the read "
+                              "project)" << G4endl;
 #endif
     G4cout << "           -o - comma-separated list of data to output, "
                               "possible values:" << G4endl <<
               "                run, geom, events" << G4endl;
     G4cout << "           -y - force project override" << G4endl;
+    G4cout << "           -c - resume written project from its last "
+                              "checkpoint (not" << G4endl <<
+              "                allowed with -r)" << G4endl;
 #endif
     G4cout << "  --help | -h - print this message and exit " << G4endl;
 }
@@ -178,13 +193,21 @@ G4bool  parseArgs( int  argc, char **  argv, CexmcCmdLineData &  cmdLineData )
 #ifdef CEXMC_USE_PERSISTENCY
             if ( G4String( argv[ i ], 2 ) == "-w" )
             {
-                cmdLineData.wProject = argv[ i ] + 2;
-                if ( cmdLineData.wProject == "" )
+                G4String  wProject( argv[ i ] + 2 );
+                if ( wProject == "" )
                 {
                     if ( ++i >= argc )
                         throw CexmcException( CexmcCmdLineParseException );
-                    cmdLineData.wProject = argv[ i ];
+                    wProject = argv[ i ];
                 }
+#ifdef CEXMC_USE_CUSTOM_FILTER
+                if ( cmdLineData.wProject != "" )
+                {
+                    cmdLineData.extraWProjects.push_back( wProject );
+                    break;
+                }
+#endif
+                cmdLineData.wProject = wProject;
                 break;
             }
             if ( G4String( argv[ i ], 2 ) == "-r" )
@@ -203,6 +226,11 @@ G4bool  parseArgs( int  argc, char **  argv, CexmcCmdLineData &  cmdLineData )
                 cmdLineData.overrideExistingProject = true;
                 break;
             }
+            if ( G4String( argv[ i ], 2 ) == "-c" )
+            {
+                cmdLineData.resumeFromCheckpoint = true;
+                break;
+            }
             if ( G4String( argv[ i ], 2 ) == "-o" )
             {
                 std::string  outputData( argv[ i ] + 2 );
@@ -243,13 +271,17 @@ G4bool  parseArgs( int  argc, char **  argv, CexmcCmdLineData &  cmdLineData )
 #ifdef CEXMC_USE_CUSTOM_FILTER
             if ( G4String( argv[ i ], 2 ) == "-f" )
             {
-                cmdLineData.customFilter = argv[ i ] + 2;
-                if ( cmdLineData.customFilter == "" )
+                G4String  customFilter( argv[ i ] + 2 );
+                if ( customFilter == "" )
                 {
                     if ( ++i >= argc )
                         throw CexmcException( CexmcCmdLineParseException );
-                    cmdLineData.customFilter = argv[ i ];
+                    customFilter = argv[ i ];
                 }
+                if ( cmdLineData.customFilter != "" )
+                    cmdLineData.extraCustomFilters.push_back( customFilter );
+                else
+                    cmdLineData.customFilter = customFilter;
                 break;
             }
 #endif
@@ -289,9 +321,26 @@ int  main( int  argc, char **  argv )
 #ifdef CEXMC_USE_CUSTOM_FILTER
         if ( cmdLineData.rProject == "" && ! cmdLineData.customFilter.empty() )
             throw CexmcException( CexmcCmdLineParseException );
+        if ( cmdLineData.extraWProjects.size() !=
+             cmdLineData.extraCustomFilters.size() )
+            throw CexmcException( CexmcCmdLineParseException );
+        for ( std::vector< G4String >::const_iterator
+                k( cmdLineData.extraWProjects.begin() );
+                k != cmdLineData.extraWProjects.end(); ++k )
+        {
+            if ( *k == cmdLineData.rProject || *k == cmdLineData.wProject ||
+                 std::count( cmdLineData.extraWProjects.begin(),
+                             cmdLineData.extraWProjects.end(), *k ) > 1 )
+                throw CexmcException( CexmcCmdLineParseException );
+        }
 #endif
         if ( cmdLineData.wProject != "" && ! cmdLineData.outputData.empty() )
             throw CexmcException( CexmcCmdLineParseException );
+        if ( cmdLineData.wProject == "" && cmdLineData.resumeFromCheckpoint )
+            throw CexmcException( CexmcCmdLineParseException );
+        /* replay runs are not checkpointed */
+        if ( cmdLineData.rProject != "" && cmdLineData.resumeFromCheckpoint )
+            throw CexmcException( CexmcCmdLineParseException );
         outputDataOnly = ! cmdLineData.outputData.empty();
 #endif
     }
@@ -319,8 +368,14 @@ int  main( int  argc, char **  argv )
                                           cmdLineData.rProject,
                                           cmdLineData.overrideExistingProject );
 #ifdef CEXMC_USE_PERSISTENCY
+        runManager->ResumeFromCheckpoint( cmdLineData.resumeFromCheckpoint );
 #ifdef CEXMC_USE_CUSTOM_FILTER
         runManager->SetCustomFilter( cmdLineData.customFilter );
+        for ( std::vector< G4String >::size_type  i( 0 );
+              i < cmdLineData.extraWProjects.size(); ++i )
+            runManager->AddReplayOutput( cmdLineData.extraWProjects[ i ],
+                                         cmdLineData.extraCustomFilters[ i ],
+                                         cmdLineData.overrideExistingProject );
 #endif
 
         if ( outputDataOnly )
@@ -469,6 +524,9 @@ int  main( int  argc, char **  argv )
 
 #ifdef CEXMC_USE_ROOT
     CexmcHistoManager::Destroy();
+#endif
+#ifdef CEXMC_USE_PROFILER
+    CexmcStageProfiler::Destroy();
 #endif
     CexmcMessenger::Destroy();
     delete session;
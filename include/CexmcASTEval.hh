@@ -25,6 +25,8 @@
 #include <string>
 #include <boost/variant/variant.hpp>
 #include "CexmcAST.hh"
+#include "CexmcASTProgram.hh"
+#include "CexmcEnergyDepositCalorimeterView.hh"
 #include "CexmcEventSObject.hh"
 #include "CexmcEventFastSObject.hh"
 #include "CexmcException.hh"
@@ -55,6 +57,26 @@ class  CexmcASTEval : public CexmcAST::BasicEval
 
         void  ResetAddressBinding( CexmcAST::Subtree &  ast );
 
+        /* replaces unit constants (MeV, cm etc.) and constant subexpressions
+         * with their values */
+        void  FoldConstants( CexmcAST::Subtree &  ast ) const;
+
+        /* counts scalar subexpressions of ast in cache, subexpressions which
+         * are met more than once will be evaluated only once per event if
+         * the programs are compiled with this cache */
+        void  RegisterSubexpressions( const CexmcAST::Subtree &  ast,
+                                      CexmcASTProgram::Cache &  cache ) const;
+
+        /* must be called after BindAddresses() or ResetAddressBinding() as
+         * far as compiled program refers to the bound addresses directly */
+        void  Compile( const CexmcAST::Subtree &  ast,
+                       CexmcASTProgram &  program ) const;
+
+        /* returns false if ast refers only to fast events data and
+         * constants and thus can be evaluated before events data record is
+         * decoded */
+        static G4bool  NeedsEventData( const CexmcAST::Subtree &  ast );
+
     private:
         ScalarValueType  GetFunScalarValue( const CexmcAST::Subtree &  ast )
                                                                         const;
@@ -63,7 +85,36 @@ class  CexmcASTEval : public CexmcAST::BasicEval
                                                                         const;
 
         void             GetEDCollectionValue( const CexmcAST::Node &  node,
-                    CexmcEnergyDepositCalorimeterCollection &  edCol ) const;
+                    CexmcEnergyDepositCalorimeterView &  edCol ) const;
+
+    private:
+        G4bool  FoldNode( CexmcAST::Node &  node ) const;
+
+        static const G4double *  FindConstant( const std::string &  name );
+
+    private:
+        CexmcASTProgram::ValueType  CompileNode( const CexmcAST::Node &  node,
+                                    CexmcASTProgram &  program ) const;
+
+        CexmcASTProgram::ValueType  CompileSubtree(
+                                    const CexmcAST::Subtree &  ast,
+                                    CexmcASTProgram &  program ) const;
+
+        CexmcASTProgram::ValueType  CompileOperator(
+                                    const CexmcAST::Subtree &  ast,
+                                    CexmcASTProgram &  program ) const;
+
+        CexmcASTProgram::ValueType  CompileFunction(
+                                    const CexmcAST::Subtree &  ast,
+                                    CexmcASTProgram &  program ) const;
+
+        CexmcASTProgram::ValueType  CompileVariable(
+                                    const CexmcAST::Variable &  var,
+                                    CexmcASTProgram &  program ) const;
+
+        void                        CompileEDCollection(
+                                    const CexmcAST::Node &  node,
+                                    CexmcASTProgram &  program ) const;
 
     private:
         const G4double *  GetThreeVectorElementAddrByIndex(
@@ -0,0 +1,301 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcASTProgram.hh
+ *
+ *    Description:  custom filter expressions compiled into a flat bytecode
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 22:04:17
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_AST_PROGRAM_HH
+#define CEXMC_AST_PROGRAM_HH
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include <vector>
+#include <map>
+#include <string>
+#include "CexmcEnergyDepositCalorimeterView.hh"
+#include "CexmcException.hh"
+#include "CexmcCommon.hh"
+
+
+/* stack machine with statically typed instructions: types of all operands
+ * and addresses of all variables are resolved when an expression is
+ * compiled, so running the program does not dispatch on value types */
+class  CexmcASTProgram
+{
+    public:
+        enum  ValueType
+        {
+            IntValue,
+            DoubleValue
+        };
+
+        enum  OpCode
+        {
+            PushInt,
+            PushDouble,
+            LoadInt,
+            LoadDouble,
+            LoadBool,
+            LoadTrackIdIsValid,
+            LoadEDColElement,
+            LoadEDCol,
+            EDColInner,
+            EDColOuter,
+            EDColSum,
+            EDColMax,
+            EDColArgMaxRow,
+            EDColArgMaxColumn,
+            EDColCount,
+            IntToDouble,
+            IntToDoubleBelowTop,
+            NegInt,
+            NegDouble,
+            NotInt,
+            NotDouble,
+            MultInt,
+            DivInt,
+            PlusInt,
+            MinusInt,
+            LessInt,
+            LessEqInt,
+            MoreInt,
+            MoreEqInt,
+            EqInt,
+            NotEqInt,
+            MultDouble,
+            DivDouble,
+            PlusDouble,
+            MinusDouble,
+            LessDouble,
+            LessEqDouble,
+            MoreDouble,
+            MoreEqDouble,
+            EqDouble,
+            NotEqDouble,
+            SqrInt,
+            SqrDouble,
+            SqrtDouble,
+            TestInt,
+            TestDouble,
+            JumpIfFalse,
+            JumpIfTrue,
+            JumpIfCached,
+            StoreCached,
+            Throw
+        };
+
+        struct  Instruction
+        {
+            OpCode  op;
+
+            union
+            {
+                G4int                                              intValue;
+
+                G4double                                           doubleValue;
+
+                const G4int *                                      intAddr;
+
+                const G4double *                                   doubleAddr;
+
+                const G4bool *                                     boolAddr;
+
+                const CexmcEnergyDepositCalorimeterCollection *    edColAddr;
+            }       operand;
+
+            /* vector indices or jump target */
+            G4int   arg1;
+
+            G4int   arg2;
+        };
+
+        union  Value
+        {
+            G4int     intValue;
+
+            G4double  doubleValue;
+        };
+
+        /* values of subexpressions which are shared between programs, a
+         * cached value is valid until the next call of Invalidate() */
+        class  Cache
+        {
+            friend class  CexmcASTProgram;
+
+            public:
+                Cache();
+
+            public:
+                void   Clear( void );
+
+                void   AddSubexpression( const std::string &  key );
+
+                /* only subexpressions which were added more than once get
+                 * cache slots */
+                void   AssignSlots( void );
+
+                /* returns -1 if the subexpression has no cache slot */
+                G4int  GetSlot( const std::string &  key ) const;
+
+                void   Invalidate( void );
+
+            private:
+                /* occurrences of subexpressions before AssignSlots(), cache
+                 * slots after */
+                std::map< std::string, G4int >  slots;
+
+                std::vector< Value >            values;
+
+                std::vector< G4int >            generations;
+
+                G4int                           generation;
+        };
+
+    public:
+        CexmcASTProgram();
+
+    public:
+        void       Clear( void );
+
+        G4int      Emit( OpCode  op );
+
+        G4int      EmitInt( OpCode  op, G4int  value );
+
+        G4int      EmitDouble( OpCode  op, G4double  value );
+
+        G4int      EmitAddr( OpCode  op, const G4int *  addr );
+
+        G4int      EmitAddr( OpCode  op, const G4double *  addr );
+
+        G4int      EmitAddr( OpCode  op, const G4bool *  addr );
+
+        G4int      EmitAddr( OpCode  op,
+                        const CexmcEnergyDepositCalorimeterCollection *  addr,
+                        G4int  index1 = 0, G4int  index2 = 0 );
+
+        /* makes jump at position pos lead to the next emitted instruction */
+        void       SetJumpTarget( G4int  pos );
+
+        void       SetResultType( ValueType  value );
+
+        void       SetCache( Cache *  value );
+
+        Cache *    GetCache( void ) const;
+
+        bool       Run( void ) const;
+
+        /* runs the program for count records at once applying every
+         * instruction to a whole column of values: variables which lie in
+         * [origin, origin + size) are loaded from the same offsets in the
+         * records which start at base and follow each other with stride,
+         * other variables are shared by all records; result of the program
+         * for every record is put into result */
+        void       RunBatch( const char *  origin, size_t  size,
+                             const char *  base, size_t  stride, G4int  count,
+                             std::vector< unsigned char > &  result ) const;
+
+        /* both paths of every jump are evaluated in RunBatch(), so programs
+         * which refer to calorimeter collections, cache or may throw or
+         * divide integers cannot be run in batches */
+        G4bool     CanRunBatch( void ) const;
+
+        void       Print( void ) const;
+
+    private:
+        struct  BatchJump
+        {
+            G4int                 target;
+
+            G4int                 slot;
+
+            G4bool                ifTrue;
+
+            std::vector< Value >  value;
+        };
+
+    private:
+        Instruction &  Append( OpCode  op );
+
+        const char *   GetBatchAddr( const void *  addr, const char *  origin,
+                                     size_t  size, const char *  base ) const;
+
+    private:
+        std::vector< Instruction >                         code;
+
+        ValueType                                          resultType;
+
+        G4int                                              depth;
+
+        Cache *                                            cache;
+
+        G4bool                                             canRunBatch;
+
+    private:
+        mutable std::vector< Value >                       stack;
+
+        mutable CexmcEnergyDepositCalorimeterView          edCol;
+
+        mutable std::vector< std::vector< Value > >        batchStack;
+
+        mutable std::vector< BatchJump >                   batchJumps;
+};
+
+
+inline void  CexmcASTProgram::Cache::Invalidate( void )
+{
+    ++generation;
+}
+
+
+inline void  CexmcASTProgram::SetResultType( ValueType  value )
+{
+    resultType = value;
+}
+
+
+inline void  CexmcASTProgram::SetCache( Cache *  value )
+{
+    cache = value;
+}
+
+
+inline CexmcASTProgram::Cache *  CexmcASTProgram::GetCache( void ) const
+{
+    return cache;
+}
+
+
+inline G4bool  CexmcASTProgram::CanRunBatch( void ) const
+{
+    return canRunBatch;
+}
+
+
+inline const char *  CexmcASTProgram::GetBatchAddr( const void *  addr,
+                                    const char *  origin, size_t  size,
+                                    const char *  base ) const
+{
+    const char *  charAddr( static_cast< const char * >( addr ) );
+
+    if ( charAddr < origin || charAddr >= origin + size )
+        return NULL;
+
+    return base + ( charAddr - origin );
+}
+
+#endif
+
+#endif
+
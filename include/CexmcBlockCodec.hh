@@ -0,0 +1,81 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcBlockCodec.hh
+ *
+ *    Description:  compression codecs for blocks of events data
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 18:10:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_BLOCK_CODEC_HH
+#define CEXMC_BLOCK_CODEC_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <vector>
+#include <cstddef>
+#include <G4Types.hh>
+#include "CexmcCommon.hh"
+
+
+class  CexmcBlockCodec
+{
+    public:
+        virtual ~CexmcBlockCodec();
+
+    public:
+        /* appends compressed data to output */
+        virtual void    Compress( const char *  data, std::size_t  size,
+                                  std::vector< char > &  output ) const = 0;
+
+        /* returns false if data is corrupted or does not decompress to
+         * exactly outputSize bytes */
+        virtual G4bool  Decompress( const char *  data, std::size_t  size,
+                                    char *  output,
+                                    std::size_t  outputSize ) const = 0;
+
+    public:
+        /* returns NULL for CexmcNoEventDataCodec */
+        static CexmcBlockCodec *  Create( CexmcEventDataCodec  codec );
+};
+
+
+/* byte-oriented LZ77 codec in the spirit of LZF: fast compression with a
+ * single hash table lookup per position and branch-light decompression */
+class  CexmcLZBlockCodec : public CexmcBlockCodec
+{
+    public:
+        void    Compress( const char *  data, std::size_t  size,
+                          std::vector< char > &  output ) const;
+
+        G4bool  Decompress( const char *  data, std::size_t  size,
+                            char *  output, std::size_t  outputSize ) const;
+
+    private:
+        static void  PutLiterals( const unsigned char *  data,
+                                  std::size_t  size,
+                                  std::vector< char > &  output );
+
+    private:
+        static const std::size_t  maxLiteralRun;
+
+        static const std::size_t  maxMatchLength;
+
+        static const std::size_t  maxOffset;
+
+        static const G4int        hashBits;
+};
+
+#endif
+
+#endif
+
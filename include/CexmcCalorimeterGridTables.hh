@@ -0,0 +1,272 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcCalorimeterGridTables.hh
+ *
+ *    Description:  precomputed calorimeter tables and passes over ED grids
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 21:48:03
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_CALORIMETER_GRID_TABLES_HH
+#define CEXMC_CALORIMETER_GRID_TABLES_HH
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "CexmcEnergyDepositCalorimeterCollection.hh"
+#include "CexmcSetup.hh"
+
+
+/* tables of a calorimeter geometry which are used in passes over energy
+ * deposit grids: masks of outer and inner crystals in row-major order and
+ * local coordinates of crystal centers; grids passed to the passes must have
+ * the dimensions of the geometry.
+ *
+ * The passes are plain loops over contiguous rows without branches that
+ * depend on the data. Every sum is accumulated in the row-major order of
+ * crystals as before, so the results are bit-compatible with summing
+ * crystals one by one: reordering the additions across vector lanes would
+ * change rounding of the sums */
+class  CexmcCalorimeterGridTables
+{
+    public:
+        CexmcCalorimeterGridTables();
+
+    public:
+        /* builds the tables for the geometry */
+        void      Build( const CexmcSetup::CalorimeterGeometryData &
+                                                    calorimeterGeometry );
+
+    public:
+        /* total energy deposit and its parts in inner and outer crystals */
+        void      SumEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4double &  total, G4double &  inner,
+                G4double &  outer ) const;
+
+        /* finds the first crystal in row-major order with the maximum
+         * positive energy deposit; row and column are left intact if there
+         * is no such crystal */
+        static G4double  FindMaxEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int &  row, G4int &  column );
+
+        /* adds energy deposit in crystals [ rowBegin, rowEnd ) x
+         * [ columnBegin, columnEnd ) to ed */
+        static void      SumEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int  rowBegin, G4int  rowEnd,
+                G4int  columnBegin, G4int  columnEnd, G4double &  ed );
+
+        /* sums of crystal centers coordinates weighted by energy deposit
+         * (or by its square root) and sum of the weights in crystals
+         * [ rowBegin, rowEnd ) x [ columnBegin, columnEnd ) */
+        void      SumWeightedCrystalCenters(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int  rowBegin, G4int  rowEnd,
+                G4int  columnBegin, G4int  columnEnd, G4bool  sqrtWeights,
+                G4double &  xWeightsSum, G4double &  yWeightsSum,
+                G4double &  energyWeightsSum ) const;
+
+    public:
+        G4bool    IsOuterCrystal( G4int  column, G4int  row ) const;
+
+        G4double  GetCrystalCenterX( G4int  column ) const;
+
+        G4double  GetCrystalCenterY( G4int  row ) const;
+
+    private:
+        G4int                    nmbOfRows;
+
+        G4int                    nmbOfColumns;
+
+        /* 1 for outer crystals and 0 for inner crystals */
+        std::vector< G4double >  outerMask;
+
+        /* 1 for inner crystals and 0 for outer crystals */
+        std::vector< G4double >  innerMask;
+
+        std::vector< G4double >  crystalCenterX;
+
+        std::vector< G4double >  crystalCenterY;
+
+        /* square roots of weights of a row, used as a scratch buffer */
+        mutable std::vector< G4double >  rowWeights;
+};
+
+
+inline CexmcCalorimeterGridTables::CexmcCalorimeterGridTables() :
+    nmbOfRows( 0 ), nmbOfColumns( 0 )
+{
+}
+
+
+inline void  CexmcCalorimeterGridTables::Build(
+            const CexmcSetup::CalorimeterGeometryData &  calorimeterGeometry )
+{
+    G4double  crystalWidth( calorimeterGeometry.crystalWidth );
+    G4double  crystalHeight( calorimeterGeometry.crystalHeight );
+
+    nmbOfRows = calorimeterGeometry.nCrystalsInColumn;
+    nmbOfColumns = calorimeterGeometry.nCrystalsInRow;
+
+    if ( nmbOfRows <= 0 || nmbOfColumns <= 0 )
+    {
+        nmbOfRows = 0;
+        nmbOfColumns = 0;
+    }
+
+    outerMask.assign( nmbOfRows * nmbOfColumns, 0. );
+    innerMask.assign( nmbOfRows * nmbOfColumns, 0. );
+    crystalCenterX.assign( nmbOfColumns, 0. );
+    crystalCenterY.assign( nmbOfRows, 0. );
+    rowWeights.assign( nmbOfColumns, 0. );
+
+    for ( G4int  i( 0 ); i < nmbOfRows; ++i )
+    {
+        for ( G4int  j( 0 ); j < nmbOfColumns; ++j )
+        {
+            G4bool  isOuter( IsOuterCrystal( j, i ) );
+
+            outerMask[ i * nmbOfColumns + j ] = isOuter ? 1. : 0.;
+            innerMask[ i * nmbOfColumns + j ] = isOuter ? 0. : 1.;
+        }
+    }
+
+    for ( G4int  j( 0 ); j < nmbOfColumns; ++j )
+        crystalCenterX[ j ] =
+                        ( G4double( j ) - G4double( nmbOfColumns ) / 2 ) *
+                        crystalWidth  + crystalWidth / 2;
+
+    for ( G4int  i( 0 ); i < nmbOfRows; ++i )
+        crystalCenterY[ i ] =
+                        ( G4double( i ) - G4double( nmbOfRows ) / 2 ) *
+                        crystalHeight  + crystalHeight / 2;
+}
+
+
+inline void  CexmcCalorimeterGridTables::SumEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4double &  total, G4double &  inner, G4double &  outer ) const
+{
+    const G4double *  values( edHits.GetData() );
+    const G4double *  outerValues( outerMask.empty() ? NULL : &outerMask[ 0 ] );
+    const G4double *  innerValues( innerMask.empty() ? NULL : &innerMask[ 0 ] );
+    G4int             size( edHits.GetSize() );
+
+    /* energy deposit in crystals is never negative, therefore masked out
+     * crystals add exact zeros to the sums */
+    for ( G4int  i( 0 ); i < size; ++i )
+    {
+        total += values[ i ];
+        inner += values[ i ] * innerValues[ i ];
+        outer += values[ i ] * outerValues[ i ];
+    }
+}
+
+
+inline G4double  CexmcCalorimeterGridTables::FindMaxEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int &  row, G4int &  column )
+{
+    const G4double *  values( edHits.GetData() );
+    G4int             size( edHits.GetSize() );
+    G4double          maxValue( 0 );
+
+    /* the maximum value itself does not depend on the order of comparisons,
+     * its first position is looked up only if it is positive */
+    for ( G4int  i( 0 ); i < size; ++i )
+        maxValue = std::max( maxValue, values[ i ] );
+
+    if ( maxValue > 0. )
+    {
+        G4int  index( std::find( values, values + size, maxValue ) - values );
+
+        row = index / edHits.GetNmbOfColumns();
+        column = index % edHits.GetNmbOfColumns();
+    }
+
+    return maxValue;
+}
+
+
+inline void  CexmcCalorimeterGridTables::SumEnergyDeposit(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int  rowBegin, G4int  rowEnd,
+                G4int  columnBegin, G4int  columnEnd, G4double &  ed )
+{
+    for ( G4int  i( rowBegin ); i < rowEnd; ++i )
+    {
+        const G4double *  edRow( edHits[ i ] );
+
+        for ( G4int  j( columnBegin ); j < columnEnd; ++j )
+            ed += edRow[ j ];
+    }
+}
+
+
+inline void  CexmcCalorimeterGridTables::SumWeightedCrystalCenters(
+                const CexmcEnergyDepositCalorimeterCollection &  edHits,
+                G4int  rowBegin, G4int  rowEnd,
+                G4int  columnBegin, G4int  columnEnd, G4bool  sqrtWeights,
+                G4double &  xWeightsSum, G4double &  yWeightsSum,
+                G4double &  energyWeightsSum ) const
+{
+    for ( G4int  i( rowBegin ); i < rowEnd; ++i )
+    {
+        const G4double *  weights( edHits[ i ] );
+
+        if ( sqrtWeights )
+        {
+            /* square roots of the whole row are taken in a separate pass
+             * which does not depend on the sums */
+            for ( G4int  j( columnBegin ); j < columnEnd; ++j )
+                rowWeights[ j ] = std::sqrt( weights[ j ] );
+            weights = &rowWeights[ 0 ];
+        }
+
+        G4double  y( crystalCenterY[ i ] );
+
+        for ( G4int  j( columnBegin ); j < columnEnd; ++j )
+        {
+            xWeightsSum += weights[ j ] * crystalCenterX[ j ];
+            yWeightsSum += weights[ j ] * y;
+            energyWeightsSum += weights[ j ];
+        }
+    }
+}
+
+
+inline G4bool  CexmcCalorimeterGridTables::IsOuterCrystal( G4int  column,
+                                                           G4int  row ) const
+{
+    return column == 0 || column == nmbOfColumns - 1 ||
+           row == 0 || row == nmbOfRows - 1;
+}
+
+
+inline G4double  CexmcCalorimeterGridTables::GetCrystalCenterX(
+                                                        G4int  column ) const
+{
+    return crystalCenterX[ column ];
+}
+
+
+inline G4double  CexmcCalorimeterGridTables::GetCrystalCenterY(
+                                                        G4int  row ) const
+{
+    return crystalCenterY[ row ];
+}
+
+
+#endif
+
@@ -35,6 +35,11 @@ class  CexmcChargeExchangeReconstructor : public CexmcReconstructor
         CexmcChargeExchangeReconstructor(
                                 const CexmcProductionModel *  productionModel );
 
+        /* the copy has the same settings and no messenger (used by replay
+         * workers) */
+        CexmcChargeExchangeReconstructor(
+                const CexmcChargeExchangeReconstructor &  reconstructor );
+
         ~CexmcChargeExchangeReconstructor();
 
     public:
@@ -0,0 +1,66 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcCheckpointSObject.hh
+ *
+ *    Description:  checkpoint data serialization helper
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 14:02:51
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_CHECKPOINT_SOBJECT_HH
+#define CEXMC_CHECKPOINT_SOBJECT_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <string>
+#include <boost/serialization/string.hpp>
+#include <G4Types.hh>
+#include "CexmcEventsWriter.hh"
+
+
+/* saved in <project>.cpt file along with counters of the current run */
+struct  CexmcCheckpointSObject
+{
+    G4int                   runId;
+
+    G4int                   numberOfEventsToBeProcessed;
+
+    G4int                   numberOfEventsProcessed;
+
+    G4int                   numberOfEventsProcessedEffective;
+
+    /* state of the random engine and cached data of distributions */
+    std::string             rndmStatus;
+
+    CexmcEventsWriterState  eventsWriterState;
+
+    template  < typename  Archive >
+    void  serialize( Archive &  archive, const unsigned int  version );
+};
+
+
+template  < typename  Archive >
+void  CexmcCheckpointSObject::serialize( Archive &  archive,
+                                         const unsigned int )
+{
+    archive & runId;
+    archive & numberOfEventsToBeProcessed;
+    archive & numberOfEventsProcessed;
+    archive & numberOfEventsProcessedEffective;
+    archive & rndmStatus;
+    archive & eventsWriterState;
+}
+
+#endif
+
+#endif
+
@@ -0,0 +1,200 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcColumnarEventsStore.hh
+ *
+ *    Description:  events data in fixed-width column blocks (.cdb file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 16:03:27
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_COLUMNAR_EVENTS_STORE_HH
+#define CEXMC_COLUMNAR_EVENTS_STORE_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <G4String.hh>
+#include <G4Types.hh>
+
+struct  CexmcEventSObject;
+
+
+/* The file consists of a header and blocks of equal size. Each block holds
+ * blockSize events, values of a column for all events in the block are
+ * stored contiguously. A column may have several values per event (e.g. a
+ * calorimeter matrix), the number of values is called column width. Double
+ * columns go first in a block, then go int columns. The last block contains
+ * the actual number of events in its header. Files are written sequentially
+ * and read via mmap() */
+class  CexmcColumnarEventsStore
+{
+    public:
+        enum  DoubleColumn
+        {
+            MonitorED,
+            VetoCounterEDLeft,
+            VetoCounterEDRight,
+            CalorimeterEDLeft,
+            CalorimeterEDRight,
+            CalorimeterEDLeftCollection,
+            CalorimeterEDRightCollection,
+            /* positions, directions and momentum of all ten track points */
+            TrackPoints,
+            /* all eight lorentz vectors */
+            ProductionModelData,
+            NmbOfDoubleColumns
+        };
+
+        enum  IntColumn
+        {
+            EventId,
+            EDDigitizerMonitorHasTriggered,
+            /* PDG encodings, track ids and track types */
+            TrackPointsIds,
+            ProductionModelParticles,
+            NmbOfIntColumns
+        };
+
+    public:
+        /* opens file for reading */
+        explicit CexmcColumnarEventsStore( const G4String &  fileName );
+
+        /* opens file for writing */
+        CexmcColumnarEventsStore( const G4String &  fileName,
+                                  G4int  blockSize );
+
+        /* opens file for writing after nmbOfEventsToKeep events written in
+         * it, the rest of the file is discarded */
+        CexmcColumnarEventsStore( const G4String &  fileName,
+                                  G4int  blockSize, G4int  nmbOfEventsToKeep );
+
+        ~CexmcColumnarEventsStore();
+
+    public:
+        void  Write( const CexmcEventSObject &  evSObject );
+
+        /* writes the last incomplete block, called from the destructor too */
+        void  Flush( void );
+
+        void  Read( G4int  index, CexmcEventSObject &  evSObject ) const;
+
+    public:
+        G4int  GetNmbOfEvents( void ) const;
+
+        G4int  GetBlockSize( void ) const;
+
+        G4int  GetNmbOfBlocks( void ) const;
+
+        G4int  GetNmbOfEventsInBlock( G4int  block ) const;
+
+        G4int  GetWidth( DoubleColumn  column ) const;
+
+        G4int  GetWidth( IntColumn  column ) const;
+
+        /* direct access to columns of a mapped file, value of event i in a
+         * block is at index i * GetWidth( column ) */
+        const G4double *        GetColumn( G4int  block,
+                                           DoubleColumn  column ) const;
+
+        const boost::int32_t *  GetColumn( G4int  block,
+                                           IntColumn  column ) const;
+
+    private:
+        void  SetupLayout( G4int  nmbOfRows_, G4int  nmbOfColumns_ );
+
+        void  WriteHeader( void );
+
+        G4double *        GetColumn( char *  block, DoubleColumn  column );
+
+        boost::int32_t *  GetColumn( char *  block, IntColumn  column );
+
+    private:
+        G4bool              forWriting;
+
+        G4int               blockSize;
+
+        G4int               nmbOfRows;
+
+        G4int               nmbOfColumns;
+
+        G4int               nmbOfEvents;
+
+        std::size_t         blockBytes;
+
+        std::size_t         doubleColumnOffset[ NmbOfDoubleColumns ];
+
+        std::size_t         intColumnOffset[ NmbOfIntColumns ];
+
+        G4int               doubleColumnWidth[ NmbOfDoubleColumns ];
+
+        G4int               intColumnWidth[ NmbOfIntColumns ];
+
+    private:
+        std::fstream        file;
+
+        std::vector< char > block;
+
+        G4bool              headerIsWritten;
+
+    private:
+        int                 fd;
+
+        const char *        data;
+
+        std::size_t         dataSize;
+
+    private:
+        static const char            magic[];
+
+        static const boost::int32_t  version;
+
+        static const std::size_t     headerSize;
+
+        static const std::size_t     blockHeaderSize;
+};
+
+
+inline G4int  CexmcColumnarEventsStore::GetNmbOfEvents( void ) const
+{
+    return nmbOfEvents;
+}
+
+
+inline G4int  CexmcColumnarEventsStore::GetBlockSize( void ) const
+{
+    return blockSize;
+}
+
+
+inline G4int  CexmcColumnarEventsStore::GetNmbOfBlocks( void ) const
+{
+    return ( nmbOfEvents + blockSize - 1 ) / blockSize;
+}
+
+
+inline G4int  CexmcColumnarEventsStore::GetWidth( DoubleColumn  column ) const
+{
+    return doubleColumnWidth[ column ];
+}
+
+
+inline G4int  CexmcColumnarEventsStore::GetWidth( IntColumn  column ) const
+{
+    return intColumnWidth[ column ];
+}
+
+#endif
+
+#endif
+
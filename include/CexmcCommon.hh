@@ -23,16 +23,11 @@
 #include <limits>
 #include <G4String.hh>
 #include <G4Types.hh>
+#include "CexmcEnergyDepositCalorimeterCollection.hh"
 
 #define CEXMC_LINE_START  "--- Cexmc ---  "
 
 
-typedef std::vector< G4double >  CexmcEnergyDepositCrystalRowCollection;
-
-typedef std::vector< CexmcEnergyDepositCrystalRowCollection >
-                                 CexmcEnergyDepositCalorimeterCollection;
-
-
 const G4double  CexmcDblMax( std::numeric_limits< double >::max() );
 
 const G4String  CexmcStudiedProcessFirstName( "studiedProcess_" );
@@ -164,6 +159,20 @@ enum  CexmcEventDataVerboseLevel
 };
 
 
+enum  CexmcEventDataFormat
+{
+    CexmcBoostArchiveEventDataFormat,
+    CexmcColumnarEventDataFormat
+};
+
+
+enum  CexmcEventDataCodec
+{
+    CexmcNoEventDataCodec,
+    CexmcLZEventDataCodec
+};
+
+
 enum  CexmcOutputDataType
 {
     CexmcOutputRun,
@@ -0,0 +1,156 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcCompressedStreambuf.hh
+ *
+ *    Description:  stream buffers for block-compressed events data files
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 18:47:13
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_COMPRESSED_STREAMBUF_HH
+#define CEXMC_COMPRESSED_STREAMBUF_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <vector>
+#include <streambuf>
+#include <boost/cstdint.hpp>
+#include <G4Types.hh>
+#include "CexmcCommon.hh"
+
+class  CexmcBlockCodec;
+
+
+/* A compressed file consists of a header (magic, version, codec and block
+ * size) and blocks. Each block is preceded by its uncompressed and stored
+ * sizes, a block is stored uncompressed if compression does not make it
+ * smaller. All blocks but the last one contain exactly blockSize bytes of
+ * uncompressed data, therefore a block can be found by an uncompressed
+ * position (as returned by tellp() while writing) and decompressed
+ * independently of others */
+class  CexmcCompressedOutputStreambuf : public std::streambuf
+{
+    public:
+        CexmcCompressedOutputStreambuf( std::streambuf *  sink,
+                                        CexmcEventDataCodec  codecType,
+                                        std::size_t  blockSize = 1 << 18 );
+
+        /* continues writing of a compressed file after storedSize bytes
+         * written in it: the sink must be positioned at storedSize, no header
+         * is written, blockStart is uncompressed position of the next block */
+        CexmcCompressedOutputStreambuf( std::streambuf *  sink,
+                                        CexmcEventDataCodec  codecType,
+                                        boost::int64_t  blockStart,
+                                        boost::int64_t  storedSize,
+                                        std::size_t  blockSize = 1 << 18 );
+
+        ~CexmcCompressedOutputStreambuf();
+
+    public:
+        /* writes the last incomplete block */
+        void  Close( void );
+
+        /* data of the incomplete block which was not written yet */
+        void  GetPendingData( std::vector< char > &  data ) const;
+
+    public:
+        boost::int64_t  GetBlockStart( void ) const;
+
+        boost::int64_t  GetStoredSize( void ) const;
+
+    protected:
+        int_type  overflow( int_type  c );
+
+        int       sync( void );
+
+        pos_type  seekoff( off_type  off, std::ios_base::seekdir  dir,
+                           std::ios_base::openmode  which );
+
+        pos_type  seekpos( pos_type  pos, std::ios_base::openmode  which );
+
+    private:
+        void      WriteBlock( void );
+
+    private:
+        std::streambuf *     sink;
+
+        CexmcBlockCodec *    codec;
+
+        std::vector< char >  buffer;
+
+        std::vector< char >  compressed;
+
+        boost::int64_t       blockStart;
+
+        boost::int64_t       storedSize;
+
+        G4bool               isClosed;
+};
+
+
+inline boost::int64_t  CexmcCompressedOutputStreambuf::GetBlockStart( void )
+                                                                        const
+{
+    return blockStart;
+}
+
+
+inline boost::int64_t  CexmcCompressedOutputStreambuf::GetStoredSize( void )
+                                                                        const
+{
+    return storedSize;
+}
+
+
+class  CexmcCompressedInputStreambuf : public std::streambuf
+{
+    public:
+        CexmcCompressedInputStreambuf( std::streambuf *  source,
+                                       CexmcEventDataCodec  codecType );
+
+        ~CexmcCompressedInputStreambuf();
+
+    protected:
+        int_type  underflow( void );
+
+        pos_type  seekoff( off_type  off, std::ios_base::seekdir  dir,
+                           std::ios_base::openmode  which );
+
+        pos_type  seekpos( pos_type  pos, std::ios_base::openmode  which );
+
+    private:
+        G4bool    ReadBlock( void );
+
+        void      BuildBlocksTable( void );
+
+    private:
+        std::streambuf *              source;
+
+        CexmcBlockCodec *             codec;
+
+        std::size_t                   blockSize;
+
+        std::vector< char >           buffer;
+
+        std::vector< char >           compressed;
+
+        boost::int64_t                blockStart;
+
+        std::vector< std::streamoff > blocksTable;
+
+        G4bool                        blocksTableIsBuilt;
+};
+
+#endif
+
+#endif
+
@@ -0,0 +1,113 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcCrystalResolutionTable.hh
+ *
+ *    Description:  lookup of crystal resolution by energy deposit
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 22:31:56
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_CRYSTAL_RESOLUTION_TABLE_HH
+#define CEXMC_CRYSTAL_RESOLUTION_TABLE_HH
+
+#include <vector>
+#include <algorithm>
+#include "CexmcSimpleRangeWithValue.hh"
+
+
+/* crystal resolution ranges compiled into sorted boundaries of elementary
+ * intervals: every interval refers to the first range in the original list
+ * which contains it, so lookup results are the same as of a linear scan of
+ * the list for the first range with bottom <= value < top */
+class  CexmcCrystalResolutionTable
+{
+    public:
+        void    Build( const CexmcEnergyRangeWithDoubleValueList &  data );
+
+        /* returns false if the value is not in any range */
+        G4bool  Find( G4double  value, G4double &  resolution ) const;
+
+    private:
+        std::vector< G4double >  boundaries;
+
+        /* resolution in interval [ boundaries[ i ], boundaries[ i + 1 ] ) */
+        std::vector< G4double >  resolutions;
+
+        /* whether interval i is in any range */
+        std::vector< G4bool >    inRange;
+};
+
+
+inline void  CexmcCrystalResolutionTable::Build(
+                            const CexmcEnergyRangeWithDoubleValueList &  data )
+{
+    boundaries.clear();
+    resolutions.clear();
+    inRange.clear();
+
+    for ( CexmcEnergyRangeWithDoubleValueList::const_iterator
+              k( data.begin() ); k != data.end(); ++k )
+    {
+        if ( k->bottom >= k->top )
+            continue;
+        boundaries.push_back( k->bottom );
+        boundaries.push_back( k->top );
+    }
+
+    std::sort( boundaries.begin(), boundaries.end() );
+    boundaries.erase( std::unique( boundaries.begin(), boundaries.end() ),
+                      boundaries.end() );
+
+    if ( boundaries.empty() )
+        return;
+
+    resolutions.resize( boundaries.size() - 1, 0. );
+    inRange.resize( boundaries.size() - 1, false );
+
+    for ( std::vector< G4double >::size_type  i( 0 );
+                                            i < resolutions.size(); ++i )
+    {
+        for ( CexmcEnergyRangeWithDoubleValueList::const_iterator
+                  k( data.begin() ); k != data.end(); ++k )
+        {
+            if ( boundaries[ i ] < k->bottom || boundaries[ i ] >= k->top )
+                continue;
+            resolutions[ i ] = k->value;
+            inRange[ i ] = true;
+            break;
+        }
+    }
+}
+
+
+inline G4bool  CexmcCrystalResolutionTable::Find( G4double  value,
+                                                G4double &  resolution ) const
+{
+    std::vector< G4double >::const_iterator  k( std::upper_bound(
+                            boundaries.begin(), boundaries.end(), value ) );
+
+    if ( k == boundaries.begin() || k == boundaries.end() )
+        return false;
+
+    std::vector< G4double >::size_type  i( k - boundaries.begin() - 1 );
+
+    if ( ! inRange[ i ] )
+        return false;
+
+    resolution = resolutions[ i ];
+
+    return true;
+}
+
+
+#endif
+
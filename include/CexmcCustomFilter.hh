@@ -55,7 +55,7 @@ namespace  CexmcCustomFilter
 
     struct  ParseResult
     {
-        ParseResult() : action( KeepTPT )
+        ParseResult() : action( KeepTPT ), sourceLine( 0 )
         {}
 
         void  Initialize( void )
@@ -68,6 +68,9 @@ namespace  CexmcCustomFilter
         Action   action;
 
         Subtree  expression;
+
+        /* line of the source file where the statement starts */
+        int      sourceLine;
     };
 
 
@@ -93,6 +96,9 @@ namespace  CexmcCustomFilter
         void  operator()( Node &  self, Node &  child, std::string &  value )
                                                                         const;
 
+        void  operator()( Node &  self, Node &  child1, Node &  child2,
+                          std::string &  value ) const;
+
         void  operator()( Leaf &  self, std::string &  name ) const;
 
         void  operator()( Leaf &  self, int  value, size_t  index ) const;
@@ -116,6 +122,8 @@ namespace  CexmcCustomFilter
 
         rule< Iterator, Node(), space_type >                   function1;
 
+        rule< Iterator, Node(), space_type >                   function2;
+
         rule< Iterator, std::string(), space_type >            identifier;
 
         rule< Iterator, Leaf(), space_type >                   leaf_operand;
@@ -169,7 +177,7 @@ namespace  CexmcCustomFilter
 
         identifier %= raw[ lexeme[ alpha >> *( alnum | '_' ) ] ];
 
-        primary_expr = function1[ _val = _1 ] |
+        primary_expr = function1[ _val = _1 ] | function2[ _val = _1 ] |
                 lit( '(' ) >> expression[ op( _val, _1 ) ] >> lit( ')' ) |
                 leaf_operand[ _val = _1 ];
 
@@ -185,6 +193,9 @@ namespace  CexmcCustomFilter
         function1 = ( identifier >> lit( '(' ) >> expression >> lit( ')' ) )
                     [ op( _val, _2, _1 ) ];
 
+        function2 = ( identifier >> lit( '(' ) >> expression >> lit( ',' ) >>
+                      expression >> lit( ')' ) )[ op( _val, _2, _3, _1 ) ];
+
         or_expr = ( and_expr >> lit( '|' ) >> or_expr )
                   [ op( _val, _1, _2, Operator( Or, 1 ) ) ] |
                   and_expr[ _val = _1 ];
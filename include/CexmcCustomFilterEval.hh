@@ -24,10 +24,11 @@
 #include <vector>
 #include <string>
 #include "CexmcASTEval.hh"
+#include "CexmcASTProgram.hh"
 #include "CexmcCustomFilter.hh"
-
-class  CexmcEventFastSObject;
-class  CexmcEventSObject;
+#include "CexmcEventFastSObject.hh"
+#include "CexmcEventSObject.hh"
+#include "CexmcStageProfiler.hh"
 
 
 class  CexmcCustomFilterEval
@@ -36,19 +37,108 @@ class  CexmcCustomFilterEval
         typedef std::vector< CexmcCustomFilter::ParseResult >
                                                         ParseResultVector;
 
+        typedef std::vector< CexmcASTProgram >          ProgramVector;
+
+#ifdef CEXMC_USE_PROFILER
+        struct  ExpressionProfile
+        {
+            G4int     nmbOfEvaluations;
+
+            G4int     nmbOfMatches;
+
+            G4double  time;
+        };
+
+        typedef std::vector< ExpressionProfile >        ProfileVector;
+
+        /* measures an evaluation of an expression until it goes out of
+         * scope, so that evaluations which throw are measured as well */
+        class  ExpressionProfileGuard
+        {
+            public:
+                explicit ExpressionProfileGuard(
+                                            ExpressionProfile &  profile_ );
+
+                ~ExpressionProfileGuard();
+
+            public:
+                void  SetMatched( void );
+
+            private:
+                ExpressionProfile &  profile;
+
+                G4double             start;
+        };
+#endif
+
     public:
         explicit CexmcCustomFilterEval( const G4String &  sourceFileName,
                             const CexmcEventFastSObject *  evFastSObject = NULL,
                             const CexmcEventSObject *  evSObject = NULL );
 
     public:
-        void  SetAddressedData( const CexmcEventFastSObject *  evFastSObject,
-                                const CexmcEventSObject *  evSObject );
+        void  SetAddressedData( const CexmcEventFastSObject *  evFastSObject_,
+                                const CexmcEventSObject *  evSObject_ );
+
+        /* must be called every time the addressed data get a new record:
+         * values of common subexpressions are cached until then */
+        void  InvalidateCache( void ) const;
 
         bool  EvalTPT( void ) const;
 
         bool  EvalEDT( void ) const;
 
+        /* evaluates leading TPT expressions which do not need events data,
+         * returns false if evFastSObject_ is certainly rejected by the TPT
+         * expressions; does not depend on the addressed data and may be
+         * called from another thread concurrently with EvalTPT() and
+         * EvalEDT() but not with itself */
+        bool  EvalFastTPT( const CexmcEventFastSObject &  evFastSObject_ )
+                                                                        const;
+
+        /* the same for count records which start at first and follow each
+         * other with stride (e.g. fields of an array of structures), results
+         * are put into result; every expression is evaluated for the whole
+         * block at once if possible */
+        void  EvalFastTPT( const CexmcEventFastSObject *  first,
+                           size_t  stride, G4int  count,
+                           std::vector< unsigned char > &  result ) const;
+
+        bool  HasFastTPT( void ) const;
+
+#ifdef CEXMC_USE_PROFILER
+        /* if profiling is enabled then EvalTPT() and EvalEDT() count how
+         * many times every expression was evaluated and matched (i.e.
+         * decided the outcome) and measure time spent in it */
+        void  EnableProfiling( G4bool  on = true );
+
+        void  ResetProfile( void );
+
+        /* prints the counters keyed by source lines of the expressions */
+        void  PrintProfile( void ) const;
+
+        G4bool  IsProfiled( void ) const;
+#endif
+
+    private:
+        void  Compile( void );
+
+        void  CompileFastTPT( void );
+
+        /* tells user which TPT expressions are evaluated before events data
+         * are decoded and whether they are evaluated in blocks */
+        void  PrintFastTPTInfo( const G4String &  sourceFileName ) const;
+
+        bool  RunProgram( const ProgramVector &  programs,
+                          ProgramVector::size_type  index, bool  isTPT )
+                                                                        const;
+
+#ifdef CEXMC_USE_PROFILER
+        void  PrintProfile( const ParseResultVector &  parseResult,
+                            const ProfileVector &  profile,
+                            G4int  nmbOfNotMatched ) const;
+#endif
+
     private:
         CexmcASTEval       astEval;
 
@@ -56,9 +146,122 @@ class  CexmcCustomFilterEval
 
         ParseResultVector  parseResultEDT;
 
+        /* compiled expressions from parseResultTPT and parseResultEDT */
+        ProgramVector      programsTPT;
+
+        ProgramVector      programsEDT;
+
+        /* values of subexpressions which are shared between programs */
+        mutable CexmcASTProgram::Cache  cache;
+
+        /* copies of leading TPT expressions which do not need events data,
+         * they are bound to fastRecord and compiled only once */
+        ParseResultVector  parseResultFastTPT;
+
+        ProgramVector      programsFastTPT;
+
+        mutable CexmcEventFastSObject   fastRecord;
+
+        /* all fast expressions can be evaluated in blocks */
+        G4bool                          fastTPTCanRunBatch;
+
+        mutable std::vector< unsigned char >  fastTPTMatched;
+
+        mutable std::vector< unsigned char >  fastTPTDecided;
+
+        /* never referred to by the fast expressions */
+        CexmcEventSObject               noEventData;
+
+        CexmcASTEval       fastAstEval;
+
         CexmcCustomFilter::Grammar< std::string::const_iterator >  grammar;
+
+#ifdef CEXMC_USE_PROFILER
+        G4String           sourceFileName;
+
+        G4bool             isProfiled;
+
+        mutable ProfileVector  profileTPT;
+
+        mutable ProfileVector  profileEDT;
+
+        /* events which were not matched by any expression */
+        mutable G4int      nmbOfNotMatchedTPT;
+
+        mutable G4int      nmbOfNotMatchedEDT;
+#endif
 };
 
+
+
+inline void  CexmcCustomFilterEval::InvalidateCache( void ) const
+{
+    cache.Invalidate();
+}
+
+
+#ifdef CEXMC_USE_PROFILER
+
+inline CexmcCustomFilterEval::ExpressionProfileGuard::ExpressionProfileGuard(
+                                        ExpressionProfile &  profile_ ) :
+    profile( profile_ ), start( CexmcStageProfiler::GetTime() )
+{
+}
+
+
+inline CexmcCustomFilterEval::ExpressionProfileGuard::~ExpressionProfileGuard()
+{
+    profile.time += CexmcStageProfiler::GetTime() - start;
+    ++profile.nmbOfEvaluations;
+}
+
+
+inline void  CexmcCustomFilterEval::ExpressionProfileGuard::SetMatched( void )
+{
+    ++profile.nmbOfMatches;
+}
+
+#endif
+
+
+inline bool  CexmcCustomFilterEval::HasFastTPT( void ) const
+{
+    return ! programsFastTPT.empty();
+}
+
+
+inline bool  CexmcCustomFilterEval::RunProgram(
+                                    const ProgramVector &  programs,
+                                    ProgramVector::size_type  index,
+                                    bool  isTPT ) const
+{
+#ifdef CEXMC_USE_PROFILER
+    if ( isProfiled )
+    {
+        ExpressionProfileGuard  guard( isTPT ? profileTPT[ index ] :
+                                               profileEDT[ index ] );
+        bool                    result( programs[ index ].Run() );
+
+        if ( result )
+            guard.SetMatched();
+
+        return result;
+    }
+#endif
+
+    return programs[ index ].Run();
+}
+
+
+#ifdef CEXMC_USE_PROFILER
+
+inline G4bool  CexmcCustomFilterEval::IsProfiled( void ) const
+{
+    return isProfiled;
+}
+
+#endif
+
 #endif
 
 #endif
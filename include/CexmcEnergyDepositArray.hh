@@ -0,0 +1,190 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEnergyDepositArray.hh
+ *
+ *    Description:  energy deposit in calorimeter crystals as a flat array
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 19:04:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_ENERGY_DEPOSIT_ARRAY_HH
+#define CEXMC_ENERGY_DEPOSIT_ARRAY_HH
+
+#include <vector>
+#include <algorithm>
+#include <G4VHitsCollection.hh>
+#include "CexmcCommon.hh"
+
+
+/* energy deposits of crystals of both calorimeters in a preallocated array
+ * indexed by side, row and column: the array is reset in place on every
+ * event, no allocations happen when crystals get hit */
+class  CexmcEnergyDepositArray
+{
+    public:
+        explicit CexmcEnergyDepositArray( G4int  nmbOfRows = 0,
+                                          G4int  nmbOfColumns = 0 );
+
+    public:
+        void      Resize( G4int  nmbOfRows_, G4int  nmbOfColumns_ );
+
+        void      Reset( void );
+
+        void      Add( CexmcSide  side, G4int  row, G4int  column,
+                       G4double  value );
+
+    public:
+        G4double  Get( CexmcSide  side, G4int  row, G4int  column ) const;
+
+        /* returns nmbOfRows x nmbOfColumns values of the side in row-major
+         * order */
+        const G4double *  GetData( CexmcSide  side ) const;
+
+        G4int     GetNmbOfRows( void ) const;
+
+        G4int     GetNmbOfColumns( void ) const;
+
+        /* number of crystals with non-zero energy deposit */
+        G4int     GetNmbOfEntries( void ) const;
+
+    private:
+        G4int     GetOffset( CexmcSide  side, G4int  row, G4int  column ) const;
+
+    private:
+        std::vector< G4double >  values;
+
+        G4int                    nmbOfRows;
+
+        G4int                    nmbOfColumns;
+
+        G4int                    nmbOfEntries;
+};
+
+
+inline CexmcEnergyDepositArray::CexmcEnergyDepositArray( G4int  nmbOfRows,
+                                                         G4int  nmbOfColumns ) :
+    nmbOfRows( 0 ), nmbOfColumns( 0 ), nmbOfEntries( 0 )
+{
+    Resize( nmbOfRows, nmbOfColumns );
+}
+
+
+inline void  CexmcEnergyDepositArray::Resize( G4int  nmbOfRows_,
+                                              G4int  nmbOfColumns_ )
+{
+    nmbOfRows = nmbOfRows_ > 0 ? nmbOfRows_ : 0;
+    nmbOfColumns = nmbOfColumns_ > 0 ? nmbOfColumns_ : 0;
+    values.assign( 2 * nmbOfRows * nmbOfColumns, 0. );
+    nmbOfEntries = 0;
+}
+
+
+inline void  CexmcEnergyDepositArray::Reset( void )
+{
+    if ( nmbOfEntries == 0 )
+        return;
+
+    std::fill( values.begin(), values.end(), 0. );
+    nmbOfEntries = 0;
+}
+
+
+inline G4int  CexmcEnergyDepositArray::GetOffset( CexmcSide  side,
+                                            G4int  row, G4int  column ) const
+{
+    return ( side * nmbOfRows + row ) * nmbOfColumns + column;
+}
+
+
+inline void  CexmcEnergyDepositArray::Add( CexmcSide  side, G4int  row,
+                                           G4int  column, G4double  value )
+{
+    G4double &  cell( values[ GetOffset( side, row, column ) ] );
+
+    if ( cell == 0. && value != 0. )
+        ++nmbOfEntries;
+
+    cell += value;
+}
+
+
+inline G4double  CexmcEnergyDepositArray::Get( CexmcSide  side, G4int  row,
+                                               G4int  column ) const
+{
+    return values[ GetOffset( side, row, column ) ];
+}
+
+
+inline const G4double *  CexmcEnergyDepositArray::GetData(
+                                                    CexmcSide  side ) const
+{
+    if ( values.empty() )
+        return NULL;
+
+    return &values[ GetOffset( side, 0, 0 ) ];
+}
+
+
+inline G4int  CexmcEnergyDepositArray::GetNmbOfRows( void ) const
+{
+    return nmbOfRows;
+}
+
+
+inline G4int  CexmcEnergyDepositArray::GetNmbOfColumns( void ) const
+{
+    return nmbOfColumns;
+}
+
+
+inline G4int  CexmcEnergyDepositArray::GetNmbOfEntries( void ) const
+{
+    return nmbOfEntries;
+}
+
+
+/* hits collection which refers to an array owned by the scorer: G4HCofThisEvent
+ * deletes its collections at the end of every event, so only this light
+ * handle is allocated per event while the array itself is reused */
+class  CexmcEnergyDepositArrayCollection : public G4VHitsCollection
+{
+    public:
+        CexmcEnergyDepositArrayCollection( const G4String &  detectorName,
+                                           const G4String &  collectionName,
+                                           CexmcEnergyDepositArray *  array );
+
+    public:
+        CexmcEnergyDepositArray *  GetArray( void ) const;
+
+    private:
+        CexmcEnergyDepositArray *  array;
+};
+
+
+inline CexmcEnergyDepositArrayCollection::CexmcEnergyDepositArrayCollection(
+                                        const G4String &  detectorName,
+                                        const G4String &  collectionName,
+                                        CexmcEnergyDepositArray *  array ) :
+    G4VHitsCollection( detectorName, collectionName ), array( array )
+{
+}
+
+
+inline CexmcEnergyDepositArray *  CexmcEnergyDepositArrayCollection::GetArray(
+                                                                void ) const
+{
+    return array;
+}
+
+
+#endif
+
@@ -0,0 +1,199 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEnergyDepositCalorimeterCollection.hh
+ *
+ *    Description:  energy deposit in calorimeter crystals (row-major grid)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 20:11:26
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_ENERGY_DEPOSIT_CALORIMETER_COLLECTION_HH
+#define CEXMC_ENERGY_DEPOSIT_CALORIMETER_COLLECTION_HH
+
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <G4Types.hh>
+
+
+/* layout of calorimeter energy deposit collections in projects written
+ * before the grid was introduced */
+typedef std::vector< std::vector< G4double > >
+                                    CexmcEnergyDepositCalorimeterRowsCollection;
+
+
+/* energy deposit of calorimeter crystals stored contiguously row by row:
+ * element (row, column) is accessed as collection[ row ][ column ] */
+class  CexmcEnergyDepositCalorimeterCollection
+{
+    public:
+        explicit CexmcEnergyDepositCalorimeterCollection(
+                                G4int  nmbOfRows = 0, G4int  nmbOfColumns = 0 );
+
+    public:
+        /* sets new dimensions, all elements become zero; the collection
+         * becomes empty if any of the dimensions is not positive */
+        void              Resize( G4int  nmbOfRows_, G4int  nmbOfColumns_ );
+
+        /* sets all elements to zero keeping the dimensions */
+        void              Reset( void );
+
+        void              Assign(
+                    const CexmcEnergyDepositCalorimeterRowsCollection &  rows );
+
+        /* exchanges contents with other collection without copying */
+        void              Swap(
+                    CexmcEnergyDepositCalorimeterCollection &  other );
+
+    public:
+        G4double *        operator[]( G4int  row );
+
+        const G4double *  operator[]( G4int  row ) const;
+
+        /* throws std::out_of_range if there is no such element */
+        G4double          At( G4int  row, G4int  column ) const;
+
+        G4double *        GetData( void );
+
+        const G4double *  GetData( void ) const;
+
+        G4int             GetNmbOfRows( void ) const;
+
+        G4int             GetNmbOfColumns( void ) const;
+
+        /* number of elements */
+        G4int             GetSize( void ) const;
+
+        G4bool            IsEmpty( void ) const;
+
+    private:
+        std::vector< G4double >  values;
+
+        G4int                    nmbOfRows;
+
+        G4int                    nmbOfColumns;
+};
+
+
+inline CexmcEnergyDepositCalorimeterCollection::
+                            CexmcEnergyDepositCalorimeterCollection(
+                                    G4int  nmbOfRows, G4int  nmbOfColumns ) :
+    nmbOfRows( 0 ), nmbOfColumns( 0 )
+{
+    Resize( nmbOfRows, nmbOfColumns );
+}
+
+
+inline void  CexmcEnergyDepositCalorimeterCollection::Resize(
+                                G4int  nmbOfRows_, G4int  nmbOfColumns_ )
+{
+    nmbOfRows = nmbOfRows_ > 0 && nmbOfColumns_ > 0 ? nmbOfRows_ : 0;
+    nmbOfColumns = nmbOfRows > 0 ? nmbOfColumns_ : 0;
+    values.assign( nmbOfRows * nmbOfColumns, 0. );
+}
+
+
+inline void  CexmcEnergyDepositCalorimeterCollection::Reset( void )
+{
+    std::fill( values.begin(), values.end(), 0. );
+}
+
+
+inline void  CexmcEnergyDepositCalorimeterCollection::Assign(
+                    const CexmcEnergyDepositCalorimeterRowsCollection &  rows )
+{
+    Resize( rows.size(), rows.empty() ? 0 : rows[ 0 ].size() );
+
+    for ( G4int  i( 0 ); i < nmbOfRows; ++i )
+    {
+        G4int  size( std::min( G4int( rows[ i ].size() ), nmbOfColumns ) );
+
+        std::copy( rows[ i ].begin(), rows[ i ].begin() + size,
+                   values.begin() + i * nmbOfColumns );
+    }
+}
+
+
+inline void  CexmcEnergyDepositCalorimeterCollection::Swap(
+                            CexmcEnergyDepositCalorimeterCollection &  other )
+{
+    values.swap( other.values );
+    std::swap( nmbOfRows, other.nmbOfRows );
+    std::swap( nmbOfColumns, other.nmbOfColumns );
+}
+
+
+inline G4double *  CexmcEnergyDepositCalorimeterCollection::operator[](
+                                                                G4int  row )
+{
+    return &values[ row * nmbOfColumns ];
+}
+
+
+inline const G4double *  CexmcEnergyDepositCalorimeterCollection::operator[](
+                                                            G4int  row ) const
+{
+    return &values[ row * nmbOfColumns ];
+}
+
+
+inline G4double  CexmcEnergyDepositCalorimeterCollection::At( G4int  row,
+                                                    G4int  column ) const
+{
+    if ( row < 0 || row >= nmbOfRows || column < 0 || column >= nmbOfColumns )
+        throw std::out_of_range( "calorimeter collection index" );
+
+    return values[ row * nmbOfColumns + column ];
+}
+
+
+inline G4double *  CexmcEnergyDepositCalorimeterCollection::GetData( void )
+{
+    return values.empty() ? NULL : &values[ 0 ];
+}
+
+
+inline const G4double *  CexmcEnergyDepositCalorimeterCollection::GetData(
+                                                                void ) const
+{
+    return values.empty() ? NULL : &values[ 0 ];
+}
+
+
+inline G4int  CexmcEnergyDepositCalorimeterCollection::GetNmbOfRows( void )
+                                                                        const
+{
+    return nmbOfRows;
+}
+
+
+inline G4int  CexmcEnergyDepositCalorimeterCollection::GetNmbOfColumns( void )
+                                                                        const
+{
+    return nmbOfColumns;
+}
+
+
+inline G4int  CexmcEnergyDepositCalorimeterCollection::GetSize( void ) const
+{
+    return G4int( values.size() );
+}
+
+
+inline G4bool  CexmcEnergyDepositCalorimeterCollection::IsEmpty( void ) const
+{
+    return values.empty();
+}
+
+
+#endif
+
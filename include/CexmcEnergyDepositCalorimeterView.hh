@@ -0,0 +1,134 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEnergyDepositCalorimeterView.hh
+ *
+ *    Description:  non-owning view of calorimeter energy deposit collection
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 23:18:02
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_ENERGY_DEPOSIT_CALORIMETER_VIEW_HH
+#define CEXMC_ENERGY_DEPOSIT_CALORIMETER_VIEW_HH
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include "CexmcCommon.hh"
+
+
+/* view of the collection as transformed by custom filter functions Inner()
+ * and Outer(): the transformations only change the view, the collection is
+ * never copied. Row and column indices returned from the view are counted
+ * from 1 in the original collection, 0 means that the view is empty */
+class  CexmcEnergyDepositCalorimeterView
+{
+    public:
+        explicit CexmcEnergyDepositCalorimeterView(
+                const CexmcEnergyDepositCalorimeterCollection *  collection =
+                                                                    NULL );
+
+    public:
+        void      Reset(
+            const CexmcEnergyDepositCalorimeterCollection *  collection_ );
+
+        /* removes first and last rows and first and last elements of
+         * remaining rows */
+        void      Inner( void );
+
+        /* leaves only first and last elements in rows between first and
+         * last rows */
+        void      Outer( void );
+
+    public:
+        G4double  Sum( void ) const;
+
+        G4double  Max( void ) const;
+
+        G4int     ArgMaxRow( void ) const;
+
+        G4int     ArgMaxColumn( void ) const;
+
+        G4int     Count( G4double  threshold ) const;
+
+    private:
+        G4int     GetNmbOfRows( void ) const;
+
+        /* visible elements of the row are in [begin, end) with the returned
+         * step: middle rows of an outer view have only first and last
+         * elements visible */
+        G4int     GetRowBounds( G4int  row, G4int &  begin, G4int &  end )
+                                                                        const;
+
+        void      FindMax( G4double &  value, G4int &  row, G4int &  column )
+                                                                        const;
+
+    private:
+        const CexmcEnergyDepositCalorimeterCollection *  collection;
+
+        /* number of rows removed from both sides of the collection */
+        G4int                                            rowTrim;
+
+        /* number of elements removed from both sides of each row */
+        G4int                                            columnTrim;
+
+        G4bool                                           isOuter;
+
+        G4bool                                           isEmpty;
+};
+
+
+inline CexmcEnergyDepositCalorimeterView::CexmcEnergyDepositCalorimeterView(
+            const CexmcEnergyDepositCalorimeterCollection *  collection ) :
+    collection( collection ), rowTrim( 0 ), columnTrim( 0 ), isOuter( false ),
+    isEmpty( false )
+{
+}
+
+
+inline void  CexmcEnergyDepositCalorimeterView::Reset(
+            const CexmcEnergyDepositCalorimeterCollection *  collection_ )
+{
+    collection = collection_;
+    rowTrim = 0;
+    columnTrim = 0;
+    isOuter = false;
+    isEmpty = false;
+}
+
+
+inline G4int  CexmcEnergyDepositCalorimeterView::GetNmbOfRows( void ) const
+{
+    if ( ! collection || isEmpty )
+        return 0;
+
+    G4int  nmbOfRows( collection->GetNmbOfRows() - 2 * rowTrim );
+
+    return nmbOfRows > 0 ? nmbOfRows : 0;
+}
+
+
+inline G4int  CexmcEnergyDepositCalorimeterView::GetRowBounds( G4int  row,
+                                        G4int &  begin, G4int &  end ) const
+{
+    begin = columnTrim;
+    end = collection->GetNmbOfColumns() - columnTrim;
+
+    if ( ! isOuter || end - begin < 3 || row == rowTrim ||
+         row == collection->GetNmbOfRows() - rowTrim - 1 )
+        return 1;
+
+    return end - begin - 1;
+}
+
+#endif
+
+#endif
+
@@ -20,14 +20,19 @@
 #define CEXMC_ENERGY_DEPOSIT_DIGITIZER_HH
 
 #include <iosfwd>
+#include <vector>
 #include <G4VDigitizerModule.hh>
 #include <G4SystemOfUnits.hh>
 #include "CexmcEnergyDepositStore.hh"
 #include "CexmcSimpleRangeWithValue.hh"
+#include "CexmcHitsCollectionIds.hh"
+#include "CexmcCalorimeterGridTables.hh"
+#include "CexmcCrystalResolutionTable.hh"
 #include "CexmcException.hh"
 #include "CexmcCommon.hh"
 
 class  G4String;
+class  G4HCofThisEvent;
 class  CexmcEnergyDepositDigitizerMessenger;
 
 
@@ -36,11 +41,20 @@ class  CexmcEnergyDepositDigitizer : public G4VDigitizerModule
     public:
         explicit CexmcEnergyDepositDigitizer( const G4String &  name );
 
+        /* the copy has the same settings, it is not registered in
+         * G4DigiManager and has no messenger (used by replay workers) */
+        CexmcEnergyDepositDigitizer(
+                            const CexmcEnergyDepositDigitizer &  digitizer );
+
         ~CexmcEnergyDepositDigitizer();
 
     public:
         void      Digitize( void );
 
+        /* digitizes hits collections of hcOfThisEvent, the current event is
+         * digitized if hcOfThisEvent is NULL */
+        void      Digitize( G4HCofThisEvent *  hcOfThisEvent );
+
     public:
         G4double  GetMonitorED( void ) const;
 
@@ -143,6 +157,10 @@ class  CexmcEnergyDepositDigitizer : public G4VDigitizerModule
     private:
         void      InitializeData( void );
 
+        /* applies finite crystal resolution to crystals of both
+         * calorimeters */
+        void      SmearCrystalsEnergyDeposit( void );
+
     private:
         G4double                                 monitorED;
 
@@ -208,11 +226,26 @@ class  CexmcEnergyDepositDigitizer : public G4VDigitizerModule
 
         G4int                                    nCrystalsInRow;
 
+        CexmcCalorimeterGridTables               calorimeterGridTables;
+
+        CexmcHitsCollectionIds                   hcIds;
+
     private:
         G4bool                                   applyFiniteCrystalResolution;
 
         CexmcEnergyRangeWithDoubleValueList      crystalResolutionData;
 
+        CexmcCrystalResolutionTable              crystalResolutionTable;
+
+        /* crystals to be smeared in the current event with their
+         * resolutions and gaussian shoots, capacity is reserved for all
+         * crystals */
+        std::vector< G4double * >                smearedCrystals;
+
+        std::vector< G4double >                  smearedCrystalsResolution;
+
+        std::vector< G4double >                  gaussianShoots;
+
     private:
         CexmcEnergyDepositDigitizerMessenger *   messenger;
 };
@@ -455,6 +488,7 @@ inline void  CexmcEnergyDepositDigitizer::AddCrystalResolutionRange(
     /* range boundaries are given in GeV */
     crystalResolutionData.push_back( CexmcEnergyRangeWithDoubleValue(
                                             bottom * GeV, top * GeV, value ) );
+    crystalResolutionTable.Build( crystalResolutionData );
 }
 
 
@@ -465,6 +499,7 @@ inline void  CexmcEnergyDepositDigitizer::ClearCrystalResolutionData(
         ThrowExceptionIfProjectIsRead( CexmcCmdIsNotAllowed );
 
     crystalResolutionData.clear();
+    crystalResolutionTable.Build( crystalResolutionData );
 }
 
 
@@ -473,6 +508,7 @@ inline void  CexmcEnergyDepositDigitizer::SetCrystalResolutionData(
 {
     ClearCrystalResolutionData( false );
     crystalResolutionData = data;
+    crystalResolutionTable.Build( crystalResolutionData );
 }
 
 
@@ -20,6 +20,7 @@
 #define CEXMC_ENERGY_DEPOSIT_IN_CALORIMETER_HH
 
 #include "CexmcEnergyDepositInLeftRightSet.hh"
+#include "CexmcEnergyDepositArray.hh"
 
 class  CexmcSetup;
 
@@ -31,42 +32,20 @@ class  CexmcEnergyDepositInCalorimeter : public CexmcEnergyDepositInLeftRightSet
                                          const CexmcSetup *  setup );
 
     public:
-        void   PrintAll( void );
+        void    Initialize( G4HCofThisEvent *  hcOfThisEvent );
 
-    protected:
-        G4int  GetIndex( G4Step *  step );
-
-    public:
-        static G4int  GetRow( G4int  index );
-
-        static G4int  GetColumn( G4int  index );
+        void    PrintAll( void );
 
-        static G4int  GetCopyDepth1BitsOffset( void );
+        void    clear( void );
 
     protected:
-        static const G4int  copyDepth1BitsOffset = 8;
-};
-
-
-inline G4int  CexmcEnergyDepositInCalorimeter::GetRow( G4int  index )
-{
-    index &= ( ( 1 << ( leftRightBitsOffset - 1 ) ) |
-                          ( ( 1 << ( leftRightBitsOffset - 1 ) ) - 1 ) );
-    return index >> copyDepth1BitsOffset;
-}
-
-
-inline G4int  CexmcEnergyDepositInCalorimeter::GetColumn( G4int  index )
-{
-    return index & ( ( 1 << ( copyDepth1BitsOffset - 1 ) ) |
-                              ( ( 1 << ( copyDepth1BitsOffset - 1 ) ) - 1 ) );
-}
+        G4bool  ProcessHits( G4Step *  step, G4TouchableHistory *  tHistory );
 
-
-inline G4int  CexmcEnergyDepositInCalorimeter::GetCopyDepth1BitsOffset( void )
-{
-    return copyDepth1BitsOffset;
-}
+    private:
+        /* showers in crystals produce thousands of steps per event, so
+         * deposits are accumulated in the array rather than in eventMap */
+        CexmcEnergyDepositArray  edArray;
+};
 
 
 #endif
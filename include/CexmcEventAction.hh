@@ -31,6 +31,14 @@ class  CexmcTrackPointsStore;
 class  CexmcEventActionMessenger;
 class  CexmcProductionModelData;
 class  CexmcChargeExchangeReconstructor;
+class  CexmcRun;
+#ifdef CEXMC_USE_PERSISTENCY
+struct  CexmcEventSObject;
+struct  CexmcReplayedEventOutput;
+#endif
+#ifdef CEXMC_USE_ROOT
+class  CexmcHistoManager;
+#endif
 
 
 class  CexmcEventAction : public G4UserEventAction
@@ -39,6 +47,16 @@ class  CexmcEventAction : public G4UserEventAction
         explicit CexmcEventAction( CexmcPhysicsManager *  physicsManager,
                                    G4int  verbose = 0 );
 
+#ifdef CEXMC_USE_PERSISTENCY
+        /* replay worker: has copies of digitizers and reconstructor of
+         * eventAction with the same settings, it does not print or draw
+         * events, it takes data of the replayed event from
+         * SetReplayedEventData() rather than from the production model,
+         * updates counters of the run set in SetReplayOutput() and puts
+         * saved events data into the output instead of writing them */
+        explicit CexmcEventAction( const CexmcEventAction &  eventAction );
+#endif
+
         virtual ~CexmcEventAction();
 
     public:
@@ -53,9 +71,36 @@ class  CexmcEventAction : public G4UserEventAction
 
         void      SetVerboseDrawLevel( G4int  value );
 
+        /* if on then the event is being replayed once more for another
+         * output project: only run counters are updated and the event is
+         * saved, nothing is printed, drawn or put into histograms */
+        void      SetSecondaryOutput( G4bool  on = true );
+
         CexmcChargeExchangeReconstructor *  GetReconstructor( void );
 
+#ifdef CEXMC_USE_PERSISTENCY
+        /* returns true if events may be printed or drawn */
+        G4bool    EventsArePrintedOrDrawn( void ) const;
+
+        void      SetReplayedEventData(
+                        const CexmcAngularRangeList *  triggeredAngularRanges,
+                        const CexmcProductionModelData *  pmData );
+
+        void      SetReplayOutput( CexmcReplayedEventOutput *  output,
+                                   CexmcRun *  run );
+
+#ifdef CEXMC_USE_ROOT
+        void      SetHistoManager( CexmcHistoManager *  histoManager );
+#endif
+#endif
+
     private:
+#ifdef CEXMC_USE_ROOT
+        CexmcHistoManager *  GetHistoManager( void ) const;
+#endif
+
+        CexmcRun *  GetRun( void ) const;
+
         void  PrintReconstructedData(
                         const CexmcAngularRangeList &  angularRanges,
                         const CexmcAngularRange &  angularGap ) const;
@@ -110,6 +155,12 @@ class  CexmcEventAction : public G4UserEventAction
         static CexmcTrackPointsStore *  MakeTrackPointsStore(
                             const CexmcTrackPointsDigitizer *  digitizer );
 
+        /* energy deposit store refers to calorimeter collections of the
+         * digitizer, only its other values change from event to event */
+        static void  UpdateEnergyDepositStore(
+                            CexmcEnergyDepositStore *  edStore,
+                            const CexmcEnergyDepositDigitizer *  digitizer );
+
         static void  PrintEnergyDeposit(
                             const CexmcEnergyDepositStore *  edStore );
 
@@ -127,12 +178,50 @@ class  CexmcEventAction : public G4UserEventAction
 
         G4double                            opKinEnergy;
 
+    private:
+        /* digitizers are owned by G4DigiManager (but digitizers of a
+         * replay worker are owned by the worker) */
+        CexmcEnergyDepositDigitizer *       energyDepositDigitizer;
+
+        CexmcTrackPointsDigitizer *         trackPointsDigitizer;
+
+        /* stores refer to data of the digitizers, they are created once and
+         * reused in every event */
+        CexmcEnergyDepositStore *           edStore;
+
+        CexmcTrackPointsStore *             tpStore;
+
+#ifdef CEXMC_USE_PERSISTENCY
+        /* event data to be saved is copied here to apply calorimeter ED
+         * floor, buffers of the collections are reused in every event */
+        CexmcEventSObject *                 evSObject;
+#endif
+
     private:
         G4int                               verbose;
 
         G4int                               verboseDraw;
 
+        G4bool                              isSecondaryOutput;
+
         CexmcEventActionMessenger *         messenger;
+
+    private:
+        G4bool                              isReplayWorker;
+
+#ifdef CEXMC_USE_PERSISTENCY
+        const CexmcAngularRangeList *       replayedTriggeredAngularRanges;
+
+        const CexmcProductionModelData *    replayedPmData;
+
+        CexmcReplayedEventOutput *          replayOutput;
+
+        CexmcRun *                          replayRun;
+#endif
+
+#ifdef CEXMC_USE_ROOT
+        CexmcHistoManager *                 workerHistoManager;
+#endif
 };
 
 
@@ -148,6 +237,12 @@ inline void  CexmcEventAction::SetVerboseDrawLevel( G4int  value )
 }
 
 
+inline void  CexmcEventAction::SetSecondaryOutput( G4bool  on )
+{
+    isSecondaryOutput = on;
+}
+
+
 inline CexmcChargeExchangeReconstructor *
                                     CexmcEventAction::GetReconstructor( void )
 {
@@ -155,5 +250,38 @@ inline CexmcChargeExchangeReconstructor *
 }
 
 
+#ifdef CEXMC_USE_PERSISTENCY
+
+inline void  CexmcEventAction::SetReplayedEventData(
+                        const CexmcAngularRangeList *  triggeredAngularRanges,
+                        const CexmcProductionModelData *  pmData )
+{
+    replayedTriggeredAngularRanges = triggeredAngularRanges;
+    replayedPmData = pmData;
+}
+
+
+inline void  CexmcEventAction::SetReplayOutput(
+                                        CexmcReplayedEventOutput *  output,
+                                        CexmcRun *  run )
+{
+    replayOutput = output;
+    replayRun = run;
+}
+
+
+#ifdef CEXMC_USE_ROOT
+
+inline void  CexmcEventAction::SetHistoManager(
+                                        CexmcHistoManager *  histoManager )
+{
+    workerHistoManager = histoManager;
+}
+
+#endif
+
+#endif
+
+
 #endif
 
@@ -21,11 +21,18 @@
 
 #ifdef CEXMC_USE_PERSISTENCY
 
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include <boost/archive/archive_exception.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/split_member.hpp>
+#include <boost/serialization/version.hpp>
 #include "CexmcSimpleTrackPointInfoStore.hh"
 #include "CexmcSimpleProductionModelDataStore.hh"
 #include "CexmcCommon.hh"
 
+#define CEXMC_EVENT_SOBJECT_VERSION 1
+
 
 struct  CexmcEventSObject
 {
@@ -69,13 +76,111 @@ struct  CexmcEventSObject
 
     CexmcSimpleProductionModelDataStore      productionModelData;
 
+    /* energy deposit in crystals with energy deposit less than floor is
+     * set to zero and therefore is not saved */
+    void  ApplyCalorimeterEDFloor( G4double  floor );
+
+    /* exchanges contents with other object, calorimeter energy deposit
+     * collections are not copied */
+    void  Swap( CexmcEventSObject &  other );
+
+    template  < typename  Archive >
+    void  save( Archive &  archive, const unsigned int  version ) const;
+
     template  < typename  Archive >
-    void  serialize( Archive &  archive, const unsigned int  version );
+    void  load( Archive &  archive, const unsigned int  version );
+
+    BOOST_SERIALIZATION_SPLIT_MEMBER()
+
+    /* since version 1 calorimeter energy deposit collections are saved as
+     * their dimensions and (row, column, value) of crystals with non-zero
+     * energy deposit */
+    template  < typename  Archive >
+    static void  SaveSparseEDCollection( Archive &  archive,
+                const CexmcEnergyDepositCalorimeterCollection &  collection );
+
+    template  < typename  Archive >
+    static void  LoadSparseEDCollection( Archive &  archive,
+                CexmcEnergyDepositCalorimeterCollection &  collection );
 };
 
 
+inline void  CexmcEventSObject::ApplyCalorimeterEDFloor( G4double  floor )
+{
+    CexmcEnergyDepositCalorimeterCollection *  collections[] =
+                { &calorimeterEDLeftCollection, &calorimeterEDRightCollection };
+
+    for ( G4int  i( 0 ); i < 2; ++i )
+    {
+        G4double *  values( collections[ i ]->GetData() );
+        G4int       size( collections[ i ]->GetSize() );
+
+        for ( G4int  k( 0 ); k < size; ++k )
+        {
+            if ( values[ k ] < floor )
+                values[ k ] = 0;
+        }
+    }
+}
+
+
+inline void  CexmcEventSObject::Swap( CexmcEventSObject &  other )
+{
+    std::swap( eventId, other.eventId );
+    std::swap( edDigitizerMonitorHasTriggered,
+               other.edDigitizerMonitorHasTriggered );
+    std::swap( monitorED, other.monitorED );
+    std::swap( vetoCounterEDLeft, other.vetoCounterEDLeft );
+    std::swap( vetoCounterEDRight, other.vetoCounterEDRight );
+    std::swap( calorimeterEDLeft, other.calorimeterEDLeft );
+    std::swap( calorimeterEDRight, other.calorimeterEDRight );
+    calorimeterEDLeftCollection.Swap( other.calorimeterEDLeftCollection );
+    calorimeterEDRightCollection.Swap( other.calorimeterEDRightCollection );
+    std::swap( monitorTP, other.monitorTP );
+    std::swap( targetTPBeamParticle, other.targetTPBeamParticle );
+    std::swap( targetTPOutputParticle, other.targetTPOutputParticle );
+    std::swap( targetTPNucleusParticle, other.targetTPNucleusParticle );
+    std::swap( targetTPOutputParticleDecayProductParticle1,
+               other.targetTPOutputParticleDecayProductParticle1 );
+    std::swap( targetTPOutputParticleDecayProductParticle2,
+               other.targetTPOutputParticleDecayProductParticle2 );
+    std::swap( vetoCounterTPLeft, other.vetoCounterTPLeft );
+    std::swap( vetoCounterTPRight, other.vetoCounterTPRight );
+    std::swap( calorimeterTPLeft, other.calorimeterTPLeft );
+    std::swap( calorimeterTPRight, other.calorimeterTPRight );
+    std::swap( productionModelData, other.productionModelData );
+}
+
+
+template  < typename  Archive >
+void  CexmcEventSObject::save( Archive &  archive, const unsigned int ) const
+{
+    archive & eventId;
+    archive & edDigitizerMonitorHasTriggered;
+    archive & monitorED;
+    archive & vetoCounterEDLeft;
+    archive & vetoCounterEDRight;
+    archive & calorimeterEDLeft;
+    archive & calorimeterEDRight;
+    SaveSparseEDCollection( archive, calorimeterEDLeftCollection );
+    SaveSparseEDCollection( archive, calorimeterEDRightCollection );
+    archive & monitorTP;
+    archive & targetTPBeamParticle;
+    archive & targetTPOutputParticle;
+    archive & targetTPNucleusParticle;
+    archive & targetTPOutputParticleDecayProductParticle1;
+    archive & targetTPOutputParticleDecayProductParticle2;
+    archive & vetoCounterTPLeft;
+    archive & vetoCounterTPRight;
+    archive & calorimeterTPLeft;
+    archive & calorimeterTPRight;
+    archive & productionModelData;
+}
+
+
 template  < typename  Archive >
-void  CexmcEventSObject::serialize( Archive &  archive, const unsigned int )
+void  CexmcEventSObject::load( Archive &  archive,
+                               const unsigned int  version )
 {
     archive & eventId;
     archive & edDigitizerMonitorHasTriggered;
@@ -84,8 +189,20 @@ void  CexmcEventSObject::serialize( Archive &  archive, const unsigned int )
     archive & vetoCounterEDRight;
     archive & calorimeterEDLeft;
     archive & calorimeterEDRight;
-    archive & calorimeterEDLeftCollection;
-    archive & calorimeterEDRightCollection;
+    if ( version > 0 )
+    {
+        LoadSparseEDCollection( archive, calorimeterEDLeftCollection );
+        LoadSparseEDCollection( archive, calorimeterEDRightCollection );
+    }
+    else
+    {
+        CexmcEnergyDepositCalorimeterRowsCollection  rows;
+
+        archive & rows;
+        calorimeterEDLeftCollection.Assign( rows );
+        archive & rows;
+        calorimeterEDRightCollection.Assign( rows );
+    }
     archive & monitorTP;
     archive & targetTPBeamParticle;
     archive & targetTPOutputParticle;
@@ -99,6 +216,82 @@ void  CexmcEventSObject::serialize( Archive &  archive, const unsigned int )
     archive & productionModelData;
 }
 
+
+template  < typename  Archive >
+void  CexmcEventSObject::SaveSparseEDCollection( Archive &  archive,
+                const CexmcEnergyDepositCalorimeterCollection &  collection )
+{
+    boost::int32_t    nmbOfRows( collection.GetNmbOfRows() );
+    boost::int32_t    nmbOfColumns( collection.GetNmbOfColumns() );
+    boost::int32_t    nmbOfEntries( 0 );
+    const G4double *  values( collection.GetData() );
+    G4int             size( collection.GetSize() );
+
+    for ( G4int  k( 0 ); k < size; ++k )
+    {
+        if ( values[ k ] != 0 )
+            ++nmbOfEntries;
+    }
+
+    archive & nmbOfRows;
+    archive & nmbOfColumns;
+    archive & nmbOfEntries;
+
+    for ( G4int  k( 0 ); k < size; ++k )
+    {
+        if ( values[ k ] == 0 )
+            continue;
+
+        boost::uint16_t  row( k / nmbOfColumns );
+        boost::uint16_t  column( k % nmbOfColumns );
+
+        archive & row;
+        archive & column;
+        archive & values[ k ];
+    }
+}
+
+
+template  < typename  Archive >
+void  CexmcEventSObject::LoadSparseEDCollection( Archive &  archive,
+                CexmcEnergyDepositCalorimeterCollection &  collection )
+{
+    boost::int32_t  nmbOfRows( 0 );
+    boost::int32_t  nmbOfColumns( 0 );
+    boost::int32_t  nmbOfEntries( 0 );
+
+    archive & nmbOfRows;
+    archive & nmbOfColumns;
+    archive & nmbOfEntries;
+
+    if ( nmbOfRows < 0 || nmbOfColumns < 0 || nmbOfEntries < 0 ||
+         nmbOfEntries > nmbOfRows * nmbOfColumns )
+        throw boost::archive::archive_exception(
+                        boost::archive::archive_exception::input_stream_error );
+
+    collection.Resize( nmbOfRows, nmbOfColumns );
+
+    for ( boost::int32_t  i( 0 ); i < nmbOfEntries; ++i )
+    {
+        boost::uint16_t  row( 0 );
+        boost::uint16_t  column( 0 );
+        G4double         value( 0 );
+
+        archive & row;
+        archive & column;
+        archive & value;
+
+        if ( row >= nmbOfRows || column >= nmbOfColumns )
+            throw boost::archive::archive_exception(
+                        boost::archive::archive_exception::input_stream_error );
+
+        collection[ row ][ column ] = value;
+    }
+}
+
+
+BOOST_CLASS_VERSION( CexmcEventSObject, CEXMC_EVENT_SOBJECT_VERSION )
+
 #endif
 
 #endif
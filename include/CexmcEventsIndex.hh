@@ -0,0 +1,119 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEventsIndex.hh
+ *
+ *    Description:  index of events data records (.idx file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 14:07:12
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_EVENTS_INDEX_HH
+#define CEXMC_EVENTS_INDEX_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <G4String.hh>
+#include <G4Types.hh>
+
+
+/* one record per record in the .fdb file, offsets are positions of the
+ * records in the .fdb and .edb files; the .edb offset is a position of the
+ * next events data record if the fast record has no events data */
+struct  CexmcEventsIndexRecord
+{
+    boost::int64_t  fastEventsDataOffset;
+
+    boost::int64_t  eventsDataOffset;
+
+    boost::int32_t  nmbOfEDTBefore;
+
+    boost::int32_t  edDigitizerHasTriggered;
+};
+
+
+class  CexmcEventsIndex
+{
+    public:
+        /* if nmbOfRecordsToKeep is not zero then writing continues after
+         * nmbOfRecordsToKeep records of the existing file, the rest of the
+         * file is discarded */
+        CexmcEventsIndex( const G4String &  fileName, G4bool  forWriting,
+                          G4int  nmbOfRecordsToKeep = 0 );
+
+    public:
+        void    Write( boost::int64_t  fastEventsDataOffset,
+                       boost::int64_t  eventsDataOffset,
+                       G4bool  edDigitizerHasTriggered );
+
+        CexmcEventsIndexRecord  Read( G4int  index );
+
+        /* returns false if the index could not be written */
+        G4bool  Flush( void );
+
+        /* returns index of the first record preceded by nmbOfEDT records with
+         * EDT or number of records if there is no such record */
+        G4int   FindFirstRecordAfterEDT( G4int  nmbOfEDT );
+
+    public:
+        G4bool  IsOpen( void ) const;
+
+        G4int   GetNmbOfRecords( void ) const;
+
+        G4int   GetNmbOfEDT( void ) const;
+
+    private:
+        std::fstream  file;
+
+        G4bool        isOpen;
+
+        G4int         nmbOfRecords;
+
+        G4int         nmbOfEDT;
+
+    private:
+        static const char            magic[];
+
+        static const boost::int32_t  version;
+
+        static const std::streamoff  headerSize;
+};
+
+
+inline G4bool  CexmcEventsIndex::Flush( void )
+{
+    return ! file.flush().fail();
+}
+
+
+inline G4bool  CexmcEventsIndex::IsOpen( void ) const
+{
+    return isOpen;
+}
+
+
+inline G4int  CexmcEventsIndex::GetNmbOfRecords( void ) const
+{
+    return nmbOfRecords;
+}
+
+
+inline G4int  CexmcEventsIndex::GetNmbOfEDT( void ) const
+{
+    return nmbOfEDT;
+}
+
+#endif
+
+#endif
+
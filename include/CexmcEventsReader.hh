@@ -0,0 +1,208 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEventsReader.hh
+ *
+ *    Description:  read-ahead reader of events data (.fdb and .edb or .cdb
+ *                  files)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 11:42:05
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_EVENTS_READER_HH
+#define CEXMC_EVENTS_READER_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <deque>
+#include <vector>
+#include <fstream>
+#include <boost/archive/binary_iarchive.hpp>
+#ifdef CEXMC_USE_THREADS
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#endif
+#include <G4String.hh>
+#include "CexmcEventSObject.hh"
+#include "CexmcEventFastSObject.hh"
+#include "CexmcEventsIndex.hh"
+#include "CexmcCommon.hh"
+
+class  CexmcColumnarEventsStore;
+class  CexmcCompressedInputStreambuf;
+class  CexmcCustomFilterEval;
+class  CexmcEventsSelection;
+
+
+struct  CexmcReadEventData
+{
+    CexmcEventFastSObject  evFastSObject;
+
+    CexmcEventSObject      evSObject;
+
+    G4bool                 hasEventData;
+
+    /* rejected by the fast TPT expressions of the custom filter or not
+     * selected by TPT in the events selection */
+    G4bool                 isFiltered;
+};
+
+
+typedef std::vector< CexmcReadEventData >  CexmcReadEventDataChunk;
+
+
+/* Reads fast events data and (where it exists) events data records in the
+ * order they were written starting from startRecord (as found in the events
+ * index) or from the beginning. Events data file is either a boost archive or
+ * a columnar events store depending on eventDataFormat, boost archives are
+ * decompressed if eventDataCodec is not CexmcNoEventDataCodec. If
+ * CEXMC_USE_THREADS is defined then records are decoded in chunks by a
+ * dedicated thread while the caller processes previously decoded chunks.
+ * If filter is given then its TPT expressions which do not need events data
+ * are evaluated right after reading a fast events data record, events data
+ * of rejected records are skipped without decoding: a boost archive record
+ * can only be skipped if eventsIndex (where firstIndexRecord corresponds to
+ * the first record read) is given and at least one record was decoded.
+ * The fast TPT expressions are evaluated for the whole chunk at once.
+ * Records which are not selected by TPT in selection (indexed like the events
+ * index) are rejected in the same way before evaluating the filter */
+class  CexmcEventsReader
+{
+    public:
+        CexmcEventsReader( const G4String &  eventsDataFileName,
+                           const G4String &  fastEventsDataFileName,
+                           G4int  nmbOfRecords,
+                           G4bool  eventDataWrittenOnEveryTPT,
+                           CexmcEventDataFormat  eventDataFormat =
+                                            CexmcBoostArchiveEventDataFormat,
+                           CexmcEventDataCodec  eventDataCodec =
+                                            CexmcNoEventDataCodec,
+                           const CexmcEventsIndexRecord *  startRecord = NULL,
+                           const CexmcCustomFilterEval *  filter = NULL,
+                           CexmcEventsIndex *  eventsIndex = NULL,
+                           G4int  firstIndexRecord = 0,
+                           const CexmcEventsSelection *  selection = NULL,
+                           G4int  chunkSize = 256, G4int  maxChunks = 4 );
+
+        ~CexmcEventsReader();
+
+    public:
+        /* evSObject is only updated if the record has events data and was
+         * not filtered, returns false if evSObject was not updated; the
+         * record is swapped into evSObject rather than copied, so previous
+         * contents of evSObject are reused as a buffer for later records */
+        G4bool  Next( CexmcEventFastSObject &  evFastSObject,
+                      CexmcEventSObject &  evSObject );
+
+        /* returns true if the record returned by the last call to Next() was
+         * rejected by the filter */
+        G4bool  LastRecordIsFiltered( void ) const;
+
+    private:
+        void    SeekTo( const CexmcEventsIndexRecord &  record );
+
+        /* returns false if the events data record cannot be skipped */
+        G4bool  SkipEventData( G4int  indexRecord );
+
+        void    ReadChunk( CexmcReadEventDataChunk &  chunk );
+
+#ifdef CEXMC_USE_THREADS
+        void    Run( void );
+
+        void    Stop( void );
+#endif
+
+    private:
+        std::ifstream                      eventsDataFile;
+
+        std::ifstream                      fastEventsDataFile;
+
+        CexmcCompressedInputStreambuf *    eventsDataDecompressor;
+
+        CexmcCompressedInputStreambuf *    fastEventsDataDecompressor;
+
+        /* either the files or the decompressors */
+        std::istream                       eventsDataStream;
+
+        std::istream                       fastEventsDataStream;
+
+        boost::archive::binary_iarchive *  evArchive;
+
+        boost::archive::binary_iarchive *  evFastArchive;
+
+        CexmcColumnarEventsStore *         columnarStore;
+
+        G4int                              columnarRecord;
+
+        /* an archive reads class information along with the first object,
+         * so the first events data record must not be skipped */
+        G4bool                             evArchiveIsPrimed;
+
+        const CexmcCustomFilterEval *      filter;
+
+        CexmcEventsIndex *                 eventsIndex;
+
+        G4int                              firstIndexRecord;
+
+        const CexmcEventsSelection *       selection;
+
+        /* results of the fast TPT expressions for the chunk being read */
+        std::vector< unsigned char >       fastTPTResult;
+
+        G4int                              nmbOfRecords;
+
+        G4int                              nmbOfRecordsRead;
+
+        G4bool                             eventDataWrittenOnEveryTPT;
+
+        G4int                              chunkSize;
+
+        G4int                              maxChunks;
+
+    private:
+        std::deque< CexmcReadEventDataChunk >  chunks;
+
+        CexmcReadEventDataChunk            curChunk;
+
+        /* consumed chunks whose buffers are reused for reading */
+        std::deque< CexmcReadEventDataChunk >  freeChunks;
+
+        size_t                             curRecord;
+
+#ifdef CEXMC_USE_THREADS
+    private:
+        boost::mutex                       mutex;
+
+        boost::condition_variable          chunkReady;
+
+        boost::condition_variable          chunkConsumed;
+
+        G4bool                             done;
+
+        G4bool                             failed;
+
+        G4bool                             stopped;
+
+        boost::thread *                    thread;
+#endif
+};
+
+
+inline G4bool  CexmcEventsReader::LastRecordIsFiltered( void ) const
+{
+    return curRecord > 0 && curChunk[ curRecord - 1 ].isFiltered;
+}
+
+#endif
+
+#endif
+
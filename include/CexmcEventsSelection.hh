@@ -0,0 +1,140 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEventsSelection.hh
+ *
+ *    Description:  custom filter decisions on events (.sel file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 16:34:51
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_EVENTS_SELECTION_HH
+#define CEXMC_EVENTS_SELECTION_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <G4String.hh>
+#include <G4Types.hh>
+
+
+/* two bitmaps with one bit per record in the .fdb file: a record is selected
+ * by TPT if it passed TPT expressions of the custom filter and selected by
+ * EDT if it also passed EDT expressions; records which were not replayed are
+ * not selected */
+class  CexmcEventsSelection
+{
+    public:
+        explicit CexmcEventsSelection( G4int  nmbOfRecords );
+
+        /* reads the selection from the file */
+        explicit CexmcEventsSelection( const G4String &  fileName );
+
+    public:
+        void    Write( const G4String &  fileName ) const;
+
+        void    Select( G4int  record, G4bool  byTPT, G4bool  byEDT );
+
+    public:
+        G4bool  IsSelectedByTPT( G4int  record ) const;
+
+        G4bool  IsSelectedByEDT( G4int  record ) const;
+
+        G4int   GetNmbOfRecords( void ) const;
+
+        G4int   GetNmbOfSelectedByEDT( void ) const;
+
+    private:
+        static G4bool  GetBit( const std::vector< unsigned char > &  bits,
+                               G4int  record );
+
+        static void    SetBit( std::vector< unsigned char > &  bits,
+                               G4int  record, G4bool  value );
+
+    private:
+        G4int                         nmbOfRecords;
+
+        std::vector< unsigned char >  tptBits;
+
+        std::vector< unsigned char >  edtBits;
+
+    private:
+        static const char            magic[];
+
+        static const boost::int32_t  version;
+
+        static const std::streamoff  headerSize;
+};
+
+
+inline G4bool  CexmcEventsSelection::GetBit(
+                                    const std::vector< unsigned char > &  bits,
+                                    G4int  record )
+{
+    return ( bits[ record >> 3 ] & ( 1 << ( record & 7 ) ) ) != 0;
+}
+
+
+inline void  CexmcEventsSelection::SetBit(
+                                    std::vector< unsigned char > &  bits,
+                                    G4int  record, G4bool  value )
+{
+    if ( value )
+        bits[ record >> 3 ] |= ( 1 << ( record & 7 ) );
+    else
+        bits[ record >> 3 ] &= ~( 1 << ( record & 7 ) );
+}
+
+
+inline void  CexmcEventsSelection::Select( G4int  record, G4bool  byTPT,
+                                           G4bool  byEDT )
+{
+    if ( record < 0 || record >= nmbOfRecords )
+        return;
+
+    SetBit( tptBits, record, byTPT );
+    SetBit( edtBits, record, byTPT && byEDT );
+}
+
+
+inline G4bool  CexmcEventsSelection::IsSelectedByTPT( G4int  record ) const
+{
+    if ( record < 0 || record >= nmbOfRecords )
+        return false;
+
+    return GetBit( tptBits, record );
+}
+
+
+inline G4bool  CexmcEventsSelection::IsSelectedByEDT( G4int  record ) const
+{
+    if ( record < 0 || record >= nmbOfRecords )
+        return false;
+
+    return GetBit( edtBits, record );
+}
+
+
+inline G4int  CexmcEventsSelection::GetNmbOfRecords( void ) const
+{
+    return nmbOfRecords;
+}
+
+#endif
+
+#endif
+
+#endif
+
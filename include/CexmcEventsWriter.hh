@@ -0,0 +1,246 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcEventsWriter.hh
+ *
+ *    Description:  writer of events data (.fdb, .edb or .cdb and .idx files)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 17:02:44
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_EVENTS_WRITER_HH
+#define CEXMC_EVENTS_WRITER_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <vector>
+#include <fstream>
+#include <boost/cstdint.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/serialization/vector.hpp>
+#ifdef CEXMC_USE_THREADS
+#include <boost/thread/thread.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#endif
+#include <G4String.hh>
+#include "CexmcEventSObject.hh"
+#include "CexmcEventFastSObject.hh"
+#include "CexmcEventsIndex.hh"
+#include "CexmcCommon.hh"
+
+class  CexmcColumnarEventsStore;
+class  CexmcCompressedOutputStreambuf;
+
+
+/* a queued record: events data are kept in objects recycled by the writer,
+ * fast events data records have no events data */
+struct  CexmcWriteEventData
+{
+    CexmcWriteEventData() : evSObject( NULL )
+    {}
+
+    CexmcEventFastSObject  evFastSObject;
+
+    CexmcEventSObject *    evSObject;
+};
+
+
+/* state of the writer at a checkpoint: numbers of written records, sizes
+ * of the files and, if the files are compressed, uncompressed positions and
+ * data of their incomplete blocks */
+struct  CexmcEventsWriterState
+{
+    G4int                nmbOfFastEventsWritten;
+
+    G4int                nmbOfEventsWritten;
+
+    boost::int64_t       fastEventsDataSize;
+
+    boost::int64_t       eventsDataSize;
+
+    boost::int64_t       fastEventsDataBlockStart;
+
+    boost::int64_t       eventsDataBlockStart;
+
+    std::vector< char >  fastEventsDataPending;
+
+    std::vector< char >  eventsDataPending;
+
+    template  < typename  Archive >
+    void  serialize( Archive &  archive, const unsigned int  version );
+};
+
+
+/* Writes fast events data into <project>.fdb, events data into <project>.edb
+ * (boost archive format) or <project>.cdb (columnar format) and the events
+ * index into <project>.idx. The .fdb and .edb files are block-compressed with
+ * eventDataCodec unless it is CexmcNoEventDataCodec, positions in the events
+ * index refer to uncompressed data. A fast events data record must be written
+ * before events data record of the same event. If CEXMC_USE_THREADS is
+ * defined then records are put in a queue of maxRecords records and written
+ * by a dedicated thread, callers wait while the queue is full. Events data
+ * objects of written records are reused for next records. Close() must
+ * be called when all records have been put: it writes all queued records and
+ * reports errors of writing; the destructor only writes what was not written
+ * by Close() and cannot report errors. If state is not NULL
+ * then the writer continues writing of the files from the checkpoint where
+ * the state was obtained */
+class  CexmcEventsWriter
+{
+    public:
+        CexmcEventsWriter( const G4String &  projectPath,
+                           CexmcEventDataFormat  eventDataFormat,
+                           CexmcEventDataCodec  eventDataCodec =
+                                                    CexmcNoEventDataCodec,
+                           const CexmcEventsWriterState *  state = NULL,
+                           G4int  maxRecords = 1024 );
+
+        ~CexmcEventsWriter();
+
+    public:
+        void  WriteFast( const CexmcEventFastSObject &  evFastSObject );
+
+        void  Write( const CexmcEventSObject &  evSObject );
+
+        /* writes all queued records, flushes the files and returns the state
+         * needed to continue writing from this point */
+        void  Checkpoint( CexmcEventsWriterState &  state );
+
+        /* writes all queued records and the last blocks of the files and
+         * closes the files, throws CexmcSystemException if any record or
+         * block could not be written; nothing can be written after that */
+        void  Close( void );
+
+    public:
+        CexmcEventDataFormat  GetEventDataFormat( void ) const;
+
+    private:
+        void  DoWriteFast( const CexmcEventFastSObject &  evFastSObject );
+
+        void  DoWrite( const CexmcEventSObject &  evSObject );
+
+        template  < typename  SObject >
+        boost::archive::binary_oarchive *  OpenArchive(
+                        const G4String &  fileName, std::ofstream &  file,
+                        std::vector< char > &  buffer,
+                        CexmcCompressedOutputStreambuf *&  compressor,
+                        std::ostream &  stream,
+                        CexmcEventDataCodec  eventDataCodec,
+                        G4int  nmbOfRecordsWritten, boost::int64_t  size,
+                        boost::int64_t  blockStart,
+                        const std::vector< char > *  pending );
+
+        void  GetStreamState( std::ostream &  stream,
+                        CexmcCompressedOutputStreambuf *  compressor,
+                        boost::int64_t &  size, boost::int64_t &  blockStart,
+                        std::vector< char > &  pending );
+
+#ifdef CEXMC_USE_THREADS
+        void  WaitForRoom( boost::mutex::scoped_lock &  lock );
+
+        void  WaitUntilWritten( boost::mutex::scoped_lock &  lock );
+
+        void  Run( void );
+
+        void  Stop( void );
+#endif
+
+    private:
+        CexmcEventDataFormat               eventDataFormat;
+
+        /* file buffers must outlive the files */
+        std::vector< char >                eventsDataBuffer;
+
+        std::vector< char >                fastEventsDataBuffer;
+
+        std::ofstream                      eventsDataFile;
+
+        std::ofstream                      fastEventsDataFile;
+
+        CexmcCompressedOutputStreambuf *   eventsDataCompressor;
+
+        CexmcCompressedOutputStreambuf *   fastEventsDataCompressor;
+
+        /* either the files or the compressors */
+        std::ostream                       eventsDataStream;
+
+        std::ostream                       fastEventsDataStream;
+
+        boost::archive::binary_oarchive *  evArchive;
+
+        boost::archive::binary_oarchive *  evFastArchive;
+
+        CexmcColumnarEventsStore *         columnarStore;
+
+        CexmcEventsIndex                   eventsIndex;
+
+        G4int                              nmbOfFastEventsWritten;
+
+        G4int                              nmbOfEventsWritten;
+
+        G4bool                             isClosed;
+
+#ifdef CEXMC_USE_THREADS
+    private:
+        std::vector< CexmcWriteEventData >  records;
+
+        /* records taken from the queue by the thread */
+        std::vector< CexmcWriteEventData >  batch;
+
+        /* events data objects of written records: they are filled by
+         * assignment and therefore reuse buffers of their collections */
+        std::vector< CexmcEventSObject * >  freeEvents;
+
+        G4int                              maxRecords;
+
+        boost::mutex                       mutex;
+
+        boost::condition_variable          recordsReady;
+
+        boost::condition_variable          recordsTaken;
+
+        G4bool                             failed;
+
+        G4bool                             stopped;
+
+        /* the thread writes a batch of records taken from the queue */
+        G4bool                             writing;
+
+        boost::thread *                    thread;
+#endif
+};
+
+
+template  < typename  Archive >
+void  CexmcEventsWriterState::serialize( Archive &  archive,
+                                         const unsigned int )
+{
+    archive & nmbOfFastEventsWritten;
+    archive & nmbOfEventsWritten;
+    archive & fastEventsDataSize;
+    archive & eventsDataSize;
+    archive & fastEventsDataBlockStart;
+    archive & eventsDataBlockStart;
+    archive & fastEventsDataPending;
+    archive & eventsDataPending;
+}
+
+
+inline CexmcEventDataFormat  CexmcEventsWriter::GetEventDataFormat( void ) const
+{
+    return eventDataFormat;
+}
+
+#endif
+
+#endif
+
@@ -49,6 +49,7 @@ enum  CexmcExceptionType
     CexmcIncompatibleProductionModel,
     CexmcBeamAndIncidentParticlesMismatch,
     CexmcInvalidAngularRange,
+    CexmcCheckpointMismatch,
 #ifdef CEXMC_USE_CUSTOM_FILTER
     CexmcCFBadSource,
     CexmcCFParseError,
@@ -59,6 +60,7 @@ enum  CexmcExceptionType
     CexmcCFUnexpectedVariable,
     CexmcCFUnexpectedVariableUsage,
     CexmcCFUnexpectedVectorIndex,
+    CexmcCFSelectionMismatch,
 #endif
     CexmcWeirdException
 };
@@ -166,8 +166,21 @@ class  CexmcHistoManager
     private:
         CexmcHistoManager();
 
+        /* the worker has empty copies of histograms of the histo manager
+         * which are not attached to any directory, it has no messenger */
+        explicit CexmcHistoManager( const CexmcHistoManager &  histoManager );
+
         ~CexmcHistoManager();
 
+    public:
+        /* histograms of a worker may be filled in another thread, they are
+         * added to histograms of the histo manager in MergeWorker() */
+        CexmcHistoManager *  CreateWorker( void ) const;
+
+        void                 MergeWorker( const CexmcHistoManager *  worker );
+
+        static void          DestroyWorker( CexmcHistoManager *  worker );
+
     public:
         void  Initialize( void );
 
@@ -237,6 +250,8 @@ class  CexmcHistoManager
 
         bool                          isInitialized;
 
+        bool                          isWorker;
+
         G4String                      opName;
 
         G4String                      nopName;
@@ -0,0 +1,65 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcHitsCollectionIds.hh
+ *
+ *    Description:  ids of hits collections of sensitive detectors
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 21:02:14
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_HITS_COLLECTION_IDS_HH
+#define CEXMC_HITS_COLLECTION_IDS_HH
+
+#include <G4Types.hh>
+#include "CexmcSensitiveDetectorsAttributes.hh"
+
+class  G4VHitsCollection;
+class  G4HCofThisEvent;
+
+
+/* ids of hits collections indexed by detector role and type: collection
+ * names are resolved in G4DigiManager only once when the object is created,
+ * therefore it must be created after sensitive detectors were registered;
+ * id of a collection which does not exist is -1 */
+class  CexmcHitsCollectionIds
+{
+    public:
+        CexmcHitsCollectionIds();
+
+    public:
+        G4int  Get( CexmcDetectorRole  role, CexmcDetectorType  type ) const;
+
+        /* returns the collection of the current event or NULL */
+        const G4VHitsCollection *  GetCollection( CexmcDetectorRole  role,
+                                            CexmcDetectorType  type ) const;
+
+        /* returns the collection of hcOfThisEvent or NULL, the current event
+         * is used if hcOfThisEvent is NULL */
+        const G4VHitsCollection *  GetCollection(
+                                            G4HCofThisEvent *  hcOfThisEvent,
+                                            CexmcDetectorRole  role,
+                                            CexmcDetectorType  type ) const;
+
+    private:
+        G4int  ids[ CexmcNumberOfDetectorRoles ][ CexmcNumberOfDetectorTypes ];
+};
+
+
+inline G4int  CexmcHitsCollectionIds::Get( CexmcDetectorRole  role,
+                                           CexmcDetectorType  type ) const
+{
+    return ids[ role ][ type ];
+}
+
+
+#endif
+
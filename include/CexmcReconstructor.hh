@@ -22,6 +22,7 @@
 #include <G4ThreeVector.hh>
 #include <G4AffineTransform.hh>
 #include "CexmcSetup.hh"
+#include "CexmcCalorimeterGridTables.hh"
 #include "CexmcCommon.hh"
 
 class  CexmcReconstructorMessenger;
@@ -33,6 +34,10 @@ class  CexmcReconstructor
     public:
         explicit CexmcReconstructor();
 
+        /* the copy has the same settings and no messenger (used by replay
+         * workers) */
+        CexmcReconstructor( const CexmcReconstructor &  reconstructor );
+
         virtual ~CexmcReconstructor();
 
     public:
@@ -171,6 +176,8 @@ class  CexmcReconstructor
     private:
         CexmcSetup::CalorimeterGeometryData  calorimeterGeometry;
 
+        CexmcCalorimeterGridTables           calorimeterGridTables;
+
         G4AffineTransform                    calorimeterLeftTransform;
         
         G4AffineTransform                    calorimeterRightTransform;
@@ -0,0 +1,119 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcReplayWorkers.hh
+ *
+ *    Description:  replay of events data in several threads
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 19:05:14
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_REPLAY_WORKERS_HH
+#define CEXMC_REPLAY_WORKERS_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+#ifdef CEXMC_USE_THREADS
+
+#include <vector>
+#include <boost/thread/mutex.hpp>
+#include <G4Types.hh>
+#include "CexmcReplayedEvent.hh"
+
+class  G4Event;
+class  CexmcSetup;
+class  CexmcRun;
+class  CexmcEventAction;
+class  CexmcException;
+#ifdef CEXMC_USE_ROOT
+class  CexmcHistoManager;
+#endif
+
+
+/* Replays batches of events in nmbOfThreads threads (the calling thread is
+ * one of them). Every worker has its own event with hits collections, its
+ * own event action (a replay worker of eventAction), its own run for every
+ * output and its own histograms, so workers share nothing but read-only
+ * settings. All of them are created and deleted in the calling thread
+ * because Geant4 allocators are not thread-safe. Results of the event action
+ * are put into outputs of the replayed events, the caller writes them in the
+ * original order of events after Replay() returns. Counters of runs and
+ * histograms of the workers are accumulated through all batches and must be
+ * merged by the caller at the end of replay */
+class  CexmcReplayWorkers
+{
+    public:
+        CexmcReplayWorkers( G4int  nmbOfThreads, G4int  nmbOfOutputs,
+                            const CexmcEventAction *  eventAction,
+                            const CexmcSetup *  setup );
+
+        ~CexmcReplayWorkers();
+
+    public:
+        /* replays the first nmbOfEvents events, exceptions thrown in the
+         * workers are rethrown here */
+        void  Replay( std::vector< CexmcReplayedEvent > &  events,
+                      G4int  nmbOfEvents );
+
+        /* adds counters of runs of the output to run */
+        void  MergeRuns( G4int  output, CexmcRun *  run ) const;
+
+#ifdef CEXMC_USE_ROOT
+        void  MergeHistos( CexmcHistoManager *  histoManager ) const;
+#endif
+
+    private:
+        struct  Worker
+        {
+            G4Event *                 event;
+
+            CexmcReplayedEventHits *  hits;
+
+            CexmcEventAction *        eventAction;
+
+            std::vector< CexmcRun * >  runs;
+
+#ifdef CEXMC_USE_ROOT
+            CexmcHistoManager *       histoManager;
+#endif
+        };
+
+    private:
+        void  Run( G4int  index );
+
+        void  ReplayEvent( Worker &  worker, CexmcReplayedEvent &  event );
+
+    private:
+        CexmcReplayWorkers( const CexmcReplayWorkers & );
+
+        CexmcReplayWorkers &  operator=( const CexmcReplayWorkers & );
+
+    private:
+        std::vector< Worker >                 workers;
+
+        std::vector< CexmcReplayedEvent > *   events;
+
+        G4int                                 nmbOfEvents;
+
+        /* events are claimed by workers in blocks of this size */
+        G4int                                 blockSize;
+
+        boost::mutex                          mutex;
+
+        G4int                                 nextEvent;
+
+        CexmcException *                      exception;
+};
+
+#endif
+#endif
+
+#endif
+
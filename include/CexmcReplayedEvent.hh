@@ -0,0 +1,160 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcReplayedEvent.hh
+ *
+ *    Description:  replayed event data and hits
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 18:12:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_REPLAYED_EVENT_HH
+#define CEXMC_REPLAYED_EVENT_HH
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <vector>
+#include <G4String.hh>
+#include "CexmcEventSObject.hh"
+#include "CexmcEventFastSObject.hh"
+#include "CexmcAngularRange.hh"
+#include "CexmcSimpleEnergyDeposit.hh"
+#include "CexmcEnergyDepositArray.hh"
+#include "CexmcTrackPoints.hh"
+#include "CexmcTrackPointInfo.hh"
+
+class  G4Event;
+class  CexmcSetup;
+
+
+/* what an output project does with a replayed event: decisions are made in
+ * the main thread, results are put here by the event action of a replay
+ * worker, saved events data are written later by the main thread in the
+ * original order of events */
+struct  CexmcReplayedEventOutput
+{
+    CexmcReplayedEventOutput() :
+        isReplayed( false ), skipEDT( false ), tptEventMustBeWritten( false ),
+        edTriggerIsOk( false ), fastEventIsSaved( false ),
+        eventIsSaved( false )
+    {}
+
+    G4bool                 isReplayed;
+
+    G4bool                 skipEDT;
+
+    /* the event is not replayed, its fast events data record is written
+     * as it was read */
+    G4bool                 tptEventMustBeWritten;
+
+    G4bool                 edTriggerIsOk;
+
+    G4bool                 fastEventIsSaved;
+
+    G4bool                 eventIsSaved;
+
+    CexmcEventFastSObject  fastEvent;
+
+    CexmcEventSObject      event;
+
+    /* message of an exception caught in the event action */
+    G4String               error;
+};
+
+
+/* a record read from the replayed project */
+struct  CexmcReplayedEvent
+{
+    CexmcReplayedEvent() : isReplayed( false )
+    {}
+
+    /* the event is replayed by at least one output, otherwise only its
+     * fast events data may be written */
+    G4bool                                   isReplayed;
+
+    CexmcEventFastSObject                    evFastSObject;
+
+    CexmcEventSObject                        evSObject;
+
+    CexmcAngularRangeList                    triggeredAngularRanges;
+
+    std::vector< CexmcReplayedEventOutput >  outputs;
+};
+
+
+/* hits collections of a replayed event filled from its events data, so that
+ * digitizers process the event as if it was simulated. The collections are
+ * added to hits collections of the event which must outlive this object.
+ * Hits in the collections refer to the events data and to data owned by this
+ * object rather than to allocated hits, so the collections are cleared in
+ * Clear() and in the destructor (otherwise the event would try to delete the
+ * hits). Geant4 allocators are only used in the constructor, therefore
+ * Fill() and Clear() may be called in another thread */
+class  CexmcReplayedEventHits
+{
+    public:
+        CexmcReplayedEventHits( G4Event &  event, const CexmcSetup *  setup );
+
+        ~CexmcReplayedEventHits();
+
+    public:
+        void  Fill( CexmcEventSObject &  evSObject );
+
+        void  Clear( void );
+
+    private:
+        CexmcReplayedEventHits( const CexmcReplayedEventHits & );
+
+        CexmcReplayedEventHits &  operator=( const CexmcReplayedEventHits & );
+
+    private:
+        const CexmcSetup *              setup;
+
+        CexmcEnergyDepositCollection *  monitorED;
+
+        CexmcEnergyDepositCollection *  vetoCounterED;
+
+        CexmcTrackPointsCollection *    monitorTP;
+
+        CexmcTrackPointsCollection *    vetoCounterTP;
+
+        CexmcTrackPointsCollection *    calorimeterTP;
+
+        CexmcTrackPointsCollection *    targetTP;
+
+    private:
+        CexmcEnergyDepositArray         calorimeterEDArray;
+
+        CexmcTrackPointInfo             monitorTPInfo;
+
+        CexmcTrackPointInfo             targetTPBeamParticleInfo;
+
+        CexmcTrackPointInfo             targetTPOutputParticleInfo;
+
+        CexmcTrackPointInfo             targetTPNucleusParticleInfo;
+
+        CexmcTrackPointInfo  targetTPOutputParticleDecayProductParticle1Info;
+
+        CexmcTrackPointInfo  targetTPOutputParticleDecayProductParticle2Info;
+
+        CexmcTrackPointInfo             vetoCounterTPLeftInfo;
+
+        CexmcTrackPointInfo             vetoCounterTPRightInfo;
+
+        CexmcTrackPointInfo             calorimeterTPLeftInfo;
+
+        CexmcTrackPointInfo             calorimeterTPRightInfo;
+};
+
+#endif
+
+#endif
+
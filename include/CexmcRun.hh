@@ -20,6 +20,10 @@
 #define CEXMC_RUN_HH
 
 #include <map>
+#ifdef CEXMC_USE_PERSISTENCY
+#include <boost/serialization/access.hpp>
+#include <boost/serialization/map.hpp>
+#endif
 #include <G4Run.hh>
 
 
@@ -30,6 +34,10 @@ typedef CexmcNmbOfHitsInRanges::value_type  CexmcNmbOfHitsInRangesData;
 
 class  CexmcRun : public G4Run
 {
+#ifdef CEXMC_USE_PERSISTENCY
+    friend class  boost::serialization::access;
+#endif
+
     public:
         CexmcRun();
 
@@ -52,6 +60,10 @@ class  CexmcRun : public G4Run
 
         void  IncrementNmbOfSavedFastEvents( void );
 
+    public:
+        /* adds counters collected by another (e.g. replay worker's) run */
+        void  Merge( const CexmcRun &  run );
+
     public:
         const CexmcNmbOfHitsInRanges &  GetNmbOfHitsSampled( void ) const;
 
@@ -73,6 +85,17 @@ class  CexmcRun : public G4Run
 
         G4int  GetNmbOfSavedFastEvents( void ) const;
 
+#ifdef CEXMC_USE_PERSISTENCY
+    private:
+        /* used to save and restore the run at checkpoints */
+        template  < typename  Archive >
+        void  serialize( Archive &  archive, const unsigned int  version );
+#endif
+
+    private:
+        static void  MergeNmbOfHitsInRanges( CexmcNmbOfHitsInRanges &  dst,
+                                        const CexmcNmbOfHitsInRanges &  src );
+
     private:
         CexmcNmbOfHitsInRanges  nmbOfHitsSampled;
 
@@ -94,6 +117,26 @@ class  CexmcRun : public G4Run
 };
 
 
+#ifdef CEXMC_USE_PERSISTENCY
+
+template  < typename  Archive >
+void  CexmcRun::serialize( Archive &  archive, const unsigned int )
+{
+    archive & numberOfEvent;
+    archive & nmbOfHitsSampled;
+    archive & nmbOfHitsSampledFull;
+    archive & nmbOfHitsTriggeredRealRange;
+    archive & nmbOfHitsTriggeredRecRange;
+    archive & nmbOfOrphanHits;
+    archive & nmbOfFalseHitsTriggeredEDT;
+    archive & nmbOfFalseHitsTriggeredRec;
+    archive & nmbOfSavedEvents;
+    archive & nmbOfSavedFastEvents;
+}
+
+#endif
+
+
 inline const CexmcNmbOfHitsInRanges &
                             CexmcRun::GetNmbOfHitsSampled( void ) const
 {
@@ -47,6 +47,12 @@ class  CexmcRunAction : public G4UserRunAction
                     G4int  nmbOfFalseHitsTriggeredEDT,
                     G4int  nmbOfFalseHitsTriggeredRec );
 
+        static G4double  GetMaxAcceptanceRelativeError(
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsSampled,
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsTriggeredRealRange,
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsTriggeredRecRange,
+                    const CexmcAngularRangeList &  angularRanges );
+
     private:
         CexmcPhysicsManager *  physicsManager;
 };
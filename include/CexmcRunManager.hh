@@ -20,10 +20,8 @@
 #define CEXMC_RUN_MANAGER_HH
 
 #include <set>
+#include <vector>
 #include <limits>
-#ifdef CEXMC_USE_PERSISTENCY
-#include <boost/archive/binary_oarchive.hpp>
-#endif
 #include <G4RunManager.hh>
 #include "CexmcRunSObject.hh"
 #include "CexmcException.hh"
@@ -32,14 +30,49 @@
 class  CexmcRunManagerMessenger;
 class  CexmcPhysicsManager;
 class  CexmcEventFastSObject;
+class  CexmcEventSObject;
+class  CexmcEventInfo;
+class  CexmcRun;
+class  G4Timer;
+#ifdef CEXMC_USE_PERSISTENCY
+class  CexmcEventsWriter;
+struct  CexmcCheckpointSObject;
+struct  CexmcReplayedEventOutput;
+#endif
 #ifdef CEXMC_USE_CUSTOM_FILTER
 class  CexmcCustomFilterEval;
+class  CexmcEventsSelection;
 #endif
 
 
 typedef std::set< CexmcOutputDataType >  CexmcOutputDataTypeSet;
 
 
+#ifdef CEXMC_USE_PERSISTENCY
+#ifdef CEXMC_USE_CUSTOM_FILTER
+/* an additional project written in the same replay pass as the main one: it
+ * has its own custom filter, events writer and run counters */
+struct  CexmcReplayOutput
+{
+    G4String                 projectId;
+
+    G4String                 cfFileName;
+
+    CexmcCustomFilterEval *  customFilter;
+
+    CexmcEventsWriter *      eventsWriter;
+
+    CexmcRun *               run;
+
+    G4int                    numberOfEventsProcessedEffective;
+};
+
+
+typedef std::vector< CexmcReplayOutput >  CexmcReplayOutputList;
+#endif
+#endif
+
+
 class  CexmcRunManager : public G4RunManager
 {
     public:
@@ -65,6 +98,14 @@ class  CexmcRunManager : public G4RunManager
 
         void  SetEventDataVerboseLevel( CexmcEventDataVerboseLevel  value );
 
+        void  SetTargetAcceptanceError( G4double  value );
+
+        void  SetPrecisionCheckInterval( G4int  value );
+
+        void  SetEventBudget( G4int  value );
+
+        void  SetTimeBudget( G4double  value );
+
         void  RegisterScenePrimitives( void );
 
 #ifdef CEXMC_USE_PERSISTENCY
@@ -84,8 +125,36 @@ class  CexmcRunManager : public G4RunManager
 
         void  SkipInteractionsWithoutEDTonWrite( G4bool  on = true );
 
+        void  SetEventDataFormat( CexmcEventDataFormat  value );
+
+        void  SetCalorimeterEDFloor( G4double  value );
+
+        void  SetEventDataCodec( CexmcEventDataCodec  value );
+
+        void  SetCheckpointInterval( G4int  value );
+
+        void  ResumeFromCheckpoint( G4bool  on = true );
+
+#ifdef CEXMC_USE_THREADS
+        void  SetReplayThreads( G4int  value );
+#endif
+
 #ifdef CEXMC_USE_CUSTOM_FILTER
         void  SetCustomFilter( const G4String &  cfFileName_ );
+
+        /* the read project is filtered with script cfFileName_ and written
+         * into project projectId_ along with the main project */
+        void  AddReplayOutput( const G4String &  projectId_,
+                               const G4String &  cfFileName_,
+                               G4bool  overrideExistingProject = false );
+
+        /* decisions of the custom filter on replayed events will be saved in
+         * selection name of the read project, empty name cancels saving */
+        void  SaveEventsSelection( const G4String &  name );
+
+        /* only events selected in selection name of the read project will
+         * be replayed, empty name cancels the selection */
+        void  UseEventsSelection( const G4String &  name );
 #endif
 #endif
 
@@ -113,9 +182,9 @@ class  CexmcRunManager : public G4RunManager
         G4String                  GetProjectId( void ) const;
 
 #ifdef CEXMC_USE_PERSISTENCY
-        boost::archive::binary_oarchive *  GetEventsArchive( void ) const;
+        CexmcEventsWriter *       GetEventsWriter( void ) const;
 
-        boost::archive::binary_oarchive *  GetFastEventsArchive( void ) const;
+        G4double                  GetCalorimeterEDFloor( void ) const;
 #endif
 
         CexmcEventDataVerboseLevel  GetEventDataVerboseLevel( void ) const;
@@ -125,15 +194,64 @@ class  CexmcRunManager : public G4RunManager
                            G4int  nSelect );
 
     private:
+        G4bool  EventIsEffective( const CexmcEventInfo *  eventInfo ) const;
+
         void  DoCommonEventLoop( G4int  nEvent, const G4String &  cmd,
-                                 G4int  nSelect );
+                                 G4int  nSelect, G4int  firstEvent = 0,
+                                 G4int  nmbOfEffectiveEventsBefore = 0 );
+
+        G4bool  RunShouldBeStopped( G4int  nmbOfEvents, G4Timer &  runTimer );
 
 #ifdef CEXMC_USE_PERSISTENCY
         void  DoReadEventLoop( G4int  nEvent );
 
-        void  SaveCurrentTPTEvent( const CexmcEventFastSObject &  evFastSObject,
-                                   const CexmcAngularRangeList &  angularRanges,
-                                   G4bool  writeToDatabase );
+        /* returns false if the event must not be replayed by the current
+         * output (hits of TPT events are counted here), tptEventMustBeWritten
+         * is set if fast events data of the event must be written with
+         * WriteTPTEvent() */
+        G4bool  EventMustBeReplayed(
+                                const CexmcEventFastSObject &  evFastSObject,
+                                const CexmcAngularRangeList &  angularRanges,
+                                G4bool  eventDataWrittenOnEveryTPT,
+                                G4bool  eventIsFiltered, G4int  record,
+                                G4bool &  skipEDTOnThisEvent,
+                                G4bool &  tptEventMustBeWritten );
+
+        void  CountTPTEvent( const CexmcEventFastSObject &  evFastSObject,
+                             const CexmcAngularRangeList &  angularRanges );
+
+        void  WriteTPTEvent( const CexmcEventFastSObject &  evFastSObject );
+
+        /* writes events data saved by a replay worker for the current
+         * output */
+        void  WriteReplayedEvent( const CexmcReplayedEventOutput &  output );
+
+        static void  PrintEventData( const CexmcEventSObject &  evSObject );
+
+        void  SaveCheckpoint( G4int  nmbOfEvents, G4int  nmbOfEventsEffective );
+
+        G4bool  ReadCheckpoint( CexmcCheckpointSObject &  checkpoint );
+
+        G4String  GetCheckpointFileName( void ) const;
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        /* makes custom filter, events writer and run of the replay output
+         * current, index 0 refers to the main project */
+        void  SwitchReplayOutput( G4int  index );
+
+        void  SwapReplayOutput( CexmcReplayOutput &  output );
+
+        /* events selection used on replay and custom filter of the current
+         * replay output must both accept the record */
+        G4bool  EventIsSelectedByTPT( G4int  record ) const;
+
+        G4bool  EventIsSelectedByEDT( G4int  record ) const;
+
+        /* decisions of the main project's custom filter are saved */
+        void  SelectEvent( G4int  record, G4bool  byTPT, G4bool  byEDT );
+
+        G4String  GetEventsSelectionFileName( const G4String &  name ) const;
+#endif
 #endif
 
     private:
@@ -168,6 +286,14 @@ class  CexmcRunManager : public G4RunManager
 
         CexmcEventDataVerboseLevel  rEvDataVerboseLevel;
 
+        G4double                    targetAccError;
+
+        G4int                       precisionCheckInterval;
+
+        G4int                       eventBudget;
+
+        G4double                    timeBudget;
+
     private:
         G4int                       numberOfEventsProcessed;
 
@@ -177,14 +303,36 @@ class  CexmcRunManager : public G4RunManager
 
 #ifdef CEXMC_USE_PERSISTENCY
     private:
-        boost::archive::binary_oarchive *  eventsArchive;
+        CexmcEventDataFormat        eventDataFormat;
+
+        G4double                    calorimeterEDFloor;
+
+        CexmcEventDataCodec         eventDataCodec;
+
+        G4int                       checkpointInterval;
+
+        G4bool                      resumeFromCheckpoint;
 
-        boost::archive::binary_oarchive *  fastEventsArchive;
+        CexmcEventsWriter *         eventsWriter;
 
         CexmcRunSObject             sObject;
 
+#ifdef CEXMC_USE_THREADS
+        G4int                       replayThreads;
+#endif
+
 #ifdef CEXMC_USE_CUSTOM_FILTER
         CexmcCustomFilterEval *     customFilter;
+
+        CexmcReplayOutputList       replayOutputs;
+
+        G4int                       curReplayOutput;
+
+        CexmcEventsSelection *      rEventsSelection;
+
+        CexmcEventsSelection *      wEventsSelection;
+
+        G4String                    wEventsSelectionName;
 #endif
 #endif
 
@@ -254,6 +402,30 @@ inline void  CexmcRunManager::SetEventDataVerboseLevel(
 }
 
 
+inline void  CexmcRunManager::SetTargetAcceptanceError( G4double  value )
+{
+    targetAccError = value;
+}
+
+
+inline void  CexmcRunManager::SetPrecisionCheckInterval( G4int  value )
+{
+    precisionCheckInterval = value;
+}
+
+
+inline void  CexmcRunManager::SetEventBudget( G4int  value )
+{
+    eventBudget = value;
+}
+
+
+inline void  CexmcRunManager::SetTimeBudget( G4double  value )
+{
+    timeBudget = value;
+}
+
+
 inline CexmcPhysicsManager *  CexmcRunManager::GetPhysicsManager( void )
 {
     return physicsManager;
@@ -311,17 +483,15 @@ inline G4String  CexmcRunManager::GetProjectId( void ) const
 
 #ifdef CEXMC_USE_PERSISTENCY
 
-inline boost::archive::binary_oarchive *  CexmcRunManager::GetEventsArchive(
-                                                                    void ) const
+inline CexmcEventsWriter *  CexmcRunManager::GetEventsWriter( void ) const
 {
-    return eventsArchive;
+    return eventsWriter;
 }
 
 
-inline boost::archive::binary_oarchive *  CexmcRunManager::GetFastEventsArchive(
-                                                                    void ) const
+inline G4double  CexmcRunManager::GetCalorimeterEDFloor( void ) const
 {
-    return fastEventsArchive;
+    return calorimeterEDFloor;
 }
 
 
@@ -351,6 +521,55 @@ inline void  CexmcRunManager::SkipInteractionsWithoutEDTonWrite( G4bool  on )
     skipInteractionsWithoutEDTonWrite = on;
 }
 
+
+inline void  CexmcRunManager::SetEventDataFormat( CexmcEventDataFormat  value )
+{
+    eventDataFormat = value;
+}
+
+
+inline void  CexmcRunManager::SetCalorimeterEDFloor( G4double  value )
+{
+    if ( ProjectIsRead() && value < sObject.calorimeterEDFloor )
+        throw CexmcException( CexmcPoorEventData );
+
+    calorimeterEDFloor = value;
+}
+
+
+inline void  CexmcRunManager::SetEventDataCodec( CexmcEventDataCodec  value )
+{
+    eventDataCodec = value;
+}
+
+
+inline void  CexmcRunManager::SetCheckpointInterval( G4int  value )
+{
+    checkpointInterval = value;
+}
+
+
+inline void  CexmcRunManager::ResumeFromCheckpoint( G4bool  on )
+{
+    resumeFromCheckpoint = on;
+}
+
+
+inline G4String  CexmcRunManager::GetCheckpointFileName( void ) const
+{
+    return projectsDir + "/" + projectId + ".cpt";
+}
+
+
+#ifdef CEXMC_USE_THREADS
+
+inline void  CexmcRunManager::SetReplayThreads( G4int  value )
+{
+    replayThreads = value;
+}
+
+#endif
+
 #endif
 
 
@@ -26,6 +26,8 @@ class  G4UIcommand;
 class  G4UIcmdWithAString;
 class  G4UIcmdWithAnInteger;
 class  G4UIcmdWithABool;
+class  G4UIcmdWithADouble;
+class  G4UIcmdWithADoubleAndUnit;
 class  G4UIcmdWithoutParameter;
 
 
@@ -52,12 +54,44 @@ class  CexmcRunManagerMessenger : public G4UImessenger
 
         G4UIcmdWithAString *       setEventDataVerboseLevel;
 
+        G4UIcmdWithADouble *       setTargetAccError;
+
+        G4UIcmdWithAnInteger *     setPrecisionCheckInterval;
+
+        G4UIcmdWithAnInteger *     setEventBudget;
+
+        G4UIcmdWithADoubleAndUnit *  setTimeBudget;
+
 #ifdef CEXMC_USE_PERSISTENCY
         G4UIcmdWithAnInteger *     replayEvents;
 
         G4UIcmdWithAnInteger *     seekTo;
 
         G4UIcmdWithABool *         skipInteractionsWithoutEDT;
+
+        G4UIcmdWithAString *       setEventDataFormat;
+
+        G4UIcmdWithAString *       setEventDataCodec;
+
+        G4UIcmdWithADoubleAndUnit *  setCalorimeterEDFloor;
+
+        G4UIcmdWithAnInteger *     setCheckpointInterval;
+
+#ifdef CEXMC_USE_THREADS
+        G4UIcmdWithAnInteger *     setReplayThreads;
+#endif
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        G4UIcmdWithAString *       saveEventsSelection;
+
+        G4UIcmdWithAString *       useEventsSelection;
+#endif
+#endif
+
+#ifdef CEXMC_USE_PROFILER
+        G4UIcmdWithABool *         enableProfiler;
+
+        G4UIcmdWithAString *       setProfilerOutputFile;
 #endif
 
         G4UIcmdWithoutParameter *  registerScenePrimitives;
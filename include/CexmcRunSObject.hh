@@ -33,7 +33,7 @@
 #include "CexmcCommon.hh"
 
 
-#define CEXMC_RUN_SOBJECT_VERSION 4
+#define CEXMC_RUN_SOBJECT_VERSION 7
 
 
 struct  CexmcRunSObject
@@ -168,6 +168,12 @@ struct  CexmcRunSObject
 
     CexmcEDCollectionAlgoritm            edCollectionAlgorithm;
 
+    CexmcEventDataFormat                 eventDataFormat;
+
+    G4double                             calorimeterEDFloor;
+
+    CexmcEventDataCodec                  eventDataCodec;
+
     unsigned int                         actualVersion;
 
     template  < typename  Archive >
@@ -251,6 +257,18 @@ void  CexmcRunSObject::serialize( Archive &  archive,
         archive & expectedMomentumAmp;
         archive & edCollectionAlgorithm;
     }
+    if ( version > 4 )
+        archive & eventDataFormat;
+    else
+        eventDataFormat = CexmcBoostArchiveEventDataFormat;
+    if ( version > 5 )
+        archive & calorimeterEDFloor;
+    else
+        calorimeterEDFloor = 0;
+    if ( version > 6 )
+        archive & eventDataCodec;
+    else
+        eventDataCodec = CexmcNoEventDataCodec;
 
     actualVersion = version;
 }
@@ -23,8 +23,10 @@
 #include <G4AffineTransform.hh>
 #include <G4ThreeVector.hh>
 #include <G4RotationMatrix.hh>
+#include <G4NavigationHistory.hh>
 #include <G4String.hh>
 #include "CexmcSensitiveDetectorsAttributes.hh"
+#include "CexmcCommon.hh"
 
 class  G4GDMLParser;
 class  G4LogicalVolume;
@@ -84,6 +86,15 @@ class  CexmcSetup : public G4VUserDetectorConstruction
 
         G4bool  IsRightCalorimeter( const G4VPhysicalVolume *  pVolume ) const;
 
+        /* finds side, row and column of the calorimeter crystal where the
+         * navigation history ends: crystals and rows are replicas shared by
+         * both calorimeters, so the crystal is only known from replica
+         * numbers of the last two levels and the calorimeter volume above
+         * them */
+        void    GetCalorimeterCrystal( const G4NavigationHistory *  history,
+                                       CexmcSide &  side, G4int &  row,
+                                       G4int &  column ) const;
+
     private:
         void    SetupSpecialVolumes( const G4GDMLParser &  gdmlParser );
 
@@ -199,5 +210,19 @@ inline G4bool  CexmcSetup::IsRightCalorimeter(
 }
 
 
+inline void  CexmcSetup::GetCalorimeterCrystal(
+                                    const G4NavigationHistory *  history,
+                                    CexmcSide &  side, G4int &  row,
+                                    G4int &  column ) const
+{
+    G4int  depth( history->GetDepth() );
+
+    side = history->GetVolume( depth - 2 ) == rightCalorimeter ? CexmcRight :
+                                                                 CexmcLeft;
+    row = history->GetReplicaNo( depth - 1 );
+    column = history->GetReplicaNo( depth );
+}
+
+
 #endif
 
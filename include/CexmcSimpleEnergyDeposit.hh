@@ -55,7 +55,6 @@ class  CexmcSimpleEnergyDeposit : public CexmcPrimitiveScorer
     protected:
         CexmcEnergyDepositCollection *  eventMap;
 
-    private:
         G4int                           hcId;
 };
 
@@ -30,6 +30,7 @@ class  CexmcProductionModelData;
 class  CexmcSimpleProductionModelDataStore
 {
     friend class  boost::serialization::access;
+    friend class  CexmcColumnarEventsStore;
 #ifdef CEXMC_USE_CUSTOM_FILTER
     friend class  CexmcASTEval;
 #endif
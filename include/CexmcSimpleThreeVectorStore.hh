@@ -28,6 +28,7 @@
 class  CexmcSimpleThreeVectorStore
 {
     friend class  boost::serialization::access;
+    friend class  CexmcColumnarEventsStore;
 #ifdef CEXMC_USE_CUSTOM_FILTER
     friend class  CexmcASTEval;
 #endif
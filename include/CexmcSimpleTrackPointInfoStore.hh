@@ -31,6 +31,7 @@ class  CexmcTrackPointInfo;
 class  CexmcSimpleTrackPointInfoStore
 {
     friend class  boost::serialization::access;
+    friend class  CexmcColumnarEventsStore;
 #ifdef CEXMC_USE_CUSTOM_FILTER
     friend class  CexmcASTEval;
 #endif
@@ -0,0 +1,168 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcStageProfiler.hh
+ *
+ *    Description:  timing of stages of the event pipeline
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 21:12:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifndef CEXMC_STAGE_PROFILER_HH
+#define CEXMC_STAGE_PROFILER_HH
+
+#ifdef CEXMC_USE_PROFILER
+
+#include <vector>
+#include <time.h>
+#include <G4String.hh>
+
+
+enum  CexmcProfiledStage
+{
+    CexmcEventStage,
+    CexmcPrimaryGenerationStage,
+    CexmcTransportStage,
+    CexmcEDDigitizationStage,
+    CexmcTPDigitizationStage,
+    CexmcReconstructionStage,
+    CexmcSaveEventStage,
+    CexmcHistoFillingStage,
+    CexmcReadEventStage,
+    CexmcProfiledStage_SIZE
+};
+
+
+class  CexmcStageProfiler
+{
+    private:
+        struct  CexmcStageData
+        {
+            CexmcStageData();
+
+            G4bool                isStarted;
+
+            G4double              start;
+
+            G4int                 count;
+
+            G4double              total;
+
+            G4double              max;
+
+            /* durations are binned logarithmically, this makes possible
+             * percentiles without storing all measured durations */
+            std::vector< G4int >  buckets;
+        };
+
+    public:
+        static CexmcStageProfiler *  Instance( void );
+
+        static void                  Destroy( void );
+
+    private:
+        CexmcStageProfiler();
+
+    public:
+        void    Enable( G4bool  on = true );
+
+        void    SetOutputFileName( const G4String &  value );
+
+        void    Reset( void );
+
+        void    Start( CexmcProfiledStage  stage );
+
+        void    Stop( CexmcProfiledStage  stage );
+
+        void    PrintResults( void ) const;
+
+        /* appends results of the run to the output file */
+        void    SaveResults( G4int  runId ) const;
+
+        G4bool  IsEnabled( void ) const;
+
+    public:
+        /* returns monotonic time in nanoseconds */
+        static G4double  GetTime( void );
+
+    private:
+        static G4double  GetPercentile( const CexmcStageData &  data,
+                                        G4double  fraction );
+
+        void             Record( CexmcStageData &  data, G4double  duration );
+
+    private:
+        G4bool           isEnabled;
+
+        G4String         outputFileName;
+
+        CexmcStageData   stages[ CexmcProfiledStage_SIZE ];
+
+    private:
+        static CexmcStageProfiler *  instance;
+};
+
+
+inline void  CexmcStageProfiler::Start( CexmcProfiledStage  stage )
+{
+    if ( ! isEnabled )
+        return;
+
+    stages[ stage ].isStarted = true;
+    stages[ stage ].start = GetTime();
+}
+
+
+inline void  CexmcStageProfiler::Stop( CexmcProfiledStage  stage )
+{
+    /* stopping a stage which was not started (e.g. transport in replay mode)
+     * is legal and does nothing */
+    if ( ! isEnabled || ! stages[ stage ].isStarted )
+        return;
+
+    stages[ stage ].isStarted = false;
+    Record( stages[ stage ], GetTime() - stages[ stage ].start );
+}
+
+
+inline G4bool  CexmcStageProfiler::IsEnabled( void ) const
+{
+    return isEnabled;
+}
+
+
+inline G4double  CexmcStageProfiler::GetTime( void )
+{
+    struct timespec  ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return G4double( ts.tv_sec ) * 1e9 + ts.tv_nsec;
+}
+
+
+#define CEXMC_PROFILER_START( stage ) \
+    CexmcStageProfiler::Instance()->Start( stage )
+
+#define CEXMC_PROFILER_STOP( stage ) \
+    CexmcStageProfiler::Instance()->Stop( stage )
+
+#else
+
+/* the profiler costs nothing when it was not built */
+#define CEXMC_PROFILER_START( stage )
+
+#define CEXMC_PROFILER_STOP( stage )
+
+#endif
+
+#endif
+
@@ -22,8 +22,10 @@
 #include <G4VDigitizerModule.hh>
 #include "CexmcTrackPointInfo.hh"
 #include "CexmcSetup.hh"
+#include "CexmcHitsCollectionIds.hh"
 
 class  G4String;
+class  G4HCofThisEvent;
 
 
 class  CexmcTrackPointsDigitizer : public G4VDigitizerModule
@@ -34,6 +36,10 @@ class  CexmcTrackPointsDigitizer : public G4VDigitizerModule
     public:
         void  Digitize( void );
 
+        /* digitizes hits collections of hcOfThisEvent, the current event is
+         * digitized if hcOfThisEvent is NULL */
+        void  Digitize( G4HCofThisEvent *  hcOfThisEvent );
+
     public:
         const CexmcTrackPointInfo &  GetMonitorTP( void ) const;
 
@@ -84,6 +90,8 @@ class  CexmcTrackPointsDigitizer : public G4VDigitizerModule
 
     private:
         CexmcSetup::CalorimeterGeometryData  calorimeterGeometry;
+
+        CexmcHitsCollectionIds               hcIds;
 };
 
 
@@ -18,7 +18,7 @@
 
 #ifdef CEXMC_USE_CUSTOM_FILTER
 
-#include <numeric>
+#include <sstream>
 #include <boost/variant/get.hpp>
 #include <G4SystemOfUnits.hh>
 #include "CexmcASTEval.hh"
@@ -117,6 +117,84 @@ namespace
     const std::string  CexmcCFVarConst_mm( "mm" );
     const std::string  CexmcCFVarConst_cm( "cm" );
     const std::string  CexmcCFVarConst_m( "m" );
+
+
+    /* functions which take a calorimeter collection as the first argument
+     * and return a scalar */
+    bool  IsEDCollectionAggregate( const CexmcAST::Function &  fun )
+    {
+        return fun == "Sum" || fun == "Max" || fun == "ArgMaxRow" ||
+               fun == "ArgMaxCol" || fun == "Count";
+    }
+
+
+    void  WriteSubtreeKey( std::ostream &  out,
+                           const CexmcAST::Subtree &  ast );
+
+
+    void  WriteNodeKey( std::ostream &  out, const CexmcAST::Node &  node )
+    {
+        const CexmcAST::Subtree *  ast( boost::get< CexmcAST::Subtree >(
+                                                                    &node ) );
+        if ( ast )
+        {
+            WriteSubtreeKey( out, *ast );
+            return;
+        }
+
+        const CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >(
+                                                                    node ) );
+        const CexmcAST::Variable *  var( boost::get< CexmcAST::Variable >(
+                                                                    &leaf ) );
+        if ( var )
+        {
+            out << var->name << "[" << var->index1 << "," << var->index2 << "]";
+            return;
+        }
+
+        const CexmcAST::Constant &  constant( boost::get< CexmcAST::Constant >(
+                                                                    leaf ) );
+        const int *                 intConstant( boost::get< int >(
+                                                                &constant ) );
+        if ( intConstant )
+            out << "i" << *intConstant;
+        else
+            out << "d" << boost::get< double >( constant );
+    }
+
+
+    void  WriteSubtreeKey( std::ostream &  out, const CexmcAST::Subtree &  ast )
+    {
+        const CexmcAST::Operator *  op( boost::get< CexmcAST::Operator >(
+                                                                &ast.type ) );
+        out << "(";
+
+        if ( op )
+            out << "op" << op->type;
+        else
+            out << boost::get< CexmcAST::Function >( ast.type );
+
+        for ( std::vector< CexmcAST::Node >::const_iterator
+                    k( ast.children.begin() ); k != ast.children.end(); ++k )
+        {
+            out << " ";
+            WriteNodeKey( out, *k );
+        }
+
+        out << ")";
+    }
+
+
+    /* identical subexpressions have identical keys */
+    std::string  GetSubtreeKey( const CexmcAST::Subtree &  ast )
+    {
+        std::ostringstream  out;
+
+        out.precision( 17 );
+        WriteSubtreeKey( out, ast );
+
+        return out.str();
+    }
 }
 
 
@@ -136,20 +214,37 @@ CexmcAST::BasicEval::ScalarValueType  CexmcASTEval::GetFunScalarValue(
     const CexmcAST::Function &  fun( boost::get< CexmcAST::Function >(
                                                                 ast.type ) );
 
-    if ( fun == "Sum" )
+    if ( fun == "Count" )
     {
-        CexmcEnergyDepositCalorimeterCollection  edCol;
+        if ( ast.children.size() != 2 )
+            throw CexmcException( CexmcCFUnexpectedFunction );
+
+        ScalarValueType  threshold( GetScalarValue( ast.children[ 1 ] ) );
+        const int *      intThreshold( boost::get< int >( &threshold ) );
+
+        CexmcEnergyDepositCalorimeterView  edCol;
         GetEDCollectionValue( ast.children[ 0 ], edCol );
 
-        G4double  result( 0. );
+        return edCol.Count( intThreshold ? *intThreshold :
+                                    boost::get< double >( threshold ) );
+    }
 
-        for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                                    k( edCol.begin() ); k != edCol.end(); ++k )
-        {
-            result += std::accumulate( k->begin(), k->end(), G4double( 0. ) );
-        }
+    if ( ast.children.size() != 1 )
+        throw CexmcException( CexmcCFUnexpectedFunction );
 
-        return result;
+    if ( IsEDCollectionAggregate( fun ) )
+    {
+        CexmcEnergyDepositCalorimeterView  edCol;
+        GetEDCollectionValue( ast.children[ 0 ], edCol );
+
+        if ( fun == "Max" )
+            return edCol.Max();
+        if ( fun == "ArgMaxRow" )
+            return edCol.ArgMaxRow();
+        if ( fun == "ArgMaxCol" )
+            return edCol.ArgMaxColumn();
+
+        return edCol.Sum();
     }
 
     bool             evalResult( false );
@@ -202,11 +297,11 @@ CexmcAST::BasicEval::ScalarValueType  CexmcASTEval::GetVarScalarValue(
         {
             if ( *addr )
             {
-                if ( ( *addr )->size() == 0 )
+                if ( ( *addr )->IsEmpty() )
                     throw CexmcException( CexmcCFUninitializedVector );
                 if ( var.index1 == 0 || var.index2 == 0 )
                     throw CexmcException( CexmcCFUnexpectedVectorIndex );
-                return ( *addr )->at( var.index1 - 1 ).at( var.index2 - 1 );
+                return ( *addr )->At( var.index1 - 1, var.index2 - 1 );
             }
         }
         else
@@ -233,7 +328,7 @@ CexmcAST::BasicEval::ScalarValueType  CexmcASTEval::GetVarScalarValue(
 
 
 void  CexmcASTEval::GetEDCollectionValue( const CexmcAST::Node &  node,
-                        CexmcEnergyDepositCalorimeterCollection &  edCol ) const
+                        CexmcEnergyDepositCalorimeterView &  edCol ) const
 {
     if ( evSObject == NULL )
         throw CexmcException( CexmcCFUninitialized );
@@ -242,48 +337,42 @@ void  CexmcASTEval::GetEDCollectionValue( const CexmcAST::Node &  node,
 
     if ( ast )
     {
-        const CexmcAST::Function &  fun( boost::get< CexmcAST::Function >(
-                                                                ast->type ) );
+        const CexmcAST::Function *  fun( boost::get< CexmcAST::Function >(
+                                                                &ast->type ) );
+        if ( ! fun )
+            throw CexmcException( CexmcCFUnexpectedContext );
+
+        if ( ast->children.size() != 1 )
+            throw CexmcException( CexmcCFUnexpectedFunction );
 
-        if ( fun == "Inner" )
+        if ( *fun == "Inner" )
         {
             GetEDCollectionValue( ast->children[ 0 ], edCol );
-            edCol.pop_back();
-            edCol.erase( edCol.begin() );
-            for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                            k( edCol.begin() ); k != edCol.end(); ++k )
-            {
-                k->pop_back();
-                k->erase( k->begin() );
-            }
+            edCol.Inner();
             return;
         }
-        if ( fun == "Outer" )
+        if ( *fun == "Outer" )
         {
             GetEDCollectionValue( ast->children[ 0 ], edCol );
-            if ( edCol.size() < 3 )
-                return;
-            for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                            k( edCol.begin() + 1 ); k != edCol.end() - 1; ++k )
-            {
-                if ( k->size() < 3 )
-                    continue;
-                k->erase( k->begin() + 1, k->end() - 1 );
-            }
+            edCol.Outer();
             return;
         }
+
+        throw CexmcException( CexmcCFUnexpectedFunction );
     }
     else
     {
         const CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >(
                                                                     node ) );
-        const CexmcAST::Variable &  var( boost::get< CexmcAST::Variable >(
-                                                                    leaf ) );
+        const CexmcAST::Variable *  var( boost::get< CexmcAST::Variable >(
+                                                                    &leaf ) );
+        if ( ! var )
+            throw CexmcException( CexmcCFUnexpectedContext );
 
-        if ( var.index1 != 0 || var.index2 != 0 )
+        if ( var->index1 != 0 || var->index2 != 0 )
             throw CexmcException( CexmcCFUnexpectedVariableUsage );
 
-        VarAddrMap::const_iterator  found( varAddrMap.find( var.name ) );
+        VarAddrMap::const_iterator  found( varAddrMap.find( var->name ) );
 
         if ( found == varAddrMap.end() )
             throw CexmcException( CexmcCFUnexpectedVariable );
@@ -298,7 +387,7 @@ void  CexmcASTEval::GetEDCollectionValue( const CexmcAST::Node &  node,
         else
         {
             if ( *addr )
-                edCol = **addr;
+                edCol.Reset( *addr );
             return;
         }
     }
@@ -874,39 +963,10 @@ void  CexmcASTEval::BindAddresses( CexmcAST::Subtree &  ast )
                         &evSObject->productionModelData.nucleusOutputParticle;
                     break;
                 }
-                if ( var->name == CexmcCFVarConst_eV )
-                {
-                    var->addr = &constants[ 0 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_keV )
-                {
-                    var->addr = &constants[ 1 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_MeV )
-                {
-                    var->addr = &constants[ 2 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_GeV )
+                const G4double *  constant( FindConstant( var->name ) );
+                if ( constant )
                 {
-                    var->addr = &constants[ 3 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_mm )
-                {
-                    var->addr = &constants[ 4 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_cm )
-                {
-                    var->addr = &constants[ 5 ];
-                    break;
-                }
-                if ( var->name == CexmcCFVarConst_m )
-                {
-                    var->addr = &constants[ 6 ];
+                    var->addr = constant;
                     break;
                 }
             } while ( false );
@@ -937,5 +997,648 @@ void  CexmcASTEval::ResetAddressBinding( CexmcAST::Subtree &  ast )
     }
 }
 
-#endif
 
+const G4double *  CexmcASTEval::FindConstant( const std::string &  name )
+{
+    do
+    {
+        if ( name == CexmcCFVarConst_eV )
+            return &constants[ 0 ];
+        if ( name == CexmcCFVarConst_keV )
+            return &constants[ 1 ];
+        if ( name == CexmcCFVarConst_MeV )
+            return &constants[ 2 ];
+        if ( name == CexmcCFVarConst_GeV )
+            return &constants[ 3 ];
+        if ( name == CexmcCFVarConst_mm )
+            return &constants[ 4 ];
+        if ( name == CexmcCFVarConst_cm )
+            return &constants[ 5 ];
+        if ( name == CexmcCFVarConst_m )
+            return &constants[ 6 ];
+    } while ( false );
+
+    return NULL;
+}
+
+
+void  CexmcASTEval::FoldConstants( CexmcAST::Subtree &  ast ) const
+{
+    /* the root of the expression is never replaced as far as the expression
+     * must be a subtree */
+    const CexmcAST::Function *  fun( boost::get< CexmcAST::Function >(
+                                                                &ast.type ) );
+    if ( fun )
+    {
+        /* the threshold in Count() is a scalar */
+        if ( *fun == "Count" && ast.children.size() == 2 )
+            FoldNode( ast.children[ 1 ] );
+
+        if ( *fun != "Sqr" && *fun != "Sqrt" )
+            return;
+    }
+
+    for ( std::vector< CexmcAST::Node >::iterator  k( ast.children.begin() );
+                                                  k != ast.children.end(); ++k )
+        FoldNode( *k );
+}
+
+
+G4bool  CexmcASTEval::FoldNode( CexmcAST::Node &  node ) const
+{
+    CexmcAST::Subtree *  ast( boost::get< CexmcAST::Subtree >( &node ) );
+
+    if ( ! ast )
+    {
+        CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >( node ) );
+        CexmcAST::Variable *  var( boost::get< CexmcAST::Variable >( &leaf ) );
+
+        if ( ! var )
+            return true;
+
+        const G4double *  constant( FindConstant( var->name ) );
+
+        if ( ! constant )
+            return false;
+
+        leaf = CexmcAST::Constant( *constant );
+
+        return true;
+    }
+
+    const CexmcAST::Operator *  op( boost::get< CexmcAST::Operator >(
+                                                                &ast->type ) );
+    if ( ! op )
+    {
+        /* other functions take collections as arguments, the threshold in
+         * Count() is a scalar */
+        const CexmcAST::Function &  fun( boost::get< CexmcAST::Function >(
+                                                                ast->type ) );
+        if ( fun == "Count" && ast->children.size() == 2 )
+            FoldNode( ast->children[ 1 ] );
+
+        if ( ( fun != "Sqr" && fun != "Sqrt" ) || ast->children.size() != 1 )
+            return false;
+    }
+    else
+    {
+        if ( op->type == CexmcAST::Uninitialized )
+            return false;
+    }
+
+    G4bool  isConstant( true );
+
+    for ( std::vector< CexmcAST::Node >::iterator  k( ast->children.begin() );
+                                                k != ast->children.end(); ++k )
+    {
+        if ( ! FoldNode( *k ) )
+            isConstant = false;
+    }
+
+    if ( op && ! isConstant && ast->children.size() > 1 )
+    {
+        /* constant left operand of & or | may decide the result alone */
+        const CexmcAST::Leaf *      leaf( boost::get< CexmcAST::Leaf >(
+                                                    &ast->children[ 0 ] ) );
+        const CexmcAST::Constant *  left( leaf ?
+                            boost::get< CexmcAST::Constant >( leaf ) : NULL );
+
+        if ( left && ( op->type == CexmcAST::And ||
+                       op->type == CexmcAST::Or ) )
+        {
+            const int *  intLeft( boost::get< int >( left ) );
+            bool         leftValue( intLeft ? *intLeft != 0 :
+                                    boost::get< double >( *left ) != 0 );
+            isConstant = leftValue == ( op->type == CexmcAST::Or );
+        }
+    }
+
+    if ( ! isConstant )
+        return false;
+
+    if ( op && op->type == CexmcAST::Div )
+    {
+        /* integer division by zero is left for run time */
+        const CexmcAST::Constant &  right( boost::get< CexmcAST::Constant >(
+                    boost::get< CexmcAST::Leaf >( ast->children[ 1 ] ) ) );
+        const int *                 intRight( boost::get< int >( &right ) );
+        const CexmcAST::Constant &  left( boost::get< CexmcAST::Constant >(
+                    boost::get< CexmcAST::Leaf >( ast->children[ 0 ] ) ) );
+
+        if ( intRight && *intRight == 0 && boost::get< int >( &left ) )
+            return false;
+    }
+
+    CexmcAST::Constant  value( GetScalarValue( node ) );
+
+    node = CexmcAST::Leaf( value );
+
+    return true;
+}
+
+
+void  CexmcASTEval::RegisterSubexpressions( const CexmcAST::Subtree &  ast,
+                                        CexmcASTProgram::Cache &  cache ) const
+{
+    const CexmcAST::Operator *  op( boost::get< CexmcAST::Operator >(
+                                                                &ast.type ) );
+    if ( op )
+    {
+        if ( op->type != CexmcAST::Top &&
+             op->type != CexmcAST::Uninitialized )
+            cache.AddSubexpression( GetSubtreeKey( ast ) );
+    }
+    else
+    {
+        cache.AddSubexpression( GetSubtreeKey( ast ) );
+    }
+
+    std::vector< CexmcAST::Node >::const_iterator  k( ast.children.begin() );
+
+    /* collections are not cached */
+    if ( ! op && IsEDCollectionAggregate(
+                            boost::get< CexmcAST::Function >( ast.type ) ) &&
+         k != ast.children.end() )
+        ++k;
+
+    for ( ; k != ast.children.end(); ++k )
+    {
+        const CexmcAST::Subtree *  subtree( boost::get< CexmcAST::Subtree >(
+                                                                    &*k ) );
+        if ( subtree )
+            RegisterSubexpressions( *subtree, cache );
+    }
+}
+
+
+void  CexmcASTEval::Compile( const CexmcAST::Subtree &  ast,
+                             CexmcASTProgram &  program ) const
+{
+    program.Clear();
+    program.SetResultType( CompileSubtree( ast, program ) );
+}
+
+
+G4bool  CexmcASTEval::NeedsEventData( const CexmcAST::Subtree &  ast )
+{
+    for ( std::vector< CexmcAST::Node >::const_iterator
+                    k( ast.children.begin() ); k != ast.children.end(); ++k )
+    {
+        const CexmcAST::Subtree *  subtree( boost::get< CexmcAST::Subtree >(
+                                                                    &*k ) );
+        if ( subtree )
+        {
+            if ( NeedsEventData( *subtree ) )
+                return true;
+            continue;
+        }
+
+        const CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >( *k ) );
+        const CexmcAST::Variable *  var( boost::get< CexmcAST::Variable >(
+                                                                    &leaf ) );
+        if ( ! var )
+            continue;
+
+        if ( var->name == CexmcCFVarEvent ||
+             var->name == CexmcCFVarOpCosThetaSCM ||
+             var->name == CexmcCFVarEDT || var->name == CexmcCFVarMon ||
+             FindConstant( var->name ) )
+            continue;
+
+        return true;
+    }
+
+    return false;
+}
+
+
+CexmcASTProgram::ValueType  CexmcASTEval::CompileNode(
+                                        const CexmcAST::Node &  node,
+                                        CexmcASTProgram &  program ) const
+{
+    const CexmcAST::Subtree *  ast( boost::get< CexmcAST::Subtree >( &node ) );
+
+    if ( ast )
+        return CompileSubtree( *ast, program );
+
+    const CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >( node ) );
+    const CexmcAST::Constant *  constant( boost::get< CexmcAST::Constant >(
+                                                                    &leaf ) );
+
+    if ( ! constant )
+        return CompileVariable( boost::get< CexmcAST::Variable >( leaf ),
+                                program );
+
+    const int *  intConstant( boost::get< int >( constant ) );
+
+    if ( intConstant )
+    {
+        program.EmitInt( CexmcASTProgram::PushInt, *intConstant );
+        return CexmcASTProgram::IntValue;
+    }
+
+    program.EmitDouble( CexmcASTProgram::PushDouble,
+                        boost::get< double >( *constant ) );
+
+    return CexmcASTProgram::DoubleValue;
+}
+
+
+CexmcASTProgram::ValueType  CexmcASTEval::CompileSubtree(
+                                        const CexmcAST::Subtree &  ast,
+                                        CexmcASTProgram &  program ) const
+{
+    const CexmcAST::Operator *  op( boost::get< CexmcAST::Operator >(
+                                                                &ast.type ) );
+    CexmcASTProgram::Cache *    cache( program.GetCache() );
+    G4int                       slot( cache ?
+                                      cache->GetSlot( GetSubtreeKey( ast ) ) :
+                                      -1 );
+    if ( slot < 0 )
+        return op ? CompileOperator( ast, program ) :
+                    CompileFunction( ast, program );
+
+    /* the subexpression is computed only when its value has not been cached
+     * for the current event yet */
+    G4int  jump( program.EmitInt( CexmcASTProgram::JumpIfCached, slot ) );
+
+    CexmcASTProgram::ValueType  result( op ? CompileOperator( ast, program ) :
+                                             CompileFunction( ast, program ) );
+
+    program.EmitInt( CexmcASTProgram::StoreCached, slot );
+    program.SetJumpTarget( jump );
+
+    return result;
+}
+
+
+CexmcASTProgram::ValueType  CexmcASTEval::CompileOperator(
+                                        const CexmcAST::Subtree &  ast,
+                                        CexmcASTProgram &  program ) const
+{
+    const CexmcAST::Operator *  op( &boost::get< CexmcAST::Operator >(
+                                                                ast.type ) );
+    if ( op->type == CexmcAST::Uninitialized )
+    {
+        program.EmitInt( CexmcASTProgram::PushInt, 1 );
+        return CexmcASTProgram::IntValue;
+    }
+
+    CexmcASTProgram::ValueType  left( CexmcASTProgram::IntValue );
+
+    if ( ast.children.size() > 0 )
+        left = CompileNode( ast.children[ 0 ], program );
+    else
+        program.EmitInt( CexmcASTProgram::PushInt, 0 );
+
+    switch ( op->type )
+    {
+    case CexmcAST::Top :
+        return left;
+    case CexmcAST::UMinus :
+        program.Emit( left == CexmcASTProgram::DoubleValue ?
+                      CexmcASTProgram::NegDouble : CexmcASTProgram::NegInt );
+        return left;
+    case CexmcAST::Not :
+        program.Emit( left == CexmcASTProgram::DoubleValue ?
+                      CexmcASTProgram::NotDouble : CexmcASTProgram::NotInt );
+        return CexmcASTProgram::IntValue;
+    case CexmcAST::And :
+    case CexmcAST::Or :
+        {
+            /* if the jump is taken then the tested left value (0 or 1) is
+             * the result */
+            program.Emit( left == CexmcASTProgram::DoubleValue ?
+                          CexmcASTProgram::TestDouble :
+                          CexmcASTProgram::TestInt );
+            G4int  jump( program.Emit( op->type == CexmcAST::And ?
+                                       CexmcASTProgram::JumpIfFalse :
+                                       CexmcASTProgram::JumpIfTrue ) );
+            CexmcASTProgram::ValueType  right( CompileNode(
+                                                ast.children[ 1 ], program ) );
+            program.Emit( right == CexmcASTProgram::DoubleValue ?
+                          CexmcASTProgram::TestDouble :
+                          CexmcASTProgram::TestInt );
+            program.SetJumpTarget( jump );
+        }
+        return CexmcASTProgram::IntValue;
+    default :
+        break;
+    }
+
+    CexmcASTProgram::ValueType  right( CexmcASTProgram::IntValue );
+
+    if ( ast.children.size() > 1 )
+        right = CompileNode( ast.children[ 1 ], program );
+    else
+        program.EmitInt( CexmcASTProgram::PushInt, 0 );
+
+    CexmcASTProgram::OpCode  opCode( CexmcASTProgram::MultInt );
+    G4bool                   isArithmetic( false );
+
+    switch ( op->type )
+    {
+    case CexmcAST::Mult :
+        opCode = CexmcASTProgram::MultInt;
+        isArithmetic = true;
+        break;
+    case CexmcAST::Div :
+        opCode = CexmcASTProgram::DivInt;
+        isArithmetic = true;
+        break;
+    case CexmcAST::Plus :
+        opCode = CexmcASTProgram::PlusInt;
+        isArithmetic = true;
+        break;
+    case CexmcAST::Minus :
+        opCode = CexmcASTProgram::MinusInt;
+        isArithmetic = true;
+        break;
+    case CexmcAST::Less :
+        opCode = CexmcASTProgram::LessInt;
+        break;
+    case CexmcAST::LessEq :
+        opCode = CexmcASTProgram::LessEqInt;
+        break;
+    case CexmcAST::More :
+        opCode = CexmcASTProgram::MoreInt;
+        break;
+    case CexmcAST::MoreEq :
+        opCode = CexmcASTProgram::MoreEqInt;
+        break;
+    case CexmcAST::Eq :
+        opCode = CexmcASTProgram::EqInt;
+        break;
+    case CexmcAST::NotEq :
+        opCode = CexmcASTProgram::NotEqInt;
+        break;
+    default :
+        throw CexmcException( CexmcCFUnexpectedContext );
+    }
+
+    if ( left == CexmcASTProgram::IntValue &&
+         right == CexmcASTProgram::IntValue )
+    {
+        program.Emit( opCode );
+        return CexmcASTProgram::IntValue;
+    }
+
+    if ( left == CexmcASTProgram::IntValue )
+        program.Emit( CexmcASTProgram::IntToDoubleBelowTop );
+    if ( right == CexmcASTProgram::IntValue )
+        program.Emit( CexmcASTProgram::IntToDouble );
+
+    /* double versions of binary operations follow int versions in the same
+     * order */
+    program.Emit( CexmcASTProgram::OpCode( opCode +
+                CexmcASTProgram::MultDouble - CexmcASTProgram::MultInt ) );
+
+    return isArithmetic ? CexmcASTProgram::DoubleValue :
+                          CexmcASTProgram::IntValue;
+}
+
+
+CexmcASTProgram::ValueType  CexmcASTEval::CompileFunction(
+                                        const CexmcAST::Subtree &  ast,
+                                        CexmcASTProgram &  program ) const
+{
+    const CexmcAST::Function &  fun( boost::get< CexmcAST::Function >(
+                                                                ast.type ) );
+
+    if ( fun == "Count" )
+    {
+        if ( ast.children.size() != 2 )
+        {
+            program.EmitInt( CexmcASTProgram::Throw,
+                             CexmcCFUnexpectedFunction );
+            return CexmcASTProgram::IntValue;
+        }
+
+        /* the threshold is computed before the collection as far as the
+         * program has only one collection view */
+        if ( CompileNode( ast.children[ 1 ], program ) ==
+                                                    CexmcASTProgram::IntValue )
+            program.Emit( CexmcASTProgram::IntToDouble );
+
+        CompileEDCollection( ast.children[ 0 ], program );
+        program.Emit( CexmcASTProgram::EDColCount );
+
+        return CexmcASTProgram::IntValue;
+    }
+
+    if ( ast.children.size() != 1 )
+    {
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedFunction );
+        return CexmcASTProgram::IntValue;
+    }
+
+    if ( IsEDCollectionAggregate( fun ) )
+    {
+        CompileEDCollection( ast.children[ 0 ], program );
+
+        if ( fun == "Max" )
+        {
+            program.Emit( CexmcASTProgram::EDColMax );
+            return CexmcASTProgram::DoubleValue;
+        }
+        if ( fun == "ArgMaxRow" )
+        {
+            program.Emit( CexmcASTProgram::EDColArgMaxRow );
+            return CexmcASTProgram::IntValue;
+        }
+        if ( fun == "ArgMaxCol" )
+        {
+            program.Emit( CexmcASTProgram::EDColArgMaxColumn );
+            return CexmcASTProgram::IntValue;
+        }
+
+        program.Emit( CexmcASTProgram::EDColSum );
+        return CexmcASTProgram::DoubleValue;
+    }
+
+    CexmcASTProgram::ValueType  arg( CompileNode( ast.children[ 0 ],
+                                                  program ) );
+
+    if ( fun == "Sqr" )
+    {
+        program.Emit( arg == CexmcASTProgram::DoubleValue ?
+                      CexmcASTProgram::SqrDouble : CexmcASTProgram::SqrInt );
+        return arg;
+    }
+    if ( fun == "Sqrt" )
+    {
+        if ( arg == CexmcASTProgram::IntValue )
+            program.Emit( CexmcASTProgram::IntToDouble );
+        program.Emit( CexmcASTProgram::SqrtDouble );
+        return CexmcASTProgram::DoubleValue;
+    }
+
+    /* like in the tree evaluator, the argument is evaluated before the
+     * unknown function is reported */
+    program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedFunction );
+
+    return CexmcASTProgram::IntValue;
+}
+
+
+CexmcASTProgram::ValueType  CexmcASTEval::CompileVariable(
+                                        const CexmcAST::Variable &  var,
+                                        CexmcASTProgram &  program ) const
+{
+    if ( evFastSObject == NULL || evSObject == NULL )
+    {
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUninitialized );
+        return CexmcASTProgram::IntValue;
+    }
+
+    /* bound to CexmcAST::Variable:addr */
+
+    const double * const *  addr( boost::get< const double * >( &var.addr ) );
+
+    if ( addr )
+    {
+        if ( *addr )
+        {
+            program.EmitAddr( CexmcASTProgram::LoadDouble, *addr );
+            return CexmcASTProgram::DoubleValue;
+        }
+    }
+    else
+    {
+        const int * const &  addr( boost::get< const int * >( var.addr ) );
+
+        if ( addr )
+        {
+            program.EmitAddr( CexmcASTProgram::LoadInt, addr );
+            return CexmcASTProgram::IntValue;
+        }
+    }
+
+    /* found in varAddrMap */
+
+    VarAddrMap::const_iterator  found( varAddrMap.find( var.name ) );
+
+    if ( found != varAddrMap.end() )
+    {
+        const CexmcEnergyDepositCalorimeterCollection * const *  addr(
+                boost::get< const CexmcEnergyDepositCalorimeterCollection * >(
+                                                            &found->second ) );
+        if ( addr )
+        {
+            if ( *addr )
+            {
+                program.EmitAddr( CexmcASTProgram::LoadEDColElement, *addr,
+                                  var.index1, var.index2 );
+                return CexmcASTProgram::DoubleValue;
+            }
+        }
+        else
+        {
+            const bool * const &  addr( boost::get< const bool * >(
+                                                            found->second ) );
+            if ( addr )
+            {
+                program.EmitAddr( CexmcASTProgram::LoadBool, addr );
+                return CexmcASTProgram::IntValue;
+            }
+        }
+    }
+
+    /* Variables without address */
+
+    if ( var.name == CexmcCFVarTPT )
+    {
+        program.EmitAddr( CexmcASTProgram::LoadTrackIdIsValid,
+                          &evSObject->targetTPOutputParticle.trackId );
+        return CexmcASTProgram::IntValue;
+    }
+
+    program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedVariable );
+
+    return CexmcASTProgram::IntValue;
+}
+
+
+void  CexmcASTEval::CompileEDCollection( const CexmcAST::Node &  node,
+                                         CexmcASTProgram &  program ) const
+{
+    if ( evSObject == NULL )
+    {
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUninitialized );
+        return;
+    }
+
+    const CexmcAST::Subtree *  ast( boost::get< CexmcAST::Subtree >( &node ) );
+
+    if ( ast )
+    {
+        const CexmcAST::Function *  fun( boost::get< CexmcAST::Function >(
+                                                                &ast->type ) );
+        if ( ! fun )
+        {
+            program.EmitInt( CexmcASTProgram::Throw,
+                             CexmcCFUnexpectedContext );
+            return;
+        }
+        if ( ast->children.size() != 1 )
+        {
+            program.EmitInt( CexmcASTProgram::Throw,
+                             CexmcCFUnexpectedFunction );
+            return;
+        }
+        if ( *fun == "Inner" )
+        {
+            CompileEDCollection( ast->children[ 0 ], program );
+            program.Emit( CexmcASTProgram::EDColInner );
+            return;
+        }
+        if ( *fun == "Outer" )
+        {
+            CompileEDCollection( ast->children[ 0 ], program );
+            program.Emit( CexmcASTProgram::EDColOuter );
+            return;
+        }
+
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedFunction );
+        return;
+    }
+
+    const CexmcAST::Leaf &      leaf( boost::get< CexmcAST::Leaf >( node ) );
+    const CexmcAST::Variable *  var( boost::get< CexmcAST::Variable >(
+                                                                    &leaf ) );
+
+    if ( ! var )
+    {
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedContext );
+        return;
+    }
+
+    if ( var->index1 != 0 || var->index2 != 0 )
+    {
+        program.EmitInt( CexmcASTProgram::Throw,
+                         CexmcCFUnexpectedVariableUsage );
+        return;
+    }
+
+    VarAddrMap::const_iterator  found( varAddrMap.find( var->name ) );
+
+    if ( found == varAddrMap.end() )
+    {
+        program.EmitInt( CexmcASTProgram::Throw, CexmcCFUnexpectedVariable );
+        return;
+    }
+
+    const CexmcEnergyDepositCalorimeterCollection * const *  addr(
+            boost::get< const CexmcEnergyDepositCalorimeterCollection * >(
+                                                        &found->second ) );
+    if ( ! addr )
+    {
+        program.EmitInt( CexmcASTProgram::Throw,
+                         CexmcCFUnexpectedVariableUsage );
+        return;
+    }
+
+    program.EmitAddr( CexmcASTProgram::LoadEDCol, *addr );
+}
+
+#endif
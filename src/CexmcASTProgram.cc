@@ -0,0 +1,787 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcASTProgram.cc
+ *
+ *    Description:  custom filter expressions compiled into a flat bytecode
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 22:31:52
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include <iomanip>
+#include <cmath>
+#include <G4ios.hh>
+#include "CexmcASTProgram.hh"
+
+
+namespace
+{
+    const char *  opCodeNames[] =
+    {
+        "pushi", "pushd", "loadi", "loadd", "loadb", "loadtid", "loadcole",
+        "loadcol", "colinner", "colouter", "colsum", "colmax", "colmaxrow",
+        "colmaxcol", "colcount", "i2d", "i2d2", "negi", "negd", "noti", "notd",
+        "muli", "divi", "addi", "subi", "lti", "lei", "gti", "gei", "eqi",
+        "nei", "muld", "divd", "addd", "subd", "ltd", "led", "gtd", "ged",
+        "eqd", "ned", "sqri", "sqrd", "sqrtd", "testi", "testd", "jz", "jnz",
+        "jcached", "store", "throw"
+    };
+
+
+    /* change of the stack depth after an instruction (for jumps - when the
+     * jump is not taken) */
+    G4int  GetStackEffect( CexmcASTProgram::OpCode  op )
+    {
+        switch ( op )
+        {
+        case CexmcASTProgram::PushInt :
+        case CexmcASTProgram::PushDouble :
+        case CexmcASTProgram::LoadInt :
+        case CexmcASTProgram::LoadDouble :
+        case CexmcASTProgram::LoadBool :
+        case CexmcASTProgram::LoadTrackIdIsValid :
+        case CexmcASTProgram::LoadEDColElement :
+        case CexmcASTProgram::EDColSum :
+        case CexmcASTProgram::EDColMax :
+        case CexmcASTProgram::EDColArgMaxRow :
+        case CexmcASTProgram::EDColArgMaxColumn :
+        case CexmcASTProgram::Throw :
+            return 1;
+        case CexmcASTProgram::LoadEDCol :
+        case CexmcASTProgram::EDColInner :
+        case CexmcASTProgram::EDColOuter :
+        case CexmcASTProgram::EDColCount :
+        case CexmcASTProgram::IntToDouble :
+        case CexmcASTProgram::IntToDoubleBelowTop :
+        case CexmcASTProgram::NegInt :
+        case CexmcASTProgram::NegDouble :
+        case CexmcASTProgram::NotInt :
+        case CexmcASTProgram::NotDouble :
+        case CexmcASTProgram::SqrInt :
+        case CexmcASTProgram::SqrDouble :
+        case CexmcASTProgram::SqrtDouble :
+        case CexmcASTProgram::TestInt :
+        case CexmcASTProgram::TestDouble :
+        case CexmcASTProgram::JumpIfCached :
+        case CexmcASTProgram::StoreCached :
+            return 0;
+        default :
+            break;
+        }
+
+        return -1;
+    }
+
+
+    G4bool  IsBatchable( CexmcASTProgram::OpCode  op )
+    {
+        switch ( op )
+        {
+        case CexmcASTProgram::LoadEDColElement :
+        case CexmcASTProgram::LoadEDCol :
+        case CexmcASTProgram::EDColInner :
+        case CexmcASTProgram::EDColOuter :
+        case CexmcASTProgram::EDColSum :
+        case CexmcASTProgram::EDColMax :
+        case CexmcASTProgram::EDColArgMaxRow :
+        case CexmcASTProgram::EDColArgMaxColumn :
+        case CexmcASTProgram::EDColCount :
+        case CexmcASTProgram::DivInt :
+        case CexmcASTProgram::JumpIfCached :
+        case CexmcASTProgram::StoreCached :
+        case CexmcASTProgram::Throw :
+            return false;
+        default :
+            break;
+        }
+
+        return true;
+    }
+}
+
+
+CexmcASTProgram::Cache::Cache() : generation( 1 )
+{
+}
+
+
+void  CexmcASTProgram::Cache::Clear( void )
+{
+    slots.clear();
+    values.clear();
+    generations.clear();
+    generation = 1;
+}
+
+
+void  CexmcASTProgram::Cache::AddSubexpression( const std::string &  key )
+{
+    ++slots[ key ];
+}
+
+
+void  CexmcASTProgram::Cache::AssignSlots( void )
+{
+    G4int  nmbOfSlots( 0 );
+
+    for ( std::map< std::string, G4int >::iterator  k( slots.begin() );
+                                                        k != slots.end(); )
+    {
+        if ( k->second < 2 )
+        {
+            slots.erase( k++ );
+            continue;
+        }
+        k->second = nmbOfSlots++;
+        ++k;
+    }
+
+    values.resize( nmbOfSlots );
+    generations.assign( nmbOfSlots, 0 );
+}
+
+
+G4int  CexmcASTProgram::Cache::GetSlot( const std::string &  key ) const
+{
+    std::map< std::string, G4int >::const_iterator  found( slots.find( key ) );
+
+    if ( found == slots.end() )
+        return -1;
+
+    return found->second;
+}
+
+
+CexmcASTProgram::CexmcASTProgram() : resultType( IntValue ), depth( 0 ),
+    cache( NULL ), canRunBatch( true )
+{
+}
+
+
+void  CexmcASTProgram::Clear( void )
+{
+    code.clear();
+    resultType = IntValue;
+    depth = 0;
+    canRunBatch = true;
+}
+
+
+CexmcASTProgram::Instruction &  CexmcASTProgram::Append( OpCode  op )
+{
+    Instruction  instruction;
+
+    instruction.op = op;
+    instruction.operand.doubleValue = 0;
+    instruction.arg1 = 0;
+    instruction.arg2 = 0;
+
+    code.push_back( instruction );
+
+    canRunBatch = canRunBatch && IsBatchable( op );
+
+    depth += GetStackEffect( op );
+    if ( depth > G4int( stack.size() ) )
+        stack.resize( depth );
+
+    return code.back();
+}
+
+
+G4int  CexmcASTProgram::Emit( OpCode  op )
+{
+    Append( op );
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitInt( OpCode  op, G4int  value )
+{
+    Append( op ).operand.intValue = value;
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitDouble( OpCode  op, G4double  value )
+{
+    Append( op ).operand.doubleValue = value;
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitAddr( OpCode  op, const G4int *  addr )
+{
+    Append( op ).operand.intAddr = addr;
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitAddr( OpCode  op, const G4double *  addr )
+{
+    Append( op ).operand.doubleAddr = addr;
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitAddr( OpCode  op, const G4bool *  addr )
+{
+    Append( op ).operand.boolAddr = addr;
+
+    return code.size() - 1;
+}
+
+
+G4int  CexmcASTProgram::EmitAddr( OpCode  op,
+                        const CexmcEnergyDepositCalorimeterCollection *  addr,
+                        G4int  index1, G4int  index2 )
+{
+    Instruction &  instruction( Append( op ) );
+
+    instruction.operand.edColAddr = addr;
+    instruction.arg1 = index1;
+    instruction.arg2 = index2;
+
+    return code.size() - 1;
+}
+
+
+void  CexmcASTProgram::SetJumpTarget( G4int  pos )
+{
+    code[ pos ].arg1 = code.size();
+
+    /* the value which was tested by the jump is on the stack in both paths,
+     * the cached value replaces the computed value */
+    if ( code[ pos ].op != JumpIfCached )
+        ++depth;
+}
+
+
+bool  CexmcASTProgram::Run( void ) const
+{
+    if ( code.empty() )
+        return true;
+
+    Value *              s( &stack[ 0 ] );
+    G4int                sp( -1 );
+    const Instruction *  begin( &code[ 0 ] );
+    const Instruction *  end( begin + code.size() );
+
+    for ( const Instruction *  k( begin ); k < end; ++k )
+    {
+        switch ( k->op )
+        {
+        case PushInt :
+            s[ ++sp ].intValue = k->operand.intValue;
+            break;
+        case PushDouble :
+            s[ ++sp ].doubleValue = k->operand.doubleValue;
+            break;
+        case LoadInt :
+            s[ ++sp ].intValue = *k->operand.intAddr;
+            break;
+        case LoadDouble :
+            s[ ++sp ].doubleValue = *k->operand.doubleAddr;
+            break;
+        case LoadBool :
+            s[ ++sp ].intValue = G4int( *k->operand.boolAddr );
+            break;
+        case LoadTrackIdIsValid :
+            s[ ++sp ].intValue = G4int( *k->operand.intAddr !=
+                                        CexmcInvalidTrackId );
+            break;
+        case LoadEDColElement :
+            if ( k->operand.edColAddr->IsEmpty() )
+                throw CexmcException( CexmcCFUninitializedVector );
+            if ( k->arg1 == 0 || k->arg2 == 0 )
+                throw CexmcException( CexmcCFUnexpectedVectorIndex );
+            s[ ++sp ].doubleValue = k->operand.edColAddr->At( k->arg1 - 1,
+                                                              k->arg2 - 1 );
+            break;
+        case LoadEDCol :
+            edCol.Reset( k->operand.edColAddr );
+            break;
+        case EDColInner :
+            edCol.Inner();
+            break;
+        case EDColOuter :
+            edCol.Outer();
+            break;
+        case EDColSum :
+            s[ ++sp ].doubleValue = edCol.Sum();
+            break;
+        case EDColMax :
+            s[ ++sp ].doubleValue = edCol.Max();
+            break;
+        case EDColArgMaxRow :
+            s[ ++sp ].intValue = edCol.ArgMaxRow();
+            break;
+        case EDColArgMaxColumn :
+            s[ ++sp ].intValue = edCol.ArgMaxColumn();
+            break;
+        case EDColCount :
+            /* the threshold is on the stack */
+            s[ sp ].intValue = edCol.Count( s[ sp ].doubleValue );
+            break;
+        case IntToDouble :
+            s[ sp ].doubleValue = s[ sp ].intValue;
+            break;
+        case IntToDoubleBelowTop :
+            s[ sp - 1 ].doubleValue = s[ sp - 1 ].intValue;
+            break;
+        case NegInt :
+            s[ sp ].intValue = - s[ sp ].intValue;
+            break;
+        case NegDouble :
+            s[ sp ].doubleValue = - s[ sp ].doubleValue;
+            break;
+        case NotInt :
+            s[ sp ].intValue = ! s[ sp ].intValue;
+            break;
+        case NotDouble :
+            s[ sp ].intValue = ! s[ sp ].doubleValue;
+            break;
+        case MultInt :
+            --sp;
+            s[ sp ].intValue *= s[ sp + 1 ].intValue;
+            break;
+        case DivInt :
+            --sp;
+            s[ sp ].intValue /= s[ sp + 1 ].intValue;
+            break;
+        case PlusInt :
+            --sp;
+            s[ sp ].intValue += s[ sp + 1 ].intValue;
+            break;
+        case MinusInt :
+            --sp;
+            s[ sp ].intValue -= s[ sp + 1 ].intValue;
+            break;
+        case LessInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue < s[ sp + 1 ].intValue;
+            break;
+        case LessEqInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue <= s[ sp + 1 ].intValue;
+            break;
+        case MoreInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue > s[ sp + 1 ].intValue;
+            break;
+        case MoreEqInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue >= s[ sp + 1 ].intValue;
+            break;
+        case EqInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue == s[ sp + 1 ].intValue;
+            break;
+        case NotEqInt :
+            --sp;
+            s[ sp ].intValue = s[ sp ].intValue != s[ sp + 1 ].intValue;
+            break;
+        case MultDouble :
+            --sp;
+            s[ sp ].doubleValue *= s[ sp + 1 ].doubleValue;
+            break;
+        case DivDouble :
+            --sp;
+            s[ sp ].doubleValue /= s[ sp + 1 ].doubleValue;
+            break;
+        case PlusDouble :
+            --sp;
+            s[ sp ].doubleValue += s[ sp + 1 ].doubleValue;
+            break;
+        case MinusDouble :
+            --sp;
+            s[ sp ].doubleValue -= s[ sp + 1 ].doubleValue;
+            break;
+        case LessDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue < s[ sp + 1 ].doubleValue;
+            break;
+        case LessEqDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue <= s[ sp + 1 ].doubleValue;
+            break;
+        case MoreDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue > s[ sp + 1 ].doubleValue;
+            break;
+        case MoreEqDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue >= s[ sp + 1 ].doubleValue;
+            break;
+        case EqDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue == s[ sp + 1 ].doubleValue;
+            break;
+        case NotEqDouble :
+            --sp;
+            s[ sp ].intValue = s[ sp ].doubleValue != s[ sp + 1 ].doubleValue;
+            break;
+        case SqrInt :
+            s[ sp ].intValue *= s[ sp ].intValue;
+            break;
+        case SqrDouble :
+            s[ sp ].doubleValue *= s[ sp ].doubleValue;
+            break;
+        case SqrtDouble :
+            s[ sp ].doubleValue = std::sqrt( s[ sp ].doubleValue );
+            break;
+        case TestInt :
+            s[ sp ].intValue = s[ sp ].intValue != 0;
+            break;
+        case TestDouble :
+            s[ sp ].intValue = s[ sp ].doubleValue != 0;
+            break;
+        case JumpIfFalse :
+            if ( s[ sp ].intValue == 0 )
+                k = begin + k->arg1 - 1;
+            else
+                --sp;
+            break;
+        case JumpIfTrue :
+            if ( s[ sp ].intValue != 0 )
+                k = begin + k->arg1 - 1;
+            else
+                --sp;
+            break;
+        case JumpIfCached :
+            if ( cache->generations[ k->operand.intValue ] ==
+                                                        cache->generation )
+            {
+                s[ ++sp ] = cache->values[ k->operand.intValue ];
+                k = begin + k->arg1 - 1;
+            }
+            break;
+        case StoreCached :
+            cache->values[ k->operand.intValue ] = s[ sp ];
+            cache->generations[ k->operand.intValue ] = cache->generation;
+            break;
+        case Throw :
+            throw CexmcException( CexmcExceptionType( k->operand.intValue ) );
+        default :
+            break;
+        }
+    }
+
+    return resultType == DoubleValue ? bool( s[ 0 ].doubleValue ) :
+                                       bool( s[ 0 ].intValue );
+}
+
+
+void  CexmcASTProgram::RunBatch( const char *  origin, size_t  size,
+                                 const char *  base, size_t  stride,
+                                 G4int  count,
+                                 std::vector< unsigned char > &  result ) const
+{
+    result.assign( count > 0 ? count : 0, 1 );
+
+    if ( code.empty() || count <= 0 )
+        return;
+
+    if ( ! canRunBatch )
+        throw CexmcException( CexmcWeirdException );
+
+    if ( batchStack.size() < stack.size() )
+        batchStack.resize( stack.size() );
+    for ( std::vector< std::vector< Value > >::iterator
+            k( batchStack.begin() ); k != batchStack.end(); ++k )
+        k->resize( count );
+
+    G4int  sp( -1 );
+    G4int  nmbOfJumps( 0 );
+    G4int  nmbOfInstructions( code.size() );
+
+    for ( G4int  i( 0 ); ; ++i )
+    {
+        /* paths of the pending jumps which lead here join: records for
+         * which a jump would have been taken get the value tested by the
+         * jump */
+        while ( nmbOfJumps > 0 && batchJumps[ nmbOfJumps - 1 ].target == i )
+        {
+            const BatchJump &  jump( batchJumps[ --nmbOfJumps ] );
+            const Value *      a( &jump.value[ 0 ] );
+            Value *            b( &batchStack[ jump.slot ][ 0 ] );
+
+            for ( G4int  j( 0 ); j < count; ++j )
+            {
+                if ( ( a[ j ].intValue != 0 ) == jump.ifTrue )
+                    b[ j ] = a[ j ];
+            }
+        }
+
+        if ( i >= nmbOfInstructions )
+            break;
+
+        const Instruction &  k( code[ i ] );
+        const char *         addr( NULL );
+        Value *              a( sp >= 0 ? &batchStack[ sp ][ 0 ] : NULL );
+        Value *              b( NULL );
+
+        switch ( k.op )
+        {
+        case PushInt :
+            a = &batchStack[ ++sp ][ 0 ];
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = k.operand.intValue;
+            break;
+        case PushDouble :
+            a = &batchStack[ ++sp ][ 0 ];
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = k.operand.doubleValue;
+            break;
+        case LoadInt :
+        case LoadTrackIdIsValid :
+            a = &batchStack[ ++sp ][ 0 ];
+            addr = GetBatchAddr( k.operand.intAddr, origin, size, base );
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = addr ? *reinterpret_cast< const G4int * >(
+                                                        addr + j * stride ) :
+                                         *k.operand.intAddr;
+            if ( k.op == LoadTrackIdIsValid )
+            {
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue != CexmcInvalidTrackId;
+            }
+            break;
+        case LoadDouble :
+            a = &batchStack[ ++sp ][ 0 ];
+            addr = GetBatchAddr( k.operand.doubleAddr, origin, size, base );
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = addr ?
+                            *reinterpret_cast< const G4double * >(
+                                                        addr + j * stride ) :
+                            *k.operand.doubleAddr;
+            break;
+        case LoadBool :
+            a = &batchStack[ ++sp ][ 0 ];
+            addr = GetBatchAddr( k.operand.boolAddr, origin, size, base );
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = G4int( addr ?
+                            *reinterpret_cast< const G4bool * >(
+                                                        addr + j * stride ) :
+                            *k.operand.boolAddr );
+            break;
+        case IntToDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = a[ j ].intValue;
+            break;
+        case IntToDoubleBelowTop :
+            a = &batchStack[ sp - 1 ][ 0 ];
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = a[ j ].intValue;
+            break;
+        case NegInt :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = - a[ j ].intValue;
+            break;
+        case NegDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = - a[ j ].doubleValue;
+            break;
+        case NotInt :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = ! a[ j ].intValue;
+            break;
+        case NotDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = ! a[ j ].doubleValue;
+            break;
+        case SqrInt :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue *= a[ j ].intValue;
+            break;
+        case SqrDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue *= a[ j ].doubleValue;
+            break;
+        case SqrtDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].doubleValue = std::sqrt( a[ j ].doubleValue );
+            break;
+        case TestInt :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = a[ j ].intValue != 0;
+            break;
+        case TestDouble :
+            for ( G4int  j( 0 ); j < count; ++j )
+                a[ j ].intValue = a[ j ].doubleValue != 0;
+            break;
+        case JumpIfFalse :
+        case JumpIfTrue :
+            /* the value is kept until the paths join and the jump is not
+             * taken for now */
+            if ( nmbOfJumps >= G4int( batchJumps.size() ) )
+                batchJumps.resize( nmbOfJumps + 1 );
+            batchJumps[ nmbOfJumps ].target = k.arg1;
+            batchJumps[ nmbOfJumps ].slot = sp;
+            batchJumps[ nmbOfJumps ].ifTrue = k.op == JumpIfTrue;
+            batchJumps[ nmbOfJumps ].value.assign( a, a + count );
+            ++nmbOfJumps;
+            --sp;
+            break;
+        default :
+            /* binary operators */
+            b = a;
+            a = &batchStack[ --sp ][ 0 ];
+            switch ( k.op )
+            {
+            case MultInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue *= b[ j ].intValue;
+                break;
+            case PlusInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue += b[ j ].intValue;
+                break;
+            case MinusInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue -= b[ j ].intValue;
+                break;
+            case LessInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue < b[ j ].intValue;
+                break;
+            case LessEqInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue <= b[ j ].intValue;
+                break;
+            case MoreInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue > b[ j ].intValue;
+                break;
+            case MoreEqInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue >= b[ j ].intValue;
+                break;
+            case EqInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue == b[ j ].intValue;
+                break;
+            case NotEqInt :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].intValue != b[ j ].intValue;
+                break;
+            case MultDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].doubleValue *= b[ j ].doubleValue;
+                break;
+            case DivDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].doubleValue /= b[ j ].doubleValue;
+                break;
+            case PlusDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].doubleValue += b[ j ].doubleValue;
+                break;
+            case MinusDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].doubleValue -= b[ j ].doubleValue;
+                break;
+            case LessDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue < b[ j ].doubleValue;
+                break;
+            case LessEqDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue <=
+                                                        b[ j ].doubleValue;
+                break;
+            case MoreDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue > b[ j ].doubleValue;
+                break;
+            case MoreEqDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue >=
+                                                        b[ j ].doubleValue;
+                break;
+            case EqDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue ==
+                                                        b[ j ].doubleValue;
+                break;
+            case NotEqDouble :
+                for ( G4int  j( 0 ); j < count; ++j )
+                    a[ j ].intValue = a[ j ].doubleValue !=
+                                                        b[ j ].doubleValue;
+                break;
+            default :
+                break;
+            }
+            break;
+        }
+    }
+
+    const Value *  a( &batchStack[ 0 ][ 0 ] );
+
+    for ( G4int  j( 0 ); j < count; ++j )
+        result[ j ] = resultType == DoubleValue ? a[ j ].doubleValue != 0 :
+                                                  a[ j ].intValue != 0;
+}
+
+
+void  CexmcASTProgram::Print( void ) const
+{
+    for ( std::vector< Instruction >::const_iterator  k( code.begin() );
+                                                        k != code.end(); ++k )
+    {
+        G4cout << std::setw( 4 ) << k - code.begin() << "  " <<
+                  std::left << std::setw( 10 ) << opCodeNames[ k->op ] <<
+                  std::right;
+
+        switch ( k->op )
+        {
+        case PushInt :
+        case StoreCached :
+        case Throw :
+            G4cout << k->operand.intValue;
+            break;
+        case JumpIfCached :
+            G4cout << k->operand.intValue << " " << k->arg1;
+            break;
+        case PushDouble :
+            G4cout << k->operand.doubleValue;
+            break;
+        case LoadEDColElement :
+            G4cout << k->operand.edColAddr << " [" << k->arg1 << "," <<
+                      k->arg2 << "]";
+            break;
+        case LoadInt :
+        case LoadDouble :
+        case LoadBool :
+        case LoadTrackIdIsValid :
+        case LoadEDCol :
+            G4cout << k->operand.edColAddr;
+            break;
+        case JumpIfFalse :
+        case JumpIfTrue :
+            G4cout << k->arg1;
+            break;
+        default :
+            break;
+        }
+
+        G4cout << G4endl;
+    }
+}
+
+#endif
+
@@ -0,0 +1,193 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcBlockCodec.cc
+ *
+ *    Description:  compression codecs for blocks of events data
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 18:24:02
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <cstring>
+#include <algorithm>
+#include <boost/cstdint.hpp>
+#include "CexmcBlockCodec.hh"
+#include "CexmcException.hh"
+
+
+CexmcBlockCodec::~CexmcBlockCodec()
+{
+}
+
+
+CexmcBlockCodec *  CexmcBlockCodec::Create( CexmcEventDataCodec  codec )
+{
+    switch ( codec )
+    {
+    case CexmcNoEventDataCodec :
+        return NULL;
+    case CexmcLZEventDataCodec :
+        return new CexmcLZBlockCodec;
+    default :
+        break;
+    }
+
+    throw CexmcException( CexmcWeirdException );
+}
+
+
+/* control byte c < 32 starts a run of c + 1 literals, otherwise it starts a
+ * back reference: length - 2 is in the upper 3 bits (7 means that the next
+ * byte must be added), offset - 1 is in the lower 5 bits and the next byte */
+const std::size_t  CexmcLZBlockCodec::maxLiteralRun( 32 );
+
+const std::size_t  CexmcLZBlockCodec::maxMatchLength( 2 + 7 + 255 );
+
+const std::size_t  CexmcLZBlockCodec::maxOffset( 1 << 13 );
+
+const G4int        CexmcLZBlockCodec::hashBits( 14 );
+
+
+void  CexmcLZBlockCodec::PutLiterals( const unsigned char *  data,
+                                      std::size_t  size,
+                                      std::vector< char > &  output )
+{
+    while ( size > 0 )
+    {
+        std::size_t  run( std::min( size, maxLiteralRun ) );
+
+        output.push_back( char( run - 1 ) );
+        output.insert( output.end(), data, data + run );
+        data += run;
+        size -= run;
+    }
+}
+
+
+void  CexmcLZBlockCodec::Compress( const char *  data, std::size_t  size,
+                                   std::vector< char > &  output ) const
+{
+    const unsigned char *  in( reinterpret_cast< const unsigned char * >(
+                                                                    data ) );
+    std::vector< std::size_t >  hashTable( 1 << hashBits, size );
+    std::size_t                 literalsStart( 0 );
+    std::size_t                 i( 0 );
+
+    output.reserve( output.size() + size + size / maxLiteralRun + 1 );
+
+    while ( i + 2 < size )
+    {
+        boost::uint32_t  sequence( in[ i ] << 16 | in[ i + 1 ] << 8 |
+                                   in[ i + 2 ] );
+        std::size_t      hash( boost::uint32_t( sequence * 2654435761U ) >>
+                               ( 32 - hashBits ) );
+        std::size_t      ref( hashTable[ hash ] );
+
+        hashTable[ hash ] = i;
+
+        if ( ref >= i || i - ref > maxOffset || in[ ref ] != in[ i ] ||
+             in[ ref + 1 ] != in[ i + 1 ] || in[ ref + 2 ] != in[ i + 2 ] )
+        {
+            ++i;
+            continue;
+        }
+
+        std::size_t  maxLength( std::min( size - i, maxMatchLength ) );
+        std::size_t  length( 3 );
+
+        while ( length < maxLength && in[ ref + length ] == in[ i + length ] )
+            ++length;
+
+        PutLiterals( in + literalsStart, i - literalsStart, output );
+
+        std::size_t  offset( i - ref - 1 );
+        std::size_t  lengthCode( length - 2 );
+
+        if ( lengthCode < 7 )
+        {
+            output.push_back( char( lengthCode << 5 | offset >> 8 ) );
+        }
+        else
+        {
+            output.push_back( char( 7 << 5 | offset >> 8 ) );
+            output.push_back( char( lengthCode - 7 ) );
+        }
+        output.push_back( char( offset & 0xFF ) );
+
+        i += length;
+        literalsStart = i;
+    }
+
+    PutLiterals( in + literalsStart, size - literalsStart, output );
+}
+
+
+G4bool  CexmcLZBlockCodec::Decompress( const char *  data, std::size_t  size,
+                                       char *  output,
+                                       std::size_t  outputSize ) const
+{
+    const unsigned char *  in( reinterpret_cast< const unsigned char * >(
+                                                                    data ) );
+    const unsigned char *  inEnd( in + size );
+    char *                 out( output );
+    char *                 outEnd( output + outputSize );
+
+    while ( in < inEnd )
+    {
+        std::size_t  control( *in++ );
+
+        if ( control < maxLiteralRun )
+        {
+            std::size_t  run( control + 1 );
+
+            if ( std::size_t( inEnd - in ) < run ||
+                 std::size_t( outEnd - out ) < run )
+                return false;
+
+            std::memcpy( out, in, run );
+            in += run;
+            out += run;
+            continue;
+        }
+
+        std::size_t  length( control >> 5 );
+
+        if ( length == 7 )
+        {
+            if ( in == inEnd )
+                return false;
+            length += *in++;
+        }
+        length += 2;
+
+        if ( in == inEnd )
+            return false;
+
+        std::size_t  offset( ( ( control & 0x1F ) << 8 | *in++ ) + 1 );
+
+        if ( std::size_t( out - output ) < offset ||
+             std::size_t( outEnd - out ) < length )
+            return false;
+
+        /* source and destination may overlap */
+        const char *  ref( out - offset );
+
+        while ( length-- > 0 )
+            *out++ = *ref++;
+    }
+
+    return out == outEnd;
+}
+
+#endif
+
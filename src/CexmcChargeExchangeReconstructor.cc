@@ -69,6 +69,34 @@ CexmcChargeExchangeReconstructor::CexmcChargeExchangeReconstructor(
 }
 
 
+CexmcChargeExchangeReconstructor::CexmcChargeExchangeReconstructor(
+                const CexmcChargeExchangeReconstructor &  reconstructor ) :
+    CexmcReconstructor( reconstructor ), outputParticleMass( 0 ),
+    nucleusOutputParticleMass( 0 ),
+    productionModelData( reconstructor.productionModelData ),
+    useTableMass( reconstructor.useTableMass ),
+    useMassCut( reconstructor.useMassCut ),
+    massCutOPCenter( reconstructor.massCutOPCenter ),
+    massCutNOPCenter( reconstructor.massCutNOPCenter ),
+    massCutOPWidth( reconstructor.massCutOPWidth ),
+    massCutNOPWidth( reconstructor.massCutNOPWidth ),
+    massCutEllipseAngle( reconstructor.massCutEllipseAngle ),
+    useAbsorbedEnergyCut( reconstructor.useAbsorbedEnergyCut ),
+    absorbedEnergyCutCLCenter( reconstructor.absorbedEnergyCutCLCenter ),
+    absorbedEnergyCutCRCenter( reconstructor.absorbedEnergyCutCRCenter ),
+    absorbedEnergyCutCLWidth( reconstructor.absorbedEnergyCutCLWidth ),
+    absorbedEnergyCutCRWidth( reconstructor.absorbedEnergyCutCRWidth ),
+    absorbedEnergyCutEllipseAngle(
+                                reconstructor.absorbedEnergyCutEllipseAngle ),
+    expectedMomentumAmp( reconstructor.expectedMomentumAmp ),
+    edCollectionAlgorithm( reconstructor.edCollectionAlgorithm ),
+    hasMassCutTriggered( false ), hasAbsorbedEnergyCutTriggered( false ),
+    beamParticleIsInitialized( reconstructor.beamParticleIsInitialized ),
+    particleGun( reconstructor.particleGun ), messenger( NULL )
+{
+}
+
+
 CexmcChargeExchangeReconstructor::~CexmcChargeExchangeReconstructor()
 {
     delete messenger;
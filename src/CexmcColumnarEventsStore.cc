@@ -0,0 +1,600 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcColumnarEventsStore.cc
+ *
+ *    Description:  events data in fixed-width column blocks (.cdb file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 16:25:09
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <G4ios.hh>
+#include "CexmcColumnarEventsStore.hh"
+#include "CexmcEventSObject.hh"
+#include "CexmcException.hh"
+
+
+namespace
+{
+    CexmcSimpleTrackPointInfoStore  CexmcEventSObject::*  trackPoints[] =
+    {
+        &CexmcEventSObject::monitorTP,
+        &CexmcEventSObject::targetTPBeamParticle,
+        &CexmcEventSObject::targetTPOutputParticle,
+        &CexmcEventSObject::targetTPNucleusParticle,
+        &CexmcEventSObject::targetTPOutputParticleDecayProductParticle1,
+        &CexmcEventSObject::targetTPOutputParticleDecayProductParticle2,
+        &CexmcEventSObject::vetoCounterTPLeft,
+        &CexmcEventSObject::vetoCounterTPRight,
+        &CexmcEventSObject::calorimeterTPLeft,
+        &CexmcEventSObject::calorimeterTPRight
+    };
+
+    const G4int  nmbOfTrackPoints( sizeof( trackPoints ) /
+                                   sizeof( trackPoints[ 0 ] ) );
+
+    /* 4 three vectors and momentum amplitude */
+    const G4int  trackPointWidth( 13 );
+
+    /* PDG encoding, track id and track type */
+    const G4int  trackPointIdsWidth( 3 );
+
+    /* 8 lorentz vectors */
+    const G4int  productionModelDataWidth( 32 );
+
+    /* PDG encodings of 4 particles */
+    const G4int  productionModelParticlesWidth( 4 );
+
+    /* values are version, block size, number of rows and number of columns
+     * from the header; calorimeter matrices of a block must fit in the data
+     * after the header unless there are no data, so that a corrupt header
+     * cannot lead to accessing memory beyond the data */
+    G4bool  LayoutIsValid( const boost::int32_t *  values,
+                           std::size_t  dataBytes )
+    {
+        if ( values[ 1 ] <= 0 || values[ 2 ] < 0 || values[ 3 ] < 0 )
+            return false;
+
+        if ( dataBytes == 0 )
+            return true;
+
+        boost::uint64_t  nmbOfCells( boost::uint64_t( values[ 2 ] ) *
+                                     boost::uint64_t( values[ 3 ] ) );
+
+        return nmbOfCells <= dataBytes / ( 2 * sizeof( G4double ) ) /
+                                                    std::size_t( values[ 1 ] );
+    }
+}
+
+
+const char            CexmcColumnarEventsStore::magic[] = "CEXMCCDB";
+
+const boost::int32_t  CexmcColumnarEventsStore::version( 1 );
+
+const std::size_t     CexmcColumnarEventsStore::headerSize( 32 );
+
+const std::size_t     CexmcColumnarEventsStore::blockHeaderSize( 8 );
+
+
+CexmcColumnarEventsStore::CexmcColumnarEventsStore(
+                                                const G4String &  fileName ) :
+    forWriting( false ), blockSize( 0 ), nmbOfRows( 0 ), nmbOfColumns( 0 ),
+    nmbOfEvents( 0 ), blockBytes( 0 ), headerIsWritten( false ), fd( -1 ),
+    data( NULL ), dataSize( 0 )
+{
+    fd = open( fileName.c_str(), O_RDONLY );
+    if ( fd == -1 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    struct stat  st;
+    if ( fstat( fd, &st ) != 0 || std::size_t( st.st_size ) < headerSize )
+    {
+        close( fd );
+        throw CexmcException( CexmcReadProjectIncomplete );
+    }
+
+    dataSize = st.st_size;
+
+    void *  addr( mmap( NULL, dataSize, PROT_READ, MAP_SHARED, fd, 0 ) );
+    if ( addr == MAP_FAILED )
+    {
+        close( fd );
+        throw CexmcException( CexmcSystemException );
+    }
+
+    data = static_cast< const char * >( addr );
+
+    boost::int32_t  header[ 4 ];
+    std::memcpy( header, data + 8, sizeof( header ) );
+
+    std::size_t  dataBytes( dataSize - headerSize );
+    G4bool       headerIsValid( std::memcmp( data, magic, 8 ) == 0 &&
+                                header[ 0 ] == version &&
+                                LayoutIsValid( header, dataBytes ) );
+
+    if ( headerIsValid )
+    {
+        blockSize = header[ 1 ];
+        SetupLayout( header[ 2 ], header[ 3 ] );
+
+        std::size_t  nmbOfBlocks( dataBytes / blockBytes );
+
+        if ( nmbOfBlocks > 0 )
+        {
+            boost::int32_t  nmbOfEventsInLastBlock( 0 );
+            std::memcpy( &nmbOfEventsInLastBlock,
+                         data + headerSize + ( nmbOfBlocks - 1 ) * blockBytes,
+                         sizeof( nmbOfEventsInLastBlock ) );
+            headerIsValid = nmbOfEventsInLastBlock >= 0 &&
+                            nmbOfEventsInLastBlock <= blockSize;
+            nmbOfEvents = G4int( nmbOfBlocks - 1 ) * blockSize +
+                          nmbOfEventsInLastBlock;
+        }
+    }
+
+    if ( ! headerIsValid )
+    {
+        munmap( const_cast< char * >( data ), dataSize );
+        close( fd );
+        throw CexmcException( CexmcReadProjectIncomplete );
+    }
+}
+
+
+CexmcColumnarEventsStore::CexmcColumnarEventsStore(
+                                const G4String &  fileName, G4int  blockSize ) :
+    forWriting( true ), blockSize( blockSize > 0 ? blockSize : 1 ),
+    nmbOfRows( 0 ), nmbOfColumns( 0 ), nmbOfEvents( 0 ), blockBytes( 0 ),
+    file( fileName.c_str(), std::ios::out | std::ios::trunc |
+                            std::ios::binary ),
+    headerIsWritten( false ), fd( -1 ), data( NULL ), dataSize( 0 )
+{
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+CexmcColumnarEventsStore::CexmcColumnarEventsStore(
+                                const G4String &  fileName, G4int  blockSize,
+                                G4int  nmbOfEventsToKeep ) :
+    forWriting( true ), blockSize( blockSize > 0 ? blockSize : 1 ),
+    nmbOfRows( 0 ), nmbOfColumns( 0 ), nmbOfEvents( 0 ), blockBytes( 0 ),
+    headerIsWritten( false ), fd( -1 ), data( NULL ), dataSize( 0 )
+{
+    if ( nmbOfEventsToKeep <= 0 )
+    {
+        file.open( fileName.c_str(), std::ios::out | std::ios::trunc |
+                                     std::ios::binary );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+        return;
+    }
+
+    file.open( fileName.c_str(), std::ios::in | std::ios::out |
+                                 std::ios::binary );
+    if ( ! file )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    char            header[ headerSize ];
+    boost::int32_t  values[ 4 ];
+
+    if ( ! file.read( header, headerSize ) ||
+         std::memcmp( header, magic, 8 ) != 0 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    file.seekg( 0, std::ios::end );
+    std::streamoff  size( file.tellg() );
+    file.seekg( headerSize );
+
+    std::memcpy( values, header + 8, sizeof( values ) );
+    if ( values[ 0 ] != version || values[ 1 ] != this->blockSize ||
+         ! LayoutIsValid( values, std::size_t( size ) - headerSize ) )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    SetupLayout( values[ 2 ], values[ 3 ] );
+    block.assign( blockBytes, 0 );
+    headerIsWritten = true;
+
+    G4int           i( nmbOfEventsToKeep % this->blockSize );
+    std::streamoff  blockOffset( headerSize + std::streamoff(
+                        nmbOfEventsToKeep / this->blockSize ) * blockBytes );
+
+    /* the incomplete block was written by Flush(), but it could have been
+     * filled with more events later: these events are cleared */
+    if ( i > 0 )
+    {
+        char *          b( &block[ 0 ] );
+        boost::int32_t  nmbOfEventsInBlock( i );
+
+        file.seekg( blockOffset );
+        if ( ! file.read( b, blockBytes ) )
+            throw CexmcException( CexmcReadProjectIncomplete );
+
+        for ( G4int  k( 0 ); k < NmbOfDoubleColumns; ++k )
+        {
+            G4double *  values_( GetColumn( b, DoubleColumn( k ) ) );
+            std::fill( values_ + i * doubleColumnWidth[ k ],
+                       values_ + this->blockSize * doubleColumnWidth[ k ], 0 );
+        }
+        for ( G4int  k( 0 ); k < NmbOfIntColumns; ++k )
+        {
+            boost::int32_t *  values_( GetColumn( b, IntColumn( k ) ) );
+            std::fill( values_ + i * intColumnWidth[ k ],
+                       values_ + this->blockSize * intColumnWidth[ k ], 0 );
+        }
+        std::memcpy( b, &nmbOfEventsInBlock, sizeof( nmbOfEventsInBlock ) );
+    }
+
+    if ( truncate( fileName.c_str(), blockOffset ) != 0 )
+        throw CexmcException( CexmcSystemException );
+
+    file.seekp( blockOffset );
+    nmbOfEvents = nmbOfEventsToKeep;
+}
+
+
+CexmcColumnarEventsStore::~CexmcColumnarEventsStore()
+{
+    if ( forWriting )
+    {
+        /* exceptions must not leave the destructor: the last write error is
+         * reported here */
+        try
+        {
+            if ( ! headerIsWritten )
+            {
+                SetupLayout( 0, 0 );
+                WriteHeader();
+            }
+            Flush();
+        }
+        catch ( CexmcException &  e )
+        {
+            G4cerr << e.what() << G4endl;
+        }
+        return;
+    }
+
+    if ( data )
+        munmap( const_cast< char * >( data ), dataSize );
+    if ( fd != -1 )
+        close( fd );
+}
+
+
+void  CexmcColumnarEventsStore::SetupLayout( G4int  nmbOfRows_,
+                                             G4int  nmbOfColumns_ )
+{
+    nmbOfRows = nmbOfRows_;
+    nmbOfColumns = nmbOfColumns_;
+
+    for ( G4int  i( 0 ); i < NmbOfDoubleColumns; ++i )
+        doubleColumnWidth[ i ] = 1;
+    doubleColumnWidth[ CalorimeterEDLeftCollection ] = nmbOfRows * nmbOfColumns;
+    doubleColumnWidth[ CalorimeterEDRightCollection ] =
+                                                    nmbOfRows * nmbOfColumns;
+    doubleColumnWidth[ TrackPoints ] = nmbOfTrackPoints * trackPointWidth;
+    doubleColumnWidth[ ProductionModelData ] = productionModelDataWidth;
+
+    for ( G4int  i( 0 ); i < NmbOfIntColumns; ++i )
+        intColumnWidth[ i ] = 1;
+    intColumnWidth[ TrackPointsIds ] = nmbOfTrackPoints * trackPointIdsWidth;
+    intColumnWidth[ ProductionModelParticles ] = productionModelParticlesWidth;
+
+    std::size_t  offset( blockHeaderSize );
+
+    for ( G4int  i( 0 ); i < NmbOfDoubleColumns; ++i )
+    {
+        doubleColumnOffset[ i ] = offset;
+        offset += doubleColumnWidth[ i ] * blockSize * sizeof( G4double );
+    }
+    for ( G4int  i( 0 ); i < NmbOfIntColumns; ++i )
+    {
+        intColumnOffset[ i ] = offset;
+        offset += intColumnWidth[ i ] * blockSize * sizeof( boost::int32_t );
+    }
+
+    /* keep blocks aligned for double columns */
+    blockBytes = ( offset + sizeof( G4double ) - 1 ) / sizeof( G4double ) *
+                                                            sizeof( G4double );
+}
+
+
+void  CexmcColumnarEventsStore::WriteHeader( void )
+{
+    char            header[ headerSize ];
+    boost::int32_t  values[ 4 ] = { version, blockSize, nmbOfRows,
+                                    nmbOfColumns };
+
+    std::memset( header, 0, headerSize );
+    std::memcpy( header, magic, 8 );
+    std::memcpy( header + 8, values, sizeof( values ) );
+    file.write( header, headerSize );
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+
+    block.assign( blockBytes, 0 );
+    headerIsWritten = true;
+}
+
+
+G4double *  CexmcColumnarEventsStore::GetColumn( char *  block_,
+                                                 DoubleColumn  column )
+{
+    return reinterpret_cast< G4double * >(
+                                    block_ + doubleColumnOffset[ column ] );
+}
+
+
+boost::int32_t *  CexmcColumnarEventsStore::GetColumn( char *  block_,
+                                                       IntColumn  column )
+{
+    return reinterpret_cast< boost::int32_t * >(
+                                    block_ + intColumnOffset[ column ] );
+}
+
+
+const G4double *  CexmcColumnarEventsStore::GetColumn( G4int  block_,
+                                            DoubleColumn  column ) const
+{
+    return reinterpret_cast< const G4double * >( data + headerSize +
+                    block_ * blockBytes + doubleColumnOffset[ column ] );
+}
+
+
+const boost::int32_t *  CexmcColumnarEventsStore::GetColumn( G4int  block_,
+                                            IntColumn  column ) const
+{
+    return reinterpret_cast< const boost::int32_t * >( data + headerSize +
+                    block_ * blockBytes + intColumnOffset[ column ] );
+}
+
+
+G4int  CexmcColumnarEventsStore::GetNmbOfEventsInBlock( G4int  block_ ) const
+{
+    return std::min( blockSize, nmbOfEvents - block_ * blockSize );
+}
+
+
+void  CexmcColumnarEventsStore::Write( const CexmcEventSObject &  evSObject )
+{
+    const CexmcEnergyDepositCalorimeterCollection &  edLeft(
+                                    evSObject.calorimeterEDLeftCollection );
+    const CexmcEnergyDepositCalorimeterCollection &  edRight(
+                                    evSObject.calorimeterEDRightCollection );
+
+    if ( ! headerIsWritten )
+    {
+        SetupLayout( edLeft.GetNmbOfRows(), edLeft.GetNmbOfColumns() );
+        WriteHeader();
+    }
+
+    if ( edLeft.GetNmbOfRows() != nmbOfRows ||
+         edRight.GetNmbOfRows() != nmbOfRows ||
+         edLeft.GetNmbOfColumns() != nmbOfColumns ||
+         edRight.GetNmbOfColumns() != nmbOfColumns )
+        throw CexmcException( CexmcWeirdException );
+
+    G4int   i( nmbOfEvents % blockSize );
+    char *  b( &block[ 0 ] );
+
+    if ( i == 0 )
+        std::fill( block.begin(), block.end(), 0 );
+
+    GetColumn( b, MonitorED )[ i ] = evSObject.monitorED;
+    GetColumn( b, VetoCounterEDLeft )[ i ] = evSObject.vetoCounterEDLeft;
+    GetColumn( b, VetoCounterEDRight )[ i ] = evSObject.vetoCounterEDRight;
+    GetColumn( b, CalorimeterEDLeft )[ i ] = evSObject.calorimeterEDLeft;
+    GetColumn( b, CalorimeterEDRight )[ i ] = evSObject.calorimeterEDRight;
+
+    G4double *  edLeftValues( GetColumn( b, CalorimeterEDLeftCollection ) +
+                              i * nmbOfRows * nmbOfColumns );
+    G4double *  edRightValues( GetColumn( b, CalorimeterEDRightCollection ) +
+                               i * nmbOfRows * nmbOfColumns );
+
+    std::copy( edLeft.GetData(), edLeft.GetData() + edLeft.GetSize(),
+               edLeftValues );
+    std::copy( edRight.GetData(), edRight.GetData() + edRight.GetSize(),
+               edRightValues );
+
+    G4double *        tpValues( GetColumn( b, TrackPoints ) +
+                                i * nmbOfTrackPoints * trackPointWidth );
+    boost::int32_t *  tpIds( GetColumn( b, TrackPointsIds ) +
+                             i * nmbOfTrackPoints * trackPointIdsWidth );
+
+    for ( G4int  k( 0 ); k < nmbOfTrackPoints; ++k )
+    {
+        const CexmcSimpleTrackPointInfoStore &  tp(
+                                            evSObject.*trackPoints[ k ] );
+        const CexmcSimpleThreeVectorStore *     vectors[] =
+            { &tp.positionLocal, &tp.positionWorld, &tp.directionLocal,
+              &tp.directionWorld };
+        G4double *        values( tpValues + k * trackPointWidth );
+        boost::int32_t *  ids( tpIds + k * trackPointIdsWidth );
+
+        for ( G4int  l( 0 ); l < 4; ++l )
+        {
+            *values++ = vectors[ l ]->x;
+            *values++ = vectors[ l ]->y;
+            *values++ = vectors[ l ]->z;
+        }
+        *values = tp.momentumAmp;
+        ids[ 0 ] = tp.particlePDGEncoding;
+        ids[ 1 ] = tp.trackId;
+        ids[ 2 ] = tp.trackType;
+    }
+
+    const CexmcSimpleProductionModelDataStore &  pmData(
+                                                evSObject.productionModelData );
+    const CexmcSimpleLorentzVectorStore *        lVectors[] =
+        { &pmData.incidentParticleSCM, &pmData.incidentParticleLAB,
+          &pmData.nucleusParticleSCM, &pmData.nucleusParticleLAB,
+          &pmData.outputParticleSCM, &pmData.outputParticleLAB,
+          &pmData.nucleusOutputParticleSCM, &pmData.nucleusOutputParticleLAB };
+    G4double *        pmValues( GetColumn( b, ProductionModelData ) +
+                                i * productionModelDataWidth );
+    boost::int32_t *  pmParticles( GetColumn( b, ProductionModelParticles ) +
+                                   i * productionModelParticlesWidth );
+
+    for ( G4int  k( 0 ); k < 8; ++k )
+    {
+        *pmValues++ = lVectors[ k ]->px;
+        *pmValues++ = lVectors[ k ]->py;
+        *pmValues++ = lVectors[ k ]->pz;
+        *pmValues++ = lVectors[ k ]->e;
+    }
+    pmParticles[ 0 ] = pmData.incidentParticle;
+    pmParticles[ 1 ] = pmData.nucleusParticle;
+    pmParticles[ 2 ] = pmData.outputParticle;
+    pmParticles[ 3 ] = pmData.nucleusOutputParticle;
+
+    GetColumn( b, EventId )[ i ] = evSObject.eventId;
+    GetColumn( b, EDDigitizerMonitorHasTriggered )[ i ] =
+                                    evSObject.edDigitizerMonitorHasTriggered;
+
+    ++nmbOfEvents;
+
+    boost::int32_t  nmbOfEventsInBlock( i + 1 );
+    std::memcpy( b, &nmbOfEventsInBlock, sizeof( nmbOfEventsInBlock ) );
+
+    if ( nmbOfEventsInBlock == blockSize )
+    {
+        file.write( b, blockBytes );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+    }
+}
+
+
+void  CexmcColumnarEventsStore::Flush( void )
+{
+    if ( ! forWriting || ! headerIsWritten )
+        return;
+
+    /* the incomplete block is written and the write position returns back to
+     * its beginning, so that it will be overwritten by the next Flush() or
+     * when the block gets complete */
+    if ( nmbOfEvents % blockSize != 0 )
+    {
+        file.write( &block[ 0 ], blockBytes );
+        file.seekp( -std::streamoff( blockBytes ), std::ios::cur );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+    }
+
+    file.flush();
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+void  CexmcColumnarEventsStore::Read( G4int  index,
+                                      CexmcEventSObject &  evSObject ) const
+{
+    if ( index < 0 || index >= nmbOfEvents )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    G4int  b( index / blockSize );
+    G4int  i( index % blockSize );
+
+    evSObject.eventId = GetColumn( b, EventId )[ i ];
+    evSObject.edDigitizerMonitorHasTriggered =
+                            GetColumn( b, EDDigitizerMonitorHasTriggered )[ i ];
+    evSObject.monitorED = GetColumn( b, MonitorED )[ i ];
+    evSObject.vetoCounterEDLeft = GetColumn( b, VetoCounterEDLeft )[ i ];
+    evSObject.vetoCounterEDRight = GetColumn( b, VetoCounterEDRight )[ i ];
+    evSObject.calorimeterEDLeft = GetColumn( b, CalorimeterEDLeft )[ i ];
+    evSObject.calorimeterEDRight = GetColumn( b, CalorimeterEDRight )[ i ];
+
+    const G4double *  edLeftValues( GetColumn( b,
+                CalorimeterEDLeftCollection ) + i * nmbOfRows * nmbOfColumns );
+    const G4double *  edRightValues( GetColumn( b,
+                CalorimeterEDRightCollection ) + i * nmbOfRows * nmbOfColumns );
+
+    CexmcEnergyDepositCalorimeterCollection &  edLeft(
+                                    evSObject.calorimeterEDLeftCollection );
+    CexmcEnergyDepositCalorimeterCollection &  edRight(
+                                    evSObject.calorimeterEDRightCollection );
+
+    if ( edLeft.GetNmbOfRows() != nmbOfRows ||
+         edLeft.GetNmbOfColumns() != nmbOfColumns )
+        edLeft.Resize( nmbOfRows, nmbOfColumns );
+    if ( edRight.GetNmbOfRows() != nmbOfRows ||
+         edRight.GetNmbOfColumns() != nmbOfColumns )
+        edRight.Resize( nmbOfRows, nmbOfColumns );
+
+    std::copy( edLeftValues, edLeftValues + edLeft.GetSize(),
+               edLeft.GetData() );
+    std::copy( edRightValues, edRightValues + edRight.GetSize(),
+               edRight.GetData() );
+
+    const G4double *        tpValues( GetColumn( b, TrackPoints ) +
+                                      i * nmbOfTrackPoints * trackPointWidth );
+    const boost::int32_t *  tpIds( GetColumn( b, TrackPointsIds ) +
+                                   i * nmbOfTrackPoints * trackPointIdsWidth );
+
+    for ( G4int  k( 0 ); k < nmbOfTrackPoints; ++k )
+    {
+        CexmcSimpleTrackPointInfoStore &  tp( evSObject.*trackPoints[ k ] );
+        CexmcSimpleThreeVectorStore *     vectors[] =
+            { &tp.positionLocal, &tp.positionWorld, &tp.directionLocal,
+              &tp.directionWorld };
+        const G4double *        values( tpValues + k * trackPointWidth );
+        const boost::int32_t *  ids( tpIds + k * trackPointIdsWidth );
+
+        for ( G4int  l( 0 ); l < 4; ++l )
+        {
+            vectors[ l ]->x = *values++;
+            vectors[ l ]->y = *values++;
+            vectors[ l ]->z = *values++;
+        }
+        tp.momentumAmp = *values;
+        tp.particlePDGEncoding = ids[ 0 ];
+        tp.trackId = ids[ 1 ];
+        tp.trackType = CexmcTrackType( ids[ 2 ] );
+    }
+
+    CexmcSimpleProductionModelDataStore &  pmData(
+                                                evSObject.productionModelData );
+    CexmcSimpleLorentzVectorStore *        lVectors[] =
+        { &pmData.incidentParticleSCM, &pmData.incidentParticleLAB,
+          &pmData.nucleusParticleSCM, &pmData.nucleusParticleLAB,
+          &pmData.outputParticleSCM, &pmData.outputParticleLAB,
+          &pmData.nucleusOutputParticleSCM, &pmData.nucleusOutputParticleLAB };
+    const G4double *        pmValues( GetColumn( b, ProductionModelData ) +
+                                      i * productionModelDataWidth );
+    const boost::int32_t *  pmParticles(
+                            GetColumn( b, ProductionModelParticles ) +
+                            i * productionModelParticlesWidth );
+
+    for ( G4int  k( 0 ); k < 8; ++k )
+    {
+        lVectors[ k ]->px = *pmValues++;
+        lVectors[ k ]->py = *pmValues++;
+        lVectors[ k ]->pz = *pmValues++;
+        lVectors[ k ]->e = *pmValues++;
+    }
+    pmData.incidentParticle = pmParticles[ 0 ];
+    pmData.nucleusParticle = pmParticles[ 1 ];
+    pmData.outputParticle = pmParticles[ 2 ];
+    pmData.nucleusOutputParticle = pmParticles[ 3 ];
+}
+
+#endif
+
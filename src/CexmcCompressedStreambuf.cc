@@ -0,0 +1,376 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcCompressedStreambuf.cc
+ *
+ *    Description:  stream buffers for block-compressed events data files
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 19:05:51
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <cstring>
+#include "CexmcCompressedStreambuf.hh"
+#include "CexmcBlockCodec.hh"
+#include "CexmcException.hh"
+
+
+namespace
+{
+    const char            magic[] = "CEXMCBLK";
+
+    const boost::int32_t  version( 1 );
+
+    const std::size_t     headerSize( 24 );
+
+    /* uncompressed and stored sizes */
+    const std::size_t     blockHeaderSize( 8 );
+}
+
+
+CexmcCompressedOutputStreambuf::CexmcCompressedOutputStreambuf(
+                std::streambuf *  sink, CexmcEventDataCodec  codecType,
+                std::size_t  blockSize ) :
+    sink( sink ), codec( CexmcBlockCodec::Create( codecType ) ),
+    buffer( blockSize > 0 ? blockSize : 1 ), blockStart( 0 ),
+    storedSize( headerSize ), isClosed( false )
+{
+    char            header[ headerSize ];
+    boost::int32_t  values[ 3 ] = { version, codecType,
+                                    boost::int32_t( buffer.size() ) };
+
+    std::memset( header, 0, headerSize );
+    std::memcpy( header, magic, 8 );
+    std::memcpy( header + 8, values, sizeof( values ) );
+
+    if ( sink->sputn( header, headerSize ) != std::streamsize( headerSize ) )
+    {
+        delete codec;
+        throw CexmcException( CexmcSystemException );
+    }
+
+    setp( &buffer[ 0 ], &buffer[ 0 ] + buffer.size() );
+}
+
+
+CexmcCompressedOutputStreambuf::CexmcCompressedOutputStreambuf(
+                std::streambuf *  sink, CexmcEventDataCodec  codecType,
+                boost::int64_t  blockStart, boost::int64_t  storedSize,
+                std::size_t  blockSize ) :
+    sink( sink ), codec( CexmcBlockCodec::Create( codecType ) ),
+    buffer( blockSize > 0 ? blockSize : 1 ), blockStart( blockStart ),
+    storedSize( storedSize ), isClosed( false )
+{
+    setp( &buffer[ 0 ], &buffer[ 0 ] + buffer.size() );
+}
+
+
+CexmcCompressedOutputStreambuf::~CexmcCompressedOutputStreambuf()
+{
+    try
+    {
+        Close();
+    }
+    catch ( ... )
+    {
+    }
+
+    delete codec;
+}
+
+
+void  CexmcCompressedOutputStreambuf::Close( void )
+{
+    if ( isClosed )
+        return;
+
+    isClosed = true;
+    WriteBlock();
+    sink->pubsync();
+}
+
+
+void  CexmcCompressedOutputStreambuf::WriteBlock( void )
+{
+    std::size_t  size( pptr() - pbase() );
+
+    if ( size == 0 )
+        return;
+
+    const char *  data( pbase() );
+    std::size_t   blockStoredSize( size );
+
+    if ( codec )
+    {
+        compressed.clear();
+        codec->Compress( data, size, compressed );
+        if ( compressed.size() < size )
+        {
+            data = &compressed[ 0 ];
+            blockStoredSize = compressed.size();
+        }
+    }
+
+    boost::uint32_t  blockHeader[ 2 ] = { boost::uint32_t( size ),
+                                          boost::uint32_t( blockStoredSize ) };
+
+    if ( sink->sputn( reinterpret_cast< const char * >( blockHeader ),
+                      blockHeaderSize ) != std::streamsize( blockHeaderSize ) ||
+         sink->sputn( data, blockStoredSize ) !=
+                                            std::streamsize( blockStoredSize ) )
+        throw CexmcException( CexmcSystemException );
+
+    blockStart += size;
+    storedSize += blockHeaderSize + blockStoredSize;
+    setp( &buffer[ 0 ], &buffer[ 0 ] + buffer.size() );
+}
+
+
+void  CexmcCompressedOutputStreambuf::GetPendingData(
+                                        std::vector< char > &  data ) const
+{
+    data.assign( pbase(), pptr() );
+}
+
+
+CexmcCompressedOutputStreambuf::int_type
+                    CexmcCompressedOutputStreambuf::overflow( int_type  c )
+{
+    if ( isClosed )
+        return traits_type::eof();
+
+    if ( pptr() == epptr() )
+        WriteBlock();
+
+    if ( ! traits_type::eq_int_type( c, traits_type::eof() ) )
+    {
+        *pptr() = traits_type::to_char_type( c );
+        pbump( 1 );
+    }
+
+    return traits_type::not_eof( c );
+}
+
+
+int  CexmcCompressedOutputStreambuf::sync( void )
+{
+    /* incomplete blocks are never written before closing: all blocks but the
+     * last must be complete */
+    return sink->pubsync();
+}
+
+
+CexmcCompressedOutputStreambuf::pos_type
+                    CexmcCompressedOutputStreambuf::seekoff( off_type  off,
+                                    std::ios_base::seekdir  dir,
+                                    std::ios_base::openmode  which )
+{
+    /* only telling the current position is supported */
+    if ( off != 0 || dir != std::ios_base::cur ||
+         ! ( which & std::ios_base::out ) )
+        return pos_type( off_type( -1 ) );
+
+    return pos_type( blockStart + ( pptr() - pbase() ) );
+}
+
+
+CexmcCompressedOutputStreambuf::pos_type
+                    CexmcCompressedOutputStreambuf::seekpos( pos_type  pos,
+                                    std::ios_base::openmode  which )
+{
+    /* only returning back within the incomplete block is supported */
+    boost::int64_t  target( static_cast< off_type >( pos ) );
+
+    if ( ! ( which & std::ios_base::out ) || target < blockStart ||
+         target > blockStart + ( pptr() - pbase() ) )
+        return pos_type( off_type( -1 ) );
+
+    setp( &buffer[ 0 ], &buffer[ 0 ] + buffer.size() );
+    pbump( int( target - blockStart ) );
+
+    return pos;
+}
+
+
+CexmcCompressedInputStreambuf::CexmcCompressedInputStreambuf(
+                std::streambuf *  source, CexmcEventDataCodec  codecType ) :
+    source( source ), codec( NULL ), blockSize( 0 ), blockStart( 0 ),
+    blocksTableIsBuilt( false )
+{
+    char            header[ headerSize ];
+    boost::int32_t  values[ 3 ];
+
+    if ( source->sgetn( header, headerSize ) != std::streamsize( headerSize ) ||
+         std::memcmp( header, magic, 8 ) != 0 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    std::memcpy( values, header + 8, sizeof( values ) );
+
+    if ( values[ 0 ] != version || values[ 1 ] != codecType ||
+         values[ 2 ] <= 0 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    blockSize = values[ 2 ];
+    codec = CexmcBlockCodec::Create( codecType );
+
+    setg( NULL, NULL, NULL );
+}
+
+
+CexmcCompressedInputStreambuf::~CexmcCompressedInputStreambuf()
+{
+    delete codec;
+}
+
+
+G4bool  CexmcCompressedInputStreambuf::ReadBlock( void )
+{
+    boost::uint32_t  blockHeader[ 2 ];
+
+    if ( source->sgetn( reinterpret_cast< char * >( blockHeader ),
+                        blockHeaderSize ) !=
+                                            std::streamsize( blockHeaderSize ) )
+        return false;
+
+    std::size_t  size( blockHeader[ 0 ] );
+    std::size_t  storedSize( blockHeader[ 1 ] );
+
+    if ( size == 0 || size > blockSize || storedSize > size )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    buffer.resize( blockSize );
+
+    if ( storedSize == size )
+    {
+        if ( source->sgetn( &buffer[ 0 ], size ) != std::streamsize( size ) )
+            throw CexmcException( CexmcReadProjectIncomplete );
+    }
+    else
+    {
+        compressed.resize( storedSize );
+        if ( ! codec || source->sgetn( &compressed[ 0 ], storedSize ) !=
+                                            std::streamsize( storedSize ) ||
+             ! codec->Decompress( &compressed[ 0 ], storedSize, &buffer[ 0 ],
+                                  size ) )
+            throw CexmcException( CexmcReadProjectIncomplete );
+    }
+
+    setg( &buffer[ 0 ], &buffer[ 0 ], &buffer[ 0 ] + size );
+
+    return true;
+}
+
+
+CexmcCompressedInputStreambuf::int_type
+                                CexmcCompressedInputStreambuf::underflow( void )
+{
+    if ( gptr() < egptr() )
+        return traits_type::to_int_type( *gptr() );
+
+    blockStart += egptr() - eback();
+
+    if ( ! ReadBlock() )
+        return traits_type::eof();
+
+    return traits_type::to_int_type( *gptr() );
+}
+
+
+void  CexmcCompressedInputStreambuf::BuildBlocksTable( void )
+{
+    if ( blocksTableIsBuilt )
+        return;
+
+    std::streamoff  offset( headerSize );
+
+    for ( ;; )
+    {
+        boost::uint32_t  blockHeader[ 2 ];
+
+        if ( source->pubseekpos( offset, std::ios_base::in ) !=
+                                                    std::streampos( offset ) ||
+             source->sgetn( reinterpret_cast< char * >( blockHeader ),
+                            blockHeaderSize ) !=
+                                            std::streamsize( blockHeaderSize ) )
+            break;
+
+        blocksTable.push_back( offset );
+        offset += blockHeaderSize + blockHeader[ 1 ];
+    }
+
+    blocksTableIsBuilt = true;
+}
+
+
+CexmcCompressedInputStreambuf::pos_type
+                    CexmcCompressedInputStreambuf::seekoff( off_type  off,
+                                    std::ios_base::seekdir  dir,
+                                    std::ios_base::openmode  which )
+{
+    boost::int64_t  current( blockStart + ( gptr() - eback() ) );
+
+    if ( ! ( which & std::ios_base::in ) )
+        return pos_type( off_type( -1 ) );
+
+    switch ( dir )
+    {
+    case std::ios_base::beg :
+        return seekpos( pos_type( off ), which );
+    case std::ios_base::cur :
+        if ( off == 0 )
+            return pos_type( current );
+        return seekpos( pos_type( current + off ), which );
+    default :
+        break;
+    }
+
+    return pos_type( off_type( -1 ) );
+}
+
+
+CexmcCompressedInputStreambuf::pos_type
+                    CexmcCompressedInputStreambuf::seekpos( pos_type  pos,
+                                    std::ios_base::openmode  which )
+{
+    boost::int64_t  target( static_cast< off_type >( pos ) );
+
+    if ( ! ( which & std::ios_base::in ) || target < 0 )
+        return pos_type( off_type( -1 ) );
+
+    /* the target is in the current block */
+    if ( target >= blockStart && target < blockStart + ( egptr() - eback() ) )
+    {
+        setg( eback(), eback() + ( target - blockStart ), egptr() );
+        return pos;
+    }
+
+    BuildBlocksTable();
+
+    std::size_t  block( target / blockSize );
+
+    if ( block >= blocksTable.size() ||
+         source->pubseekpos( blocksTable[ block ], std::ios_base::in ) !=
+                                    std::streampos( blocksTable[ block ] ) )
+        return pos_type( off_type( -1 ) );
+
+    blockStart = boost::int64_t( block ) * blockSize;
+
+    if ( ! ReadBlock() || target - blockStart > egptr() - eback() )
+        return pos_type( off_type( -1 ) );
+
+    setg( eback(), eback() + ( target - blockStart ), egptr() );
+
+    return pos;
+}
+
+#endif
+
@@ -154,6 +154,17 @@ namespace  CexmcCustomFilter
     }
 
 
+    void  Compiler::operator()( Node &  self, Node &  child1, Node &  child2,
+                                std::string &  value ) const
+    {
+        Subtree &  ast( boost::get< Subtree >( self ) );
+
+        ast.children.push_back( child1 );
+        ast.children.push_back( child2 );
+        ast.type = value;
+    }
+
+
     void  Compiler::operator()( Leaf &  self, std::string &  name ) const
     {
         Variable &  variable( boost::get< Variable >( self ) );
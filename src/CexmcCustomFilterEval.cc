@@ -20,17 +20,29 @@
 
 #include <fstream>
 #include <string>
+#ifdef CEXMC_USE_PROFILER
+#include <iomanip>
+#endif
+#include <G4ios.hh>
 #include "CexmcCustomFilterEval.hh"
 #include "CexmcException.hh"
+#include "CexmcCommon.hh"
 
 
 CexmcCustomFilterEval::CexmcCustomFilterEval( const G4String &  sourceFileName,
                                   const CexmcEventFastSObject *  evFastSObject,
                                   const CexmcEventSObject *  evSObject ) :
-    astEval( evFastSObject, evSObject )
+    astEval( evFastSObject, evSObject ), fastTPTCanRunBatch( true ),
+    fastAstEval( &fastRecord, &noEventData )
+#ifdef CEXMC_USE_PROFILER
+    , sourceFileName( sourceFileName ), isProfiled( false ),
+    nmbOfNotMatchedTPT( 0 ), nmbOfNotMatchedEDT( 0 )
+#endif
 {
     std::string     command;
     std::ifstream   sourceFile( sourceFileName );
+    G4int           lineNmb( 0 );
+    G4int           commandLineNmb( 0 );
 
     if ( ! sourceFile )
         throw CexmcException( CexmcCFBadSource );
@@ -41,6 +53,7 @@ CexmcCustomFilterEval::CexmcCustomFilterEval( const G4String &  sourceFileName,
     {
         std::string  line;
         std::getline( sourceFile, line );
+        ++lineNmb;
 
         size_t  commentStartPos( line.find_first_of( '#' ) );
         if ( commentStartPos != std::string::npos )
@@ -57,6 +70,9 @@ CexmcCustomFilterEval::CexmcCustomFilterEval( const G4String &  sourceFileName,
             continue;
         }
 
+        if ( ! commandIsPending )
+            commandLineNmb = lineNmb;
+
         command += line;
 
         size_t  length( command.length() );
@@ -93,6 +109,9 @@ CexmcCustomFilterEval::CexmcCustomFilterEval( const G4String &  sourceFileName,
         curParseResult.expression.Print();
 #endif
 
+        astEval.FoldConstants( curParseResult.expression );
+        curParseResult.sourceLine = commandLineNmb;
+
         switch ( curParseResult.action )
         {
         case CexmcCustomFilter::KeepTPT :
@@ -115,19 +134,28 @@ CexmcCustomFilterEval::CexmcCustomFilterEval( const G4String &  sourceFileName,
 
     if ( commandIsPending )
         throw CexmcException( CexmcCFParseError );
+
+    CompileFastTPT();
+    Compile();
+
+    PrintFastTPTInfo( sourceFileName );
+
+#ifdef CEXMC_USE_PROFILER
+    ResetProfile();
+#endif
 }
 
 
 void  CexmcCustomFilterEval::SetAddressedData(
-                                const CexmcEventFastSObject *  evFastSObject,
-                                const CexmcEventSObject *  evSObject )
+                                const CexmcEventFastSObject *  evFastSObject_,
+                                const CexmcEventSObject *  evSObject_ )
 {
-    astEval.SetAddressedData( evFastSObject, evSObject );
+    astEval.SetAddressedData( evFastSObject_, evSObject_ );
 
     for ( ParseResultVector::iterator  k( parseResultTPT.begin() );
           k != parseResultTPT.end(); ++k )
     {
-        if ( evFastSObject == NULL || evSObject == NULL )
+        if ( evFastSObject_ == NULL || evSObject_ == NULL )
             astEval.ResetAddressBinding( k->expression );
         else
             astEval.BindAddresses( k->expression );
@@ -135,39 +163,296 @@ void  CexmcCustomFilterEval::SetAddressedData(
     for ( ParseResultVector::iterator  k( parseResultEDT.begin() );
           k != parseResultEDT.end(); ++k )
     {
-        if ( evFastSObject == NULL || evSObject == NULL )
+        if ( evFastSObject_ == NULL || evSObject_ == NULL )
             astEval.ResetAddressBinding( k->expression );
         else
             astEval.BindAddresses( k->expression );
     }
+
+    Compile();
 }
 
 
-bool  CexmcCustomFilterEval::EvalTPT( void ) const
+void  CexmcCustomFilterEval::Compile( void )
 {
+    programsTPT.resize( parseResultTPT.size() );
+    programsEDT.resize( parseResultEDT.size() );
+
+    cache.Clear();
+
+    for ( ParseResultVector::iterator  k( parseResultTPT.begin() );
+          k != parseResultTPT.end(); ++k )
+        astEval.RegisterSubexpressions( k->expression, cache );
+    for ( ParseResultVector::iterator  k( parseResultEDT.begin() );
+          k != parseResultEDT.end(); ++k )
+        astEval.RegisterSubexpressions( k->expression, cache );
+
+    cache.AssignSlots();
+
+    for ( ParseResultVector::size_type  i( 0 ); i < parseResultTPT.size(); ++i )
+    {
+        programsTPT[ i ].SetCache( &cache );
+        astEval.Compile( parseResultTPT[ i ].expression, programsTPT[ i ] );
+    }
+
+    for ( ParseResultVector::size_type  i( 0 ); i < parseResultEDT.size(); ++i )
+    {
+        programsEDT[ i ].SetCache( &cache );
+        astEval.Compile( parseResultEDT[ i ].expression, programsEDT[ i ] );
+    }
+
+#ifdef CEXMC_DEBUG_CF
+    for ( ProgramVector::size_type  i( 0 ); i < programsTPT.size(); ++i )
+    {
+        G4cout << "Compiled TPT expression " << i + 1 << ":" << G4endl;
+        programsTPT[ i ].Print();
+    }
+    for ( ProgramVector::size_type  i( 0 ); i < programsEDT.size(); ++i )
+    {
+        G4cout << "Compiled EDT expression " << i + 1 << ":" << G4endl;
+        programsEDT[ i ].Print();
+    }
+#endif
+}
+
+
+void  CexmcCustomFilterEval::CompileFastTPT( void )
+{
+    /* an expression which needs events data may match before a following
+     * fast expression, so only the leading fast expressions can decide */
     for ( ParseResultVector::const_iterator  k( parseResultTPT.begin() );
           k != parseResultTPT.end(); ++k )
     {
-        if ( astEval( k->expression ) )
-            return k->action == CexmcCustomFilter::KeepTPT;
+        if ( CexmcASTEval::NeedsEventData( k->expression ) )
+            break;
+        parseResultFastTPT.push_back( *k );
+    }
+
+    programsFastTPT.resize( parseResultFastTPT.size() );
+
+    for ( ParseResultVector::size_type  i( 0 ); i < parseResultFastTPT.size();
+          ++i )
+    {
+        fastAstEval.BindAddresses( parseResultFastTPT[ i ].expression );
+        fastAstEval.Compile( parseResultFastTPT[ i ].expression,
+                             programsFastTPT[ i ] );
+        fastTPTCanRunBatch = fastTPTCanRunBatch &&
+                             programsFastTPT[ i ].CanRunBatch();
+    }
+
+#ifdef CEXMC_DEBUG_CF
+    for ( ProgramVector::size_type  i( 0 ); i < programsFastTPT.size(); ++i )
+    {
+        G4cout << "Compiled fast TPT expression " << i + 1 << ":" << G4endl;
+        programsFastTPT[ i ].Print();
+    }
+#endif
+}
+
+
+void  CexmcCustomFilterEval::PrintFastTPTInfo(
+                                    const G4String &  sourceFileName ) const
+{
+    if ( parseResultTPT.empty() )
+        return;
+
+    ParseResultVector::size_type  nmbOfFastTPT( parseResultFastTPT.size() );
+
+    G4cout << CEXMC_LINE_START << "Custom filter '" << sourceFileName <<
+              "': " << nmbOfFastTPT << " of " << parseResultTPT.size() <<
+              " tpt expressions can be evaluated before events data are "
+              "decoded" << G4endl;
+
+    if ( nmbOfFastTPT < parseResultTPT.size() )
+        G4cout << CEXMC_LINE_START << "  (expression at line " <<
+                  parseResultTPT[ nmbOfFastTPT ].sourceLine << " and next "
+                  "tpt expressions need events data)" << G4endl;
+
+    if ( fastTPTCanRunBatch )
+        return;
+
+    for ( ProgramVector::size_type  i( 0 ); i < programsFastTPT.size(); ++i )
+    {
+        if ( programsFastTPT[ i ].CanRunBatch() )
+            continue;
+
+        G4cout << CEXMC_LINE_START << "  (they are evaluated record by "
+                  "record because expression at line " <<
+                  parseResultFastTPT[ i ].sourceLine << " cannot be "
+                  "evaluated in blocks)" << G4endl;
+        break;
+    }
+}
+
+
+bool  CexmcCustomFilterEval::EvalTPT( void ) const
+{
+    for ( ProgramVector::size_type  i( 0 ); i < programsTPT.size(); ++i )
+    {
+        if ( RunProgram( programsTPT, i, true ) )
+            return parseResultTPT[ i ].action == CexmcCustomFilter::KeepTPT;
+    }
+
+#ifdef CEXMC_USE_PROFILER
+    if ( isProfiled )
+        ++nmbOfNotMatchedTPT;
+#endif
+
+    return true;
+}
+
+
+bool  CexmcCustomFilterEval::EvalFastTPT(
+                        const CexmcEventFastSObject &  evFastSObject_ ) const
+{
+    fastRecord = evFastSObject_;
+
+    for ( ProgramVector::size_type  i( 0 ); i < programsFastTPT.size(); ++i )
+    {
+        if ( programsFastTPT[ i ].Run() )
+            return parseResultFastTPT[ i ].action ==
+                                                    CexmcCustomFilter::KeepTPT;
     }
 
     return true;
 }
 
 
+void  CexmcCustomFilterEval::EvalFastTPT(
+                        const CexmcEventFastSObject *  first, size_t  stride,
+                        G4int  count,
+                        std::vector< unsigned char > &  result ) const
+{
+    const char *  base( reinterpret_cast< const char * >( first ) );
+
+    result.assign( count > 0 ? count : 0, 1 );
+
+    if ( ! fastTPTCanRunBatch )
+    {
+        for ( G4int  i( 0 ); i < count; ++i )
+            result[ i ] = EvalFastTPT(
+                            *reinterpret_cast< const CexmcEventFastSObject * >(
+                                                        base + i * stride ) );
+        return;
+    }
+
+    /* the first matching expression decides */
+    fastTPTDecided.assign( result.size(), 0 );
+
+    for ( ProgramVector::size_type  i( 0 ); i < programsFastTPT.size(); ++i )
+    {
+        unsigned char  keep( parseResultFastTPT[ i ].action ==
+                                                CexmcCustomFilter::KeepTPT );
+
+        programsFastTPT[ i ].RunBatch(
+                            reinterpret_cast< const char * >( &fastRecord ),
+                            sizeof( fastRecord ), base, stride, count,
+                            fastTPTMatched );
+
+        for ( G4int  j( 0 ); j < count; ++j )
+        {
+            if ( fastTPTDecided[ j ] || ! fastTPTMatched[ j ] )
+                continue;
+            result[ j ] = keep;
+            fastTPTDecided[ j ] = 1;
+        }
+    }
+}
+
+
 bool  CexmcCustomFilterEval::EvalEDT( void ) const
 {
-    for ( ParseResultVector::const_iterator  k( parseResultEDT.begin() );
-          k != parseResultEDT.end(); ++k )
+    for ( ProgramVector::size_type  i( 0 ); i < programsEDT.size(); ++i )
     {
-        if ( astEval( k->expression ) )
-            return k->action == CexmcCustomFilter::KeepEDT;
+        if ( RunProgram( programsEDT, i, false ) )
+            return parseResultEDT[ i ].action == CexmcCustomFilter::KeepEDT;
     }
 
+#ifdef CEXMC_USE_PROFILER
+    if ( isProfiled )
+        ++nmbOfNotMatchedEDT;
+#endif
+
     return true;
 }
 
 
+#ifdef CEXMC_USE_PROFILER
+
+void  CexmcCustomFilterEval::EnableProfiling( G4bool  on )
+{
+    isProfiled = on;
+}
+
+
+void  CexmcCustomFilterEval::ResetProfile( void )
+{
+    ExpressionProfile  emptyProfile = { 0, 0, 0. };
+
+    profileTPT.assign( programsTPT.size(), emptyProfile );
+    profileEDT.assign( programsEDT.size(), emptyProfile );
+    nmbOfNotMatchedTPT = 0;
+    nmbOfNotMatchedEDT = 0;
+}
+
+
+void  CexmcCustomFilterEval::PrintProfile( void ) const
+{
+    if ( ! isProfiled )
+        return;
+
+    G4cout << " --- Custom filter '" << sourceFileName << "' (action line | "
+              "evaluated | matched | total, s | mean, us):" << G4endl;
+
+    PrintProfile( parseResultTPT, profileTPT, nmbOfNotMatchedTPT );
+    PrintProfile( parseResultEDT, profileEDT, nmbOfNotMatchedEDT );
+}
+
+
+void  CexmcCustomFilterEval::PrintProfile(
+                                    const ParseResultVector &  parseResult,
+                                    const ProfileVector &  profile,
+                                    G4int  nmbOfNotMatched ) const
+{
+    const char *  actionNames[] =
+    {
+        "keep tpt", "keep edt", "delete tpt", "delete edt"
+    };
+
+    std::ios_base::fmtflags  flags( G4cout.flags() );
+    std::streamsize          precision( G4cout.precision() );
+
+    G4cout.setf( std::ios::fixed );
+
+    for ( ProfileVector::size_type  i( 0 ); i < profile.size(); ++i )
+    {
+        const ExpressionProfile &  data( profile[ i ] );
+
+        G4cout << "       " << std::setw( 10 ) <<
+                  actionNames[ parseResult[ i ].action ] << "  " <<
+                  std::setw( 4 ) << parseResult[ i ].sourceLine << " | " <<
+                  std::setw( 10 ) << data.nmbOfEvaluations << " | " <<
+                  std::setw( 10 ) << data.nmbOfMatches << " | " <<
+                  std::setprecision( 3 ) << std::setw( 10 ) <<
+                  data.time / 1e9 << " | " << std::setprecision( 3 ) <<
+                  ( data.nmbOfEvaluations > 0 ?
+                        data.time / data.nmbOfEvaluations / 1e3 : 0. ) <<
+                  G4endl;
+    }
+
+    if ( ! profile.empty() )
+    {
+        G4cout << "       " << std::setw( 10 ) << "no match" << "  " <<
+                  std::setw( 4 ) << "" << " | " << std::setw( 10 ) << "" <<
+                  " | " << std::setw( 10 ) << nmbOfNotMatched << G4endl;
+    }
+
+    G4cout.flags( flags );
+    G4cout.precision( precision );
+}
+
+#endif
+
+
 #endif
 
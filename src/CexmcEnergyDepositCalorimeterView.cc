@@ -0,0 +1,161 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcEnergyDepositCalorimeterView.cc
+ *
+ *    Description:  non-owning view of calorimeter energy deposit collection
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 23:41:26
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include "CexmcEnergyDepositCalorimeterView.hh"
+
+
+void  CexmcEnergyDepositCalorimeterView::Inner( void )
+{
+    if ( ! collection || isEmpty )
+        return;
+
+    /* middle rows of an outer view have at most two elements */
+    if ( isOuter )
+    {
+        isEmpty = true;
+        return;
+    }
+
+    ++rowTrim;
+    ++columnTrim;
+}
+
+
+void  CexmcEnergyDepositCalorimeterView::Outer( void )
+{
+    if ( GetNmbOfRows() < 3 )
+        return;
+
+    isOuter = true;
+}
+
+
+G4double  CexmcEnergyDepositCalorimeterView::Sum( void ) const
+{
+    G4double  result( 0. );
+    G4int     rowEnd( rowTrim + GetNmbOfRows() );
+
+    for ( G4int  i( rowTrim ); i < rowEnd; ++i )
+    {
+        const G4double *  row( ( *collection )[ i ] );
+        G4int             begin( 0 );
+        G4int             end( 0 );
+        G4int             step( GetRowBounds( i, begin, end ) );
+        G4double          rowResult( 0. );
+
+        for ( G4int  j( begin ); j < end; j += step )
+            rowResult += row[ j ];
+
+        result += rowResult;
+    }
+
+    return result;
+}
+
+
+void  CexmcEnergyDepositCalorimeterView::FindMax( G4double &  value,
+                                        G4int &  row, G4int &  column ) const
+{
+    G4int  rowEnd( rowTrim + GetNmbOfRows() );
+
+    value = 0.;
+    row = 0;
+    column = 0;
+
+    for ( G4int  i( rowTrim ); i < rowEnd; ++i )
+    {
+        const G4double *  curRow( ( *collection )[ i ] );
+        G4int             begin( 0 );
+        G4int             end( 0 );
+        G4int             step( GetRowBounds( i, begin, end ) );
+
+        for ( G4int  j( begin ); j < end; j += step )
+        {
+            if ( row == 0 || curRow[ j ] > value )
+            {
+                value = curRow[ j ];
+                row = i + 1;
+                column = j + 1;
+            }
+        }
+    }
+}
+
+
+G4double  CexmcEnergyDepositCalorimeterView::Max( void ) const
+{
+    G4double  value( 0. );
+    G4int     row( 0 );
+    G4int     column( 0 );
+
+    FindMax( value, row, column );
+
+    return value;
+}
+
+
+G4int  CexmcEnergyDepositCalorimeterView::ArgMaxRow( void ) const
+{
+    G4double  value( 0. );
+    G4int     row( 0 );
+    G4int     column( 0 );
+
+    FindMax( value, row, column );
+
+    return row;
+}
+
+
+G4int  CexmcEnergyDepositCalorimeterView::ArgMaxColumn( void ) const
+{
+    G4double  value( 0. );
+    G4int     row( 0 );
+    G4int     column( 0 );
+
+    FindMax( value, row, column );
+
+    return column;
+}
+
+
+G4int  CexmcEnergyDepositCalorimeterView::Count( G4double  threshold ) const
+{
+    G4int  result( 0 );
+    G4int  rowEnd( rowTrim + GetNmbOfRows() );
+
+    for ( G4int  i( rowTrim ); i < rowEnd; ++i )
+    {
+        const G4double *  row( ( *collection )[ i ] );
+        G4int             begin( 0 );
+        G4int             end( 0 );
+        G4int             step( GetRowBounds( i, begin, end ) );
+
+        for ( G4int  j( begin ); j < end; j += step )
+        {
+            if ( row[ j ] > threshold )
+                ++result;
+        }
+    }
+
+    return result;
+}
+
+#endif
+
@@ -18,14 +18,14 @@
 
 #include <iostream>
 #include <iomanip>
-#include <G4DigiManager.hh>
+#include <algorithm>
 #include <G4String.hh>
 #include <Randomize.hh>
 #include "CexmcEnergyDepositDigitizer.hh"
 #include "CexmcEnergyDepositDigitizerMessenger.hh"
 #include "CexmcSimpleEnergyDeposit.hh"
 #include "CexmcEnergyDepositInLeftRightSet.hh"
-#include "CexmcEnergyDepositInCalorimeter.hh"
+#include "CexmcEnergyDepositArray.hh"
 #include "CexmcSetup.hh"
 #include "CexmcRunManager.hh"
 #include "CexmcSensitiveDetectorsAttributes.hh"
@@ -62,32 +62,62 @@ CexmcEnergyDepositDigitizer::CexmcEnergyDepositDigitizer(
     nCrystalsInColumn = calorimeterGeometry.nCrystalsInColumn;
     nCrystalsInRow = calorimeterGeometry.nCrystalsInRow;
 
-    if ( nCrystalsInColumn > 0 )
-    {
-        calorimeterEDLeftCollection.resize( nCrystalsInColumn );
-        calorimeterEDRightCollection.resize( nCrystalsInColumn );
-    }
+    calorimeterEDLeftCollection.Resize( nCrystalsInColumn, nCrystalsInRow );
+    calorimeterEDRightCollection.Resize( nCrystalsInColumn, nCrystalsInRow );
+    calorimeterGridTables.Build( calorimeterGeometry );
 
-    if ( nCrystalsInRow > 0 )
-    {
-        for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                k( calorimeterEDLeftCollection.begin() );
-                    k != calorimeterEDLeftCollection.end(); ++k )
-        {
-            k->resize( nCrystalsInRow );
-        }
-        for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                k( calorimeterEDRightCollection.begin() );
-                    k != calorimeterEDRightCollection.end(); ++k )
-        {
-            k->resize( nCrystalsInRow );
-        }
-    }
+    smearedCrystals.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
+    smearedCrystalsResolution.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
+    gaussianShoots.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
 
     messenger = new CexmcEnergyDepositDigitizerMessenger( this );
 }
 
 
+CexmcEnergyDepositDigitizer::CexmcEnergyDepositDigitizer(
+                        const CexmcEnergyDepositDigitizer &  digitizer ) :
+    G4VDigitizerModule( digitizer.GetName() ), monitorED( 0 ),
+    vetoCounterEDLeft( 0 ), vetoCounterEDRight( 0 ),
+    calorimeterEDLeftCollection( digitizer.calorimeterEDLeftCollection ),
+    calorimeterEDRightCollection( digitizer.calorimeterEDRightCollection ),
+    calorimeterEDLeft( 0 ), calorimeterEDRight( 0 ),
+    calorimeterEDLeftMaxX( 0 ), calorimeterEDLeftMaxY( 0 ),
+    calorimeterEDRightMaxX( 0 ), calorimeterEDRightMaxY( 0 ),
+    monitorHasTriggered( false ), hasTriggered( false ),
+    monitorEDThreshold( digitizer.monitorEDThreshold ),
+    vetoCounterEDLeftThreshold( digitizer.vetoCounterEDLeftThreshold ),
+    vetoCounterEDRightThreshold( digitizer.vetoCounterEDRightThreshold ),
+    calorimeterEDLeftThreshold( digitizer.calorimeterEDLeftThreshold ),
+    calorimeterEDRightThreshold( digitizer.calorimeterEDRightThreshold ),
+    calorimeterTriggerAlgorithm( digitizer.calorimeterTriggerAlgorithm ),
+    outerCrystalsVetoAlgorithm( digitizer.outerCrystalsVetoAlgorithm ),
+    outerCrystalsVetoFraction( digitizer.outerCrystalsVetoFraction ),
+    monitorEDThresholdRef( digitizer.monitorEDThresholdRef ),
+    vetoCounterEDLeftThresholdRef( digitizer.vetoCounterEDLeftThresholdRef ),
+    vetoCounterEDRightThresholdRef(
+                                digitizer.vetoCounterEDRightThresholdRef ),
+    calorimeterEDLeftThresholdRef( digitizer.calorimeterEDLeftThresholdRef ),
+    calorimeterEDRightThresholdRef(
+                                digitizer.calorimeterEDRightThresholdRef ),
+    calorimeterTriggerAlgorithmRef(
+                                digitizer.calorimeterTriggerAlgorithmRef ),
+    outerCrystalsVetoAlgorithmRef( digitizer.outerCrystalsVetoAlgorithmRef ),
+    outerCrystalsVetoFractionRef( digitizer.outerCrystalsVetoFractionRef ),
+    nCrystalsInColumn( digitizer.nCrystalsInColumn ),
+    nCrystalsInRow( digitizer.nCrystalsInRow ),
+    calorimeterGridTables( digitizer.calorimeterGridTables ),
+    hcIds( digitizer.hcIds ),
+    applyFiniteCrystalResolution( digitizer.applyFiniteCrystalResolution ),
+    crystalResolutionData( digitizer.crystalResolutionData ),
+    crystalResolutionTable( digitizer.crystalResolutionTable ),
+    messenger( NULL )
+{
+    smearedCrystals.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
+    smearedCrystalsResolution.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
+    gaussianShoots.reserve( 2 * nCrystalsInColumn * nCrystalsInRow );
+}
+
+
 CexmcEnergyDepositDigitizer::~CexmcEnergyDepositDigitizer()
 {
     delete messenger;
@@ -108,40 +138,26 @@ void  CexmcEnergyDepositDigitizer::InitializeData( void )
     monitorHasTriggered = false;
     hasTriggered = false;
 
-    for ( CexmcEnergyDepositCalorimeterCollection::iterator
-              k( calorimeterEDLeftCollection.begin() );
-                  k != calorimeterEDLeftCollection.end(); ++k )
-    {
-        for ( CexmcEnergyDepositCrystalRowCollection::iterator
-                l( k->begin() ); l != k->end(); ++l )
-        {
-            *l = 0;
-        }
-    }
-    for ( CexmcEnergyDepositCalorimeterCollection::iterator
-              k( calorimeterEDRightCollection.begin() );
-                  k != calorimeterEDRightCollection.end(); ++k )
-    {
-        for ( CexmcEnergyDepositCrystalRowCollection::iterator
-                l( k->begin() ); l != k->end(); ++l )
-        {
-            *l = 0;
-        }
-    }
+    calorimeterEDLeftCollection.Reset();
+    calorimeterEDRightCollection.Reset();
 }
 
 
 void  CexmcEnergyDepositDigitizer::Digitize( void )
+{
+    Digitize( NULL );
+}
+
+
+void  CexmcEnergyDepositDigitizer::Digitize( G4HCofThisEvent *  hcOfThisEvent )
 {
     InitializeData();
 
-    G4DigiManager *  digiManager( G4DigiManager::GetDMpointer() );
-    G4int    hcId( digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcMonitorDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcEDDetector ] ) );
     const CexmcEnergyDepositCollection *
          hitsCollection( static_cast< const CexmcEnergyDepositCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcMonitorDetectorRole,
+                                                 CexmcEDDetector ) ) );
 
     if ( hitsCollection )
     {
@@ -150,11 +166,10 @@ void  CexmcEnergyDepositDigitizer::Digitize( void )
             monitorED = *( *hitsCollection )[ 0 ];
     }
 
-    hcId = digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcVetoCounterDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcEDDetector ] );
     hitsCollection = static_cast< const CexmcEnergyDepositCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcVetoCounterDetectorRole,
+                                                 CexmcEDDetector ) );
     if ( hitsCollection )
     {
         for ( CexmcEnergyDepositCollectionData::iterator
@@ -178,8 +193,6 @@ void  CexmcEnergyDepositDigitizer::Digitize( void )
         }
     }
 
-    G4double  maxEDCrystalLeft( 0 );
-    G4double  maxEDCrystalRight( 0 );
     G4double  outerCrystalsEDLeft( 0 );
     G4double  outerCrystalsEDRight( 0 );
     G4double  innerCrystalsEDLeft( 0 );
@@ -188,82 +201,46 @@ void  CexmcEnergyDepositDigitizer::Digitize( void )
     CexmcRunManager *  runManager( static_cast< CexmcRunManager * >(
                                             G4RunManager::GetRunManager() ) );
 
-    hcId = digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcCalorimeterDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcEDDetector ] );
-    hitsCollection = static_cast< const CexmcEnergyDepositCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) );
-    if ( hitsCollection )
+    const CexmcEnergyDepositArrayCollection *  calorimeterHitsCollection(
+                static_cast< const CexmcEnergyDepositArrayCollection * >(
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcCalorimeterDetectorRole,
+                                                 CexmcEDDetector ) ) );
+    const CexmcEnergyDepositArray *  edArray( calorimeterHitsCollection ?
+                            calorimeterHitsCollection->GetArray() : NULL );
+
+    if ( edArray && edArray->GetNmbOfEntries() > 0 )
     {
-        for ( CexmcEnergyDepositCollectionData::iterator
-                  k( hitsCollection->GetMap()->begin() );
-                      k != hitsCollection->GetMap()->end(); ++k )
-        {
-            G4int      index( k->first );
-            CexmcSide  side( CexmcEnergyDepositInLeftRightSet::GetSide(
-                                                                   index ) );
-            G4int      row( CexmcEnergyDepositInCalorimeter::GetRow( index ) );
-            G4int      column( CexmcEnergyDepositInCalorimeter::GetColumn(
-                                                                   index ) );
-            G4double   value( *k->second );
-            if ( applyFiniteCrystalResolution && value > 0. &&
-                                                 ! runManager->ProjectIsRead() )
-            {
-                for ( CexmcEnergyRangeWithDoubleValueList::const_iterator
-                          l( crystalResolutionData.begin() );
-                          l != crystalResolutionData.end(); ++l )
-                {
-                    if ( value < l->bottom || value >= l->top )
-                        continue;
-                    value = G4RandGauss::shoot( value,
-                                        value * l->value * CexmcFwhmToStddev );
-                    if ( value < 0. )
-                        value = 0.;
-                    break;
-                }
-            }
-            switch ( side )
-            {
-            case CexmcLeft :
-                if ( value > maxEDCrystalLeft )
-                {
-                    calorimeterEDLeftMaxX = column;
-                    calorimeterEDLeftMaxY = row;
-                    maxEDCrystalLeft = value;
-                }
-                if ( IsOuterCrystal( column, row ) )
-                {
-                    outerCrystalsEDLeft += value;
-                }
-                else
-                {
-                    innerCrystalsEDLeft += value;
-                }
-                calorimeterEDLeft += value;
-                calorimeterEDLeftCollection[ row ][ column ] = value;
-                break;
-            case CexmcRight :
-                if ( value > maxEDCrystalRight )
-                {
-                    calorimeterEDRightMaxX = column;
-                    calorimeterEDRightMaxY = row;
-                    maxEDCrystalRight = value;
-                }
-                if ( IsOuterCrystal( column, row ) )
-                {
-                    outerCrystalsEDRight += value;
-                }
-                else
-                {
-                    innerCrystalsEDRight += value;
-                }
-                calorimeterEDRight += value;
-                calorimeterEDRightCollection[ row ][ column ] = value;
-                break;
-            default :
-                break;
-            }
-        }
+        G4int  nmbOfCellsInSide( std::min( edArray->GetNmbOfRows() *
+                                           edArray->GetNmbOfColumns(),
+                                calorimeterEDLeftCollection.GetSize() ) );
+
+        std::copy( edArray->GetData( CexmcLeft ),
+                   edArray->GetData( CexmcLeft ) + nmbOfCellsInSide,
+                   calorimeterEDLeftCollection.GetData() );
+        std::copy( edArray->GetData( CexmcRight ),
+                   edArray->GetData( CexmcRight ) + nmbOfCellsInSide,
+                   calorimeterEDRightCollection.GetData() );
+
+        if ( applyFiniteCrystalResolution && ! runManager->ProjectIsRead() )
+            SmearCrystalsEnergyDeposit();
+
+        calorimeterGridTables.SumEnergyDeposit( calorimeterEDLeftCollection,
+                                                calorimeterEDLeft,
+                                                innerCrystalsEDLeft,
+                                                outerCrystalsEDLeft );
+        calorimeterGridTables.SumEnergyDeposit( calorimeterEDRightCollection,
+                                                calorimeterEDRight,
+                                                innerCrystalsEDRight,
+                                                outerCrystalsEDRight );
+        CexmcCalorimeterGridTables::FindMaxEnergyDeposit(
+                                                calorimeterEDLeftCollection,
+                                                calorimeterEDLeftMaxY,
+                                                calorimeterEDLeftMaxX );
+        CexmcCalorimeterGridTables::FindMaxEnergyDeposit(
+                                                calorimeterEDRightCollection,
+                                                calorimeterEDRightMaxY,
+                                                calorimeterEDRightMaxX );
     }
 
     G4double  calorimeterEDLeftEffective( calorimeterEDLeft );
@@ -312,6 +289,57 @@ void  CexmcEnergyDepositDigitizer::Digitize( void )
 }
 
 
+void  CexmcEnergyDepositDigitizer::SmearCrystalsEnergyDeposit( void )
+{
+    smearedCrystals.clear();
+    smearedCrystalsResolution.clear();
+
+    /* crystals are visited in the same order as keys of the hits map used
+     * before (side, row, column), so random numbers for the finite crystal
+     * resolution are drawn in the same sequence */
+    CexmcEnergyDepositCalorimeterCollection *  edHits[] =
+                { &calorimeterEDLeftCollection, &calorimeterEDRightCollection };
+
+    for ( G4int  i( 0 ); i < 2; ++i )
+    {
+        G4double *  values( edHits[ i ]->GetData() );
+        G4int       size( edHits[ i ]->GetSize() );
+
+        for ( G4int  j( 0 ); j < size; ++j )
+        {
+            G4double  resolution( 0 );
+
+            if ( values[ j ] <= 0. ||
+                 ! crystalResolutionTable.Find( values[ j ], resolution ) )
+                continue;
+            smearedCrystals.push_back( values + j );
+            smearedCrystalsResolution.push_back( resolution );
+        }
+    }
+
+    G4int  nmbOfSmearedCrystals( smearedCrystals.size() );
+
+    if ( nmbOfSmearedCrystals == 0 )
+        return;
+
+    /* shootArray() draws standard gaussian values exactly as consecutive
+     * calls to shoot( mean, stdDev ) which were used before, value *
+     * stdDev + mean is then computed here in the same way */
+    gaussianShoots.resize( nmbOfSmearedCrystals );
+    G4RandGauss::shootArray( nmbOfSmearedCrystals, &gaussianShoots[ 0 ] );
+
+    for ( G4int  i( 0 ); i < nmbOfSmearedCrystals; ++i )
+    {
+        G4double &  value( *smearedCrystals[ i ] );
+
+        value = gaussianShoots[ i ] * ( value * smearedCrystalsResolution[ i ] *
+                                        CexmcFwhmToStddev ) + value;
+        if ( value < 0. )
+            value = 0.;
+    }
+}
+
+
 std::ostream &  operator<<( std::ostream &  out,
                 const CexmcEnergyDepositCalorimeterCollection &  edCollection )
 {
@@ -320,12 +348,10 @@ std::ostream &  operator<<( std::ostream &  out,
     out.precision( 4 );
 
     out << std::endl;
-    for ( CexmcEnergyDepositCalorimeterCollection::const_reverse_iterator
-            k( edCollection.rbegin() ); k != edCollection.rend(); ++k )
+    for ( G4int  i( edCollection.GetNmbOfRows() - 1 ); i >= 0; --i )
     {
-        for ( CexmcEnergyDepositCrystalRowCollection::const_reverse_iterator
-                l( k->rbegin() ); l != k->rend(); ++l )
-            out << std::setw( 10 ) << *l;
+        for ( G4int  j( edCollection.GetNmbOfColumns() - 1 ); j >= 0; --j )
+            out << std::setw( 10 ) << edCollection[ i ][ j ];
         out << std::endl;
     }
 
@@ -22,6 +22,7 @@
 #include <G4VPhysicalVolume.hh>
 #include <G4NavigationHistory.hh>
 #include <G4UnitsTable.hh>
+#include <G4HCofThisEvent.hh>
 #include "CexmcEnergyDepositInCalorimeter.hh"
 #include "CexmcSetup.hh"
 
@@ -33,52 +34,90 @@ CexmcEnergyDepositInCalorimeter::CexmcEnergyDepositInCalorimeter(
 }
 
 
-G4int  CexmcEnergyDepositInCalorimeter::GetIndex( G4Step *  step )
+G4bool  CexmcEnergyDepositInCalorimeter::ProcessHits( G4Step *  step,
+                                                      G4TouchableHistory * )
 {
-    G4int                        ret( 0 );
-    G4StepPoint *                preStep( step->GetPreStepPoint() );
-    const G4VTouchable *         touchable( preStep->GetTouchable() );
-    const G4NavigationHistory *  navHistory( touchable->GetHistory() );
-    G4int                        navDepth( navHistory->GetDepth() );
-    G4VPhysicalVolume *          pVolume( navHistory->GetVolume(
-                                                        navDepth - 2 ) );
+    G4double  energyDeposit( step->GetTotalEnergyDeposit() );
 
-    if ( setup->IsRightCalorimeter( pVolume ) )
-        ret |= 1 << leftRightBitsOffset;
+    if ( energyDeposit == 0. )
+        return false;
 
-    ret |= touchable->GetReplicaNumber( 0 );
-    ret |= touchable->GetReplicaNumber( 1 ) << copyDepth1BitsOffset;
+    CexmcSide  side( CexmcLeft );
+    G4int      row( 0 );
+    G4int      column( 0 );
 
-    return ret;
+    setup->GetCalorimeterCrystal(
+                    step->GetPreStepPoint()->GetTouchable()->GetHistory(),
+                    side, row, column );
+    edArray.Add( side, row, column, energyDeposit );
+
+    return true;
+}
+
+
+void  CexmcEnergyDepositInCalorimeter::Initialize(
+                                                G4HCofThisEvent *  hcOfEvent )
+{
+    const CexmcSetup::CalorimeterGeometryData &  calorimeterGeometry(
+                                            setup->GetCalorimeterGeometry() );
+
+    if ( edArray.GetNmbOfRows() != calorimeterGeometry.nCrystalsInColumn ||
+         edArray.GetNmbOfColumns() != calorimeterGeometry.nCrystalsInRow )
+    {
+        edArray.Resize( calorimeterGeometry.nCrystalsInColumn,
+                        calorimeterGeometry.nCrystalsInRow );
+    }
+    else
+    {
+        edArray.Reset();
+    }
+
+    if ( hcId < 0 )
+        hcId = GetCollectionID( 0 );
+
+    hcOfEvent->AddHitsCollection( hcId,
+                new CexmcEnergyDepositArrayCollection( detector->GetName(),
+                                                       primitiveName,
+                                                       &edArray ) );
+}
+
+
+void  CexmcEnergyDepositInCalorimeter::clear( void )
+{
+    edArray.Reset();
 }
 
 
 void  CexmcEnergyDepositInCalorimeter::PrintAll( void )
 {
-    G4int   nmbOfEntries( eventMap->entries() );
+    G4int   nmbOfEntries( edArray.GetNmbOfEntries() );
 
     if ( nmbOfEntries == 0 )
         return;
 
     PrintHeader( nmbOfEntries );
 
-    for ( CexmcEnergyDepositCollectionData::iterator
-                         itr( eventMap->GetMap()->begin() );
-                                     itr != eventMap->GetMap()->end(); ++itr )
+    for ( G4int  i( CexmcLeft ); i <= CexmcRight; ++i )
     {
-        G4bool  isRightDetector( itr->first >> leftRightBitsOffset );
-        G4int   index( itr->first &
-                            ( ( 1 << ( leftRightBitsOffset - 1 ) ) |
-                              ( ( 1 << ( leftRightBitsOffset - 1 ) ) - 1 ) ) );
-        G4int   copyDepth1( index >> copyDepth1BitsOffset );
-        G4int   copyDepth0( index &
-                            ( ( 1 << ( copyDepth1BitsOffset - 1 ) ) |
-                              ( ( 1 << ( copyDepth1BitsOffset - 1 ) ) - 1 ) ) );
-        const G4String  detectorSide( isRightDetector ? "right" : "left" );
-        G4cout << "       " << detectorSide << " detector, row " <<
-                copyDepth1 << ", column " << copyDepth0 << G4endl;
-        G4cout << "         , energy deposit " <<
-                G4BestUnit( *( itr->second ), "Energy" ) << G4endl;
+        CexmcSide         side( CexmcSide( i ) );
+        const G4double *  value( edArray.GetData( side ) );
+        const G4String    detectorSide( side == CexmcRight ? "right" :
+                                                             "left" );
+
+        for ( G4int  row( 0 ); row < edArray.GetNmbOfRows(); ++row )
+        {
+            for ( G4int  column( 0 ); column < edArray.GetNmbOfColumns();
+                  ++column, ++value )
+            {
+                if ( *value == 0. )
+                    continue;
+
+                G4cout << "       " << detectorSide << " detector, row " <<
+                        row << ", column " << column << G4endl;
+                G4cout << "         , energy deposit " <<
+                        G4BestUnit( *value, "Energy" ) << G4endl;
+            }
+        }
     }
 }
 
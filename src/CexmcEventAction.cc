@@ -22,6 +22,7 @@
 #endif
 #include <G4DigiManager.hh>
 #include <G4Event.hh>
+#include <G4HCofThisEvent.hh>
 #include <G4Circle.hh>
 #include <G4VisAttributes.hh>
 #include <G4VisManager.hh>
@@ -34,6 +35,8 @@
 #include "CexmcEventInfo.hh"
 #include "CexmcEventSObject.hh"
 #include "CexmcEventFastSObject.hh"
+#include "CexmcEventsWriter.hh"
+#include "CexmcReplayedEvent.hh"
 #include "CexmcTrackingAction.hh"
 #include "CexmcChargeExchangeReconstructor.hh"
 #include "CexmcRunManager.hh"
@@ -47,6 +50,7 @@
 #include "CexmcTrackPointsDigitizer.hh"
 #include "CexmcTrackPointsStore.hh"
 #include "CexmcTrackPointInfo.hh"
+#include "CexmcStageProfiler.hh"
 #include "CexmcException.hh"
 #include "CexmcCommon.hh"
 
@@ -69,23 +73,81 @@ namespace
 CexmcEventAction::CexmcEventAction( CexmcPhysicsManager *  physicsManager,
                                     G4int  verbose ) :
     physicsManager( physicsManager ), reconstructor( NULL ), opKinEnergy( 0. ),
-    verbose( verbose ), verboseDraw( 4 ), messenger( NULL )
+    energyDepositDigitizer( NULL ), trackPointsDigitizer( NULL ),
+    edStore( NULL ), tpStore( NULL ),
+#ifdef CEXMC_USE_PERSISTENCY
+    evSObject( NULL ),
+#endif
+    verbose( verbose ), verboseDraw( 4 ), isSecondaryOutput( false ),
+    messenger( NULL ), isReplayWorker( false )
+#ifdef CEXMC_USE_PERSISTENCY
+    , replayedTriggeredAngularRanges( NULL ), replayedPmData( NULL ),
+    replayOutput( NULL ), replayRun( NULL )
+#endif
+#ifdef CEXMC_USE_ROOT
+    , workerHistoManager( NULL )
+#endif
 {
     G4DigiManager *  digiManager( G4DigiManager::GetDMpointer() );
-    digiManager->AddNewModule( new CexmcEnergyDepositDigitizer(
-                                                    CexmcEDDigitizerName ) );
-    digiManager->AddNewModule( new CexmcTrackPointsDigitizer(
-                                                    CexmcTPDigitizerName ) );
+    energyDepositDigitizer = new CexmcEnergyDepositDigitizer(
+                                                    CexmcEDDigitizerName );
+    digiManager->AddNewModule( energyDepositDigitizer );
+    trackPointsDigitizer = new CexmcTrackPointsDigitizer(
+                                                    CexmcTPDigitizerName );
+    digiManager->AddNewModule( trackPointsDigitizer );
+    edStore = MakeEnergyDepositStore( energyDepositDigitizer );
+    tpStore = MakeTrackPointsStore( trackPointsDigitizer );
+#ifdef CEXMC_USE_PERSISTENCY
+    evSObject = new CexmcEventSObject;
+#endif
     reconstructor = new CexmcChargeExchangeReconstructor(
                                         physicsManager->GetProductionModel() );
     messenger = new CexmcEventActionMessenger( this );
 }
 
 
+#ifdef CEXMC_USE_PERSISTENCY
+
+CexmcEventAction::CexmcEventAction( const CexmcEventAction &  eventAction ) :
+    G4UserEventAction(), physicsManager( eventAction.physicsManager ),
+    reconstructor( NULL ), opKinEnergy( 0. ), energyDepositDigitizer( NULL ),
+    trackPointsDigitizer( NULL ), edStore( NULL ), tpStore( NULL ),
+    evSObject( NULL ), verbose( 0 ), verboseDraw( 0 ),
+    isSecondaryOutput( false ), messenger( NULL ), isReplayWorker( true ),
+    replayedTriggeredAngularRanges( NULL ), replayedPmData( NULL ),
+    replayOutput( NULL ), replayRun( NULL )
+#ifdef CEXMC_USE_ROOT
+    , workerHistoManager( NULL )
+#endif
+{
+    energyDepositDigitizer = new CexmcEnergyDepositDigitizer(
+                                        *eventAction.energyDepositDigitizer );
+    trackPointsDigitizer = new CexmcTrackPointsDigitizer(
+                                        *eventAction.trackPointsDigitizer );
+    edStore = MakeEnergyDepositStore( energyDepositDigitizer );
+    tpStore = MakeTrackPointsStore( trackPointsDigitizer );
+    evSObject = new CexmcEventSObject;
+    reconstructor = new CexmcChargeExchangeReconstructor(
+                                                *eventAction.reconstructor );
+}
+
+#endif
+
+
 CexmcEventAction::~CexmcEventAction()
 {
+#ifdef CEXMC_USE_PERSISTENCY
+    delete evSObject;
+#endif
+    delete edStore;
+    delete tpStore;
     delete reconstructor;
     delete messenger;
+    if ( isReplayWorker )
+    {
+        delete energyDepositDigitizer;
+        delete trackPointsDigitizer;
+    }
 }
 
 
@@ -95,6 +157,53 @@ void  CexmcEventAction::BeamParticleChangeHook( void )
 }
 
 
+#ifdef CEXMC_USE_PERSISTENCY
+
+G4bool  CexmcEventAction::EventsArePrintedOrDrawn( void ) const
+{
+    if ( verbose > 0 )
+        return true;
+
+    if ( verboseDraw == 0 )
+        return false;
+
+    G4VisManager *  visManager( static_cast< G4VisManager * >(
+                                    G4VVisManager::GetConcreteInstance() ) );
+
+    return visManager && visManager->GetCurrentGraphicsSystem();
+}
+
+#endif
+
+
+#ifdef CEXMC_USE_ROOT
+
+CexmcHistoManager *  CexmcEventAction::GetHistoManager( void ) const
+{
+    if ( workerHistoManager )
+        return workerHistoManager;
+
+    return CexmcHistoManager::Instance();
+}
+
+#endif
+
+
+CexmcRun *  CexmcEventAction::GetRun( void ) const
+{
+#ifdef CEXMC_USE_PERSISTENCY
+    if ( replayRun )
+        return replayRun;
+#endif
+
+    G4RunManager *    runManager( G4RunManager::GetRunManager() );
+    const CexmcRun *  run( static_cast< const CexmcRun * >(
+                                                runManager->GetCurrentRun() ) );
+
+    return const_cast< CexmcRun * >( run );
+}
+
+
 void  CexmcEventAction::BeginOfEventAction( const G4Event * )
 {
     G4RunManager *         runManager( G4RunManager::GetRunManager() );
@@ -182,6 +291,22 @@ CexmcTrackPointsStore *  CexmcEventAction::MakeTrackPointsStore(
 }
 
 
+void  CexmcEventAction::UpdateEnergyDepositStore(
+                                CexmcEnergyDepositStore *  edStore,
+                                const CexmcEnergyDepositDigitizer *  digitizer )
+{
+    edStore->monitorED = digitizer->GetMonitorED();
+    edStore->vetoCounterEDLeft = digitizer->GetVetoCounterEDLeft();
+    edStore->vetoCounterEDRight = digitizer->GetVetoCounterEDRight();
+    edStore->calorimeterEDLeft = digitizer->GetCalorimeterEDLeft();
+    edStore->calorimeterEDRight = digitizer->GetCalorimeterEDRight();
+    edStore->calorimeterEDLeftMaxX = digitizer->GetCalorimeterEDLeftMaxX();
+    edStore->calorimeterEDLeftMaxY = digitizer->GetCalorimeterEDLeftMaxY();
+    edStore->calorimeterEDRightMaxX = digitizer->GetCalorimeterEDRightMaxX();
+    edStore->calorimeterEDRightMaxY = digitizer->GetCalorimeterEDRightMaxY();
+}
+
+
 void  CexmcEventAction::PrintEnergyDeposit(
                                     const CexmcEnergyDepositStore *  edStore )
 {
@@ -288,7 +413,7 @@ void  CexmcEventAction::PrintReconstructedData(
 void  CexmcEventAction::FillEDTHistos( const CexmcEnergyDepositStore *  edStore,
                 const CexmcAngularRangeList &  triggeredAngularRanges ) const
 {
-    CexmcHistoManager *  histoManager( CexmcHistoManager::Instance() );
+    CexmcHistoManager *  histoManager( GetHistoManager() );
 
     histoManager->Add( CexmcAbsorbedEnergy_EDT_Histo, 0,
                        edStore->calorimeterEDLeft,
@@ -310,7 +435,7 @@ void  CexmcEventAction::FillTPTHistos( const CexmcTrackPointsStore *  tpStore,
                 const CexmcProductionModelData &  pmData,
                 const CexmcAngularRangeList &  triggeredAngularRanges ) const
 {
-    CexmcHistoManager *  histoManager( CexmcHistoManager::Instance() );
+    CexmcHistoManager *  histoManager( GetHistoManager() );
 
     if ( tpStore->monitorTP.IsValid() )
     {
@@ -383,7 +508,7 @@ void  CexmcEventAction::FillRTHistos( G4bool  reconstructorHasFullTrigger,
                 const CexmcProductionModelData &  pmData,
                 const CexmcAngularRangeList &  triggeredAngularRanges ) const
 {
-    CexmcHistoManager *  histoManager( CexmcHistoManager::Instance() );
+    CexmcHistoManager *  histoManager( GetHistoManager() );
 
     G4double    opMass( reconstructor->GetOutputParticleMass() );
     G4double    nopMass( reconstructor->GetNucleusOutputParticleMass() );
@@ -649,10 +774,7 @@ void  CexmcEventAction::UpdateRunHits(
                                     G4bool  reconstructorHasFullTrigger,
                                     const CexmcAngularRange &  aGap )
 {
-    G4RunManager *    runManager( G4RunManager::GetRunManager() );
-    const CexmcRun *  run( static_cast< const CexmcRun * >(
-                                                runManager->GetCurrentRun() ) );
-    CexmcRun *        theRun( const_cast< CexmcRun * >( run ) );
+    CexmcRun *  theRun( GetRun() );
 
     if ( tpDigitizerHasTriggered )
     {
@@ -711,27 +833,48 @@ void  CexmcEventAction::SaveEvent( const G4Event *  event,
                                                 CexmcWriteEventDataOnEveryTPT )
         return;
 
-    boost::archive::binary_oarchive *  archive(
-                                            runManager->GetEventsArchive() );
-    if ( archive )
+    /* events data of a replay worker are written later by the run manager
+     * into the events writer of the output */
+    CexmcEventsWriter *  eventsWriter( runManager->GetEventsWriter() );
+    if ( eventsWriter || replayOutput )
     {
-        CexmcEventSObject  sObject = { event->GetEventID(),
-            edDigitizerHasTriggered, edStore->monitorED,
-            edStore->vetoCounterEDLeft, edStore->vetoCounterEDRight,
-            edStore->calorimeterEDLeft, edStore->calorimeterEDRight,
-            edStore->calorimeterEDLeftCollection,
-            edStore->calorimeterEDRightCollection,
-            tpStore->monitorTP, tpStore->targetTPBeamParticle,
-            tpStore->targetTPOutputParticle, tpStore->targetTPNucleusParticle,
-            tpStore->targetTPOutputParticleDecayProductParticle1,
-            tpStore->targetTPOutputParticleDecayProductParticle2,
-            tpStore->vetoCounterTPLeft, tpStore->vetoCounterTPRight,
-            tpStore->calorimeterTPLeft, tpStore->calorimeterTPRight, pmData };
-        archive->operator<<( sObject );
-        const CexmcRun *  run( static_cast< const CexmcRun * >(
-                                                runManager->GetCurrentRun() ) );
-        CexmcRun *        theRun( const_cast< CexmcRun * >( run ) );
-        theRun->IncrementNmbOfSavedEvents();
+        /* the object is filled in place: collections are assigned to
+         * collections of the same dimensions and therefore reuse their
+         * buffers */
+        CexmcEventSObject &  sObject( replayOutput ? replayOutput->event :
+                                                     *evSObject );
+        sObject.eventId = event->GetEventID();
+        sObject.edDigitizerMonitorHasTriggered = edDigitizerHasTriggered;
+        sObject.monitorED = edStore->monitorED;
+        sObject.vetoCounterEDLeft = edStore->vetoCounterEDLeft;
+        sObject.vetoCounterEDRight = edStore->vetoCounterEDRight;
+        sObject.calorimeterEDLeft = edStore->calorimeterEDLeft;
+        sObject.calorimeterEDRight = edStore->calorimeterEDRight;
+        sObject.calorimeterEDLeftCollection =
+                                        edStore->calorimeterEDLeftCollection;
+        sObject.calorimeterEDRightCollection =
+                                        edStore->calorimeterEDRightCollection;
+        sObject.monitorTP = tpStore->monitorTP;
+        sObject.targetTPBeamParticle = tpStore->targetTPBeamParticle;
+        sObject.targetTPOutputParticle = tpStore->targetTPOutputParticle;
+        sObject.targetTPNucleusParticle = tpStore->targetTPNucleusParticle;
+        sObject.targetTPOutputParticleDecayProductParticle1 =
+                        tpStore->targetTPOutputParticleDecayProductParticle1;
+        sObject.targetTPOutputParticleDecayProductParticle2 =
+                        tpStore->targetTPOutputParticleDecayProductParticle2;
+        sObject.vetoCounterTPLeft = tpStore->vetoCounterTPLeft;
+        sObject.vetoCounterTPRight = tpStore->vetoCounterTPRight;
+        sObject.calorimeterTPLeft = tpStore->calorimeterTPLeft;
+        sObject.calorimeterTPRight = tpStore->calorimeterTPRight;
+        sObject.productionModelData = pmData;
+        sObject.ApplyCalorimeterEDFloor( runManager->GetCalorimeterEDFloor() );
+        if ( replayOutput )
+        {
+            replayOutput->eventIsSaved = true;
+            return;
+        }
+        eventsWriter->Write( sObject );
+        GetRun()->IncrementNmbOfSavedEvents();
     }
 }
 
@@ -750,9 +893,8 @@ void  CexmcEventAction::SaveEventFast( const G4Event *  event,
     if ( runManager->GetEventDataVerboseLevel() == CexmcWriteNoEventData )
         return;
 
-    boost::archive::binary_oarchive *  archive(
-                                        runManager->GetFastEventsArchive() );
-    if ( archive )
+    CexmcEventsWriter *  eventsWriter( runManager->GetEventsWriter() );
+    if ( eventsWriter || replayOutput )
     {
         if ( ! tpDigitizerHasTriggered )
             opCosThetaSCM = CexmcInvalidCosTheta;
@@ -760,11 +902,14 @@ void  CexmcEventAction::SaveEventFast( const G4Event *  event,
         CexmcEventFastSObject  sObject = { event->GetEventID(), opCosThetaSCM,
                                            edDigitizerHasTriggered,
                                            edDigitizerMonitorHasTriggered };
-        archive->operator<<( sObject );
-        const CexmcRun *  run( static_cast< const CexmcRun * >(
-                                                runManager->GetCurrentRun() ) );
-        CexmcRun *        theRun( const_cast< CexmcRun * >( run ) );
-        theRun->IncrementNmbOfSavedFastEvents();
+        if ( replayOutput )
+        {
+            replayOutput->fastEvent = sObject;
+            replayOutput->fastEventIsSaved = true;
+            return;
+        }
+        eventsWriter->WriteFast( sObject );
+        GetRun()->IncrementNmbOfSavedFastEvents();
     }
 }
 
@@ -773,16 +918,18 @@ void  CexmcEventAction::SaveEventFast( const G4Event *  event,
 
 void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
 {
-    G4DigiManager *                digiManager( G4DigiManager::GetDMpointer() );
-    CexmcEnergyDepositDigitizer *  energyDepositDigitizer(
-            static_cast< CexmcEnergyDepositDigitizer * >( digiManager->
-                                FindDigitizerModule( CexmcEDDigitizerName ) ) );
-    CexmcTrackPointsDigitizer *    trackPointsDigitizer(
-            static_cast< CexmcTrackPointsDigitizer * >( digiManager->
-                                FindDigitizerModule( CexmcTPDigitizerName ) ) );
+    CEXMC_PROFILER_STOP( CexmcTransportStage );
 
-    energyDepositDigitizer->Digitize();
-    trackPointsDigitizer->Digitize();
+    /* a replay worker is not the current event of the run manager */
+    G4HCofThisEvent *  hcOfThisEvent( isReplayWorker ?
+                                      event->GetHCofThisEvent() : NULL );
+
+    CEXMC_PROFILER_START( CexmcEDDigitizationStage );
+    energyDepositDigitizer->Digitize( hcOfThisEvent );
+    CEXMC_PROFILER_STOP( CexmcEDDigitizationStage );
+    CEXMC_PROFILER_START( CexmcTPDigitizationStage );
+    trackPointsDigitizer->Digitize( hcOfThisEvent );
+    CEXMC_PROFILER_STOP( CexmcTPDigitizationStage );
 
     G4bool  edDigitizerMonitorHasTriggered(
                                 energyDepositDigitizer->MonitorHasTriggered() );
@@ -797,10 +944,7 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
     G4bool  reconstructorHasBasicTrigger( false );
     G4bool  reconstructorHasFullTrigger( false );
 
-    CexmcEnergyDepositStore *  edStore( MakeEnergyDepositStore(
-                                                    energyDepositDigitizer ) );
-    CexmcTrackPointsStore *    tpStore( MakeTrackPointsStore(
-                                                    trackPointsDigitizer ) );
+    UpdateEnergyDepositStore( edStore, energyDepositDigitizer );
 
     try
     {
@@ -812,14 +956,27 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
 
         const CexmcAngularRangeList &     angularRanges(
                                 productionModel->GetAngularRanges() );
+        const CexmcAngularRangeList *     theTriggeredAngularRanges(
+                                &productionModel->GetTriggeredAngularRanges() );
+        const CexmcProductionModelData *  thePmData(
+                                &productionModel->GetProductionModelData() );
+
+#ifdef CEXMC_USE_PERSISTENCY
+        if ( replayedTriggeredAngularRanges )
+            theTriggeredAngularRanges = replayedTriggeredAngularRanges;
+        if ( replayedPmData )
+            thePmData = replayedPmData;
+#endif
+
         const CexmcAngularRangeList &     triggeredAngularRanges(
-                                productionModel->GetTriggeredAngularRanges() );
-        const CexmcProductionModelData &  pmData(
-                                productionModel->GetProductionModelData() );
+                                                *theTriggeredAngularRanges );
+        const CexmcProductionModelData &  pmData( *thePmData );
 
         if ( edDigitizerHasTriggered )
         {
+            CEXMC_PROFILER_START( CexmcReconstructionStage );
             reconstructor->Reconstruct( edStore );
+            CEXMC_PROFILER_STOP( CexmcReconstructionStage );
             reconstructorHasBasicTrigger = reconstructor->HasBasicTrigger();
             reconstructorHasFullTrigger = reconstructor->HasFullTrigger();
         }
@@ -862,7 +1019,7 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
                        edDigitizerMonitorHasTriggered,
                        reconstructorHasFullTrigger, angularGap );
 
-        if ( verbose > 0 )
+        if ( verbose > 0 && ! isSecondaryOutput )
         {
             G4bool  printMessages( verbose > 3 ||
                         ( ( verbose == 1 ) && tpDigitizerHasTriggered ) ||
@@ -885,7 +1042,7 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
             }
         }
 
-        if ( verboseDraw > 0 )
+        if ( verboseDraw > 0 && ! isSecondaryOutput )
         {
             G4bool  drawTrajectories( verboseDraw > 3 ||
                         ( ( verboseDraw == 1 ) && tpDigitizerHasTriggered ) ||
@@ -905,35 +1062,44 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
 #ifdef CEXMC_USE_PERSISTENCY
         if ( edDigitizerHasTriggered || tpDigitizerHasTriggered )
         {
+            CEXMC_PROFILER_START( CexmcSaveEventStage );
             SaveEventFast( event, tpDigitizerHasTriggered,
                            edDigitizerHasTriggered,
                            edDigitizerMonitorHasTriggered,
                            pmData.outputParticleSCM.cosTheta() );
             SaveEvent( event, edDigitizerHasTriggered, edStore, tpStore,
                        pmData );
+            CEXMC_PROFILER_STOP( CexmcSaveEventStage );
         }
 #endif
 
 #ifdef CEXMC_USE_ROOT
-        /* opKinEnergy will be used in several histos */
-        if ( tpStore->targetTPOutputParticle.IsValid() )
+        if ( ! isSecondaryOutput )
         {
-            opKinEnergy = CexmcGetKinEnergy(
+            CEXMC_PROFILER_START( CexmcHistoFillingStage );
+
+            /* opKinEnergy will be used in several histos */
+            if ( tpStore->targetTPOutputParticle.IsValid() )
+            {
+                opKinEnergy = CexmcGetKinEnergy(
                     tpStore->targetTPOutputParticle.momentumAmp,
                     tpStore->targetTPOutputParticle.particle->GetPDGMass() );
-        }
+            }
 
-        if ( edDigitizerHasTriggered )
-            FillEDTHistos( edStore, triggeredAngularRanges );
+            if ( edDigitizerHasTriggered )
+                FillEDTHistos( edStore, triggeredAngularRanges );
 
-        /* fill TPT histos only when the monitor has triggered because events
-         * when it was missed have less value for us */
-        if ( tpDigitizerHasTriggered && edDigitizerMonitorHasTriggered )
-            FillTPTHistos( tpStore, pmData, triggeredAngularRanges );
+            /* fill TPT histos only when the monitor has triggered because
+             * events when it was missed have less value for us */
+            if ( tpDigitizerHasTriggered && edDigitizerMonitorHasTriggered )
+                FillTPTHistos( tpStore, pmData, triggeredAngularRanges );
 
-        if ( reconstructorHasBasicTrigger )
-            FillRTHistos( reconstructorHasFullTrigger, edStore, tpStore,
-                          pmData, triggeredAngularRanges );
+            if ( reconstructorHasBasicTrigger )
+                FillRTHistos( reconstructorHasFullTrigger, edStore, tpStore,
+                              pmData, triggeredAngularRanges );
+
+            CEXMC_PROFILER_STOP( CexmcHistoFillingStage );
+        }
 #endif
 
         G4Event *  theEvent( const_cast< G4Event * >( event ) );
@@ -949,14 +1115,23 @@ void  CexmcEventAction::EndOfEventAction( const G4Event *  event )
     }
     catch ( CexmcException &  e )
     {
-        G4cout << e.what() << G4endl;
+#ifdef CEXMC_USE_PERSISTENCY
+        /* a replay worker must not print, the message is printed by the run
+         * manager */
+        if ( replayOutput )
+            replayOutput->error = e.what();
+        else
+#endif
+            G4cout << e.what() << G4endl;
     }
     catch ( ... )
     {
-        G4cout << "Unknown exception caught" << G4endl;
+#ifdef CEXMC_USE_PERSISTENCY
+        if ( replayOutput )
+            replayOutput->error = "Unknown exception caught";
+        else
+#endif
+            G4cout << "Unknown exception caught" << G4endl;
     }
-
-    delete edStore;
-    delete tpStore;
 }
 
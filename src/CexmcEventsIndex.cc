@@ -0,0 +1,174 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcEventsIndex.cc
+ *
+ *    Description:  index of events data records (.idx file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 14:21:48
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CexmcEventsIndex.hh"
+#include "CexmcException.hh"
+
+
+const char            CexmcEventsIndex::magic[] = "CEXMCIDX";
+
+const boost::int32_t  CexmcEventsIndex::version( 1 );
+
+const std::streamoff  CexmcEventsIndex::headerSize( 16 );
+
+
+CexmcEventsIndex::CexmcEventsIndex( const G4String &  fileName,
+                                    G4bool  forWriting,
+                                    G4int  nmbOfRecordsToKeep ) :
+    isOpen( false ), nmbOfRecords( 0 ), nmbOfEDT( 0 )
+{
+    char            header[ headerSize ];
+    boost::int32_t  fileVersion( version );
+
+    if ( forWriting && nmbOfRecordsToKeep > 0 )
+    {
+        std::streamoff  size( headerSize +
+                              std::streamoff( nmbOfRecordsToKeep ) *
+                                        sizeof( CexmcEventsIndexRecord ) );
+        struct stat     st;
+
+        if ( stat( fileName.c_str(), &st ) != 0 || st.st_size < size )
+            throw CexmcException( CexmcReadProjectIncomplete );
+
+        if ( truncate( fileName.c_str(), size ) != 0 )
+            throw CexmcException( CexmcSystemException );
+
+        file.open( fileName.c_str(), std::ios::in | std::ios::out |
+                                     std::ios::binary );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+
+        nmbOfRecords = nmbOfRecordsToKeep;
+        isOpen = true;
+
+        CexmcEventsIndexRecord  record( Read( nmbOfRecords - 1 ) );
+        nmbOfEDT = record.nmbOfEDTBefore +
+                                    ( record.edDigitizerHasTriggered ? 1 : 0 );
+        file.seekp( 0, std::ios::end );
+
+        return;
+    }
+
+    if ( forWriting )
+    {
+        file.open( fileName.c_str(), std::ios::out | std::ios::trunc |
+                                     std::ios::binary );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+
+        std::memset( header, 0, headerSize );
+        std::memcpy( header, magic, 8 );
+        std::memcpy( header + 8, &fileVersion, sizeof( fileVersion ) );
+        if ( ! file.write( header, headerSize ) )
+            throw CexmcException( CexmcSystemException );
+        isOpen = true;
+
+        return;
+    }
+
+    /* absence of the index is not an error: the project could have been
+     * written by an older version of the program */
+    file.open( fileName.c_str(), std::ios::in | std::ios::binary );
+    if ( ! file )
+        return;
+
+    if ( ! file.read( header, headerSize ) ||
+         std::memcmp( header, magic, 8 ) != 0 )
+        return;
+
+    std::memcpy( &fileVersion, header + 8, sizeof( fileVersion ) );
+    if ( fileVersion != version )
+        return;
+
+    file.seekg( 0, std::ios::end );
+    std::streamoff  size( std::streamoff( file.tellg() ) - headerSize );
+    if ( size < 0 || size % sizeof( CexmcEventsIndexRecord ) != 0 )
+        return;
+
+    nmbOfRecords = G4int( size / sizeof( CexmcEventsIndexRecord ) );
+    isOpen = true;
+
+    if ( nmbOfRecords > 0 )
+    {
+        CexmcEventsIndexRecord  record( Read( nmbOfRecords - 1 ) );
+        nmbOfEDT = record.nmbOfEDTBefore +
+                                    ( record.edDigitizerHasTriggered ? 1 : 0 );
+    }
+}
+
+
+void  CexmcEventsIndex::Write( boost::int64_t  fastEventsDataOffset,
+                               boost::int64_t  eventsDataOffset,
+                               G4bool  edDigitizerHasTriggered )
+{
+    CexmcEventsIndexRecord  record = { fastEventsDataOffset, eventsDataOffset,
+                                       nmbOfEDT, edDigitizerHasTriggered };
+
+    if ( ! file.write( reinterpret_cast< const char * >( &record ),
+                       sizeof( record ) ) )
+        throw CexmcException( CexmcSystemException );
+
+    ++nmbOfRecords;
+    if ( edDigitizerHasTriggered )
+        ++nmbOfEDT;
+}
+
+
+CexmcEventsIndexRecord  CexmcEventsIndex::Read( G4int  index )
+{
+    CexmcEventsIndexRecord  record;
+
+    if ( index < 0 || index >= nmbOfRecords )
+        throw CexmcException( CexmcWeirdException );
+
+    file.clear();
+    file.seekg( headerSize + std::streamoff( index ) * sizeof( record ) );
+    if ( ! file.read( reinterpret_cast< char * >( &record ),
+                      sizeof( record ) ) )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    return record;
+}
+
+
+G4int  CexmcEventsIndex::FindFirstRecordAfterEDT( G4int  nmbOfEDT_ )
+{
+    G4int  first( 0 );
+    G4int  last( nmbOfRecords );
+
+    /* nmbOfEDTBefore is not decreasing: lower bound search */
+    while ( first < last )
+    {
+        G4int  middle( first + ( last - first ) / 2 );
+
+        if ( Read( middle ).nmbOfEDTBefore < nmbOfEDT_ )
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return first;
+}
+
+#endif
+
@@ -0,0 +1,362 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcEventsReader.cc
+ *
+ *    Description:  read-ahead reader of events data (.fdb and .edb or .cdb
+ *                  files)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 11:58:31
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <algorithm>
+#include "CexmcEventsReader.hh"
+#include "CexmcColumnarEventsStore.hh"
+#include "CexmcCompressedStreambuf.hh"
+#include "CexmcException.hh"
+#ifdef CEXMC_USE_CUSTOM_FILTER
+#include "CexmcCustomFilterEval.hh"
+#include "CexmcEventsSelection.hh"
+#endif
+
+
+CexmcEventsReader::CexmcEventsReader( const G4String &  eventsDataFileName,
+                                const G4String &  fastEventsDataFileName,
+                                G4int  nmbOfRecords,
+                                G4bool  eventDataWrittenOnEveryTPT,
+                                CexmcEventDataFormat  eventDataFormat,
+                                CexmcEventDataCodec  eventDataCodec,
+                                const CexmcEventsIndexRecord *  startRecord,
+                                const CexmcCustomFilterEval *  filter,
+                                CexmcEventsIndex *  eventsIndex,
+                                G4int  firstIndexRecord,
+                                const CexmcEventsSelection *  selection,
+                                G4int  chunkSize, G4int  maxChunks ) :
+    fastEventsDataFile( fastEventsDataFileName.c_str() ),
+    eventsDataDecompressor( NULL ), fastEventsDataDecompressor( NULL ),
+    eventsDataStream( NULL ), fastEventsDataStream( NULL ), evArchive( NULL ),
+    evFastArchive( NULL ), columnarStore( NULL ), columnarRecord( 0 ),
+    evArchiveIsPrimed( false ), filter( filter ),
+    eventsIndex( eventsIndex ), firstIndexRecord( firstIndexRecord ),
+    selection( selection ),
+    nmbOfRecords( nmbOfRecords ), nmbOfRecordsRead( 0 ),
+    eventDataWrittenOnEveryTPT( eventDataWrittenOnEveryTPT ),
+    chunkSize( chunkSize > 0 ? chunkSize : 1 ),
+    maxChunks( maxChunks > 0 ? maxChunks : 1 ), curRecord( 0 )
+#ifdef CEXMC_USE_THREADS
+    , done( false ), failed( false ), stopped( false ), thread( NULL )
+#endif
+{
+    if ( ! fastEventsDataFile )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    fastEventsDataStream.rdbuf( fastEventsDataFile.rdbuf() );
+    if ( eventDataCodec != CexmcNoEventDataCodec )
+    {
+        fastEventsDataDecompressor = new CexmcCompressedInputStreambuf(
+                                fastEventsDataFile.rdbuf(), eventDataCodec );
+        fastEventsDataStream.rdbuf( fastEventsDataDecompressor );
+    }
+
+    evFastArchive = new boost::archive::binary_iarchive(
+                                                    fastEventsDataStream );
+
+    switch ( eventDataFormat )
+    {
+    case CexmcColumnarEventDataFormat :
+        columnarStore = new CexmcColumnarEventsStore( eventsDataFileName );
+        break;
+    default :
+        eventsDataFile.open( eventsDataFileName.c_str() );
+        if ( ! eventsDataFile )
+            throw CexmcException( CexmcReadProjectIncomplete );
+        eventsDataStream.rdbuf( eventsDataFile.rdbuf() );
+        if ( eventDataCodec != CexmcNoEventDataCodec )
+        {
+            eventsDataDecompressor = new CexmcCompressedInputStreambuf(
+                                    eventsDataFile.rdbuf(), eventDataCodec );
+            eventsDataStream.rdbuf( eventsDataDecompressor );
+        }
+        evArchive = new boost::archive::binary_iarchive( eventsDataStream );
+        break;
+    }
+
+    if ( startRecord )
+        SeekTo( *startRecord );
+
+#ifdef CEXMC_USE_THREADS
+    thread = new boost::thread( &CexmcEventsReader::Run, this );
+#endif
+}
+
+
+CexmcEventsReader::~CexmcEventsReader()
+{
+#ifdef CEXMC_USE_THREADS
+    Stop();
+    delete thread;
+#endif
+    delete columnarStore;
+    delete evFastArchive;
+    delete evArchive;
+    delete eventsDataDecompressor;
+    delete fastEventsDataDecompressor;
+}
+
+
+void  CexmcEventsReader::SeekTo( const CexmcEventsIndexRecord &  record )
+{
+    /* in the columnar format position of an events data record is its
+     * ordinal number */
+    if ( columnarStore )
+        columnarRecord = G4int( record.eventsDataOffset );
+
+    std::streamoff  eventsDataStart( eventsDataStream.tellg() );
+    std::streamoff  fastEventsDataStart( fastEventsDataStream.tellg() );
+
+    CexmcEventFastSObject  evFastSObject;
+    CexmcEventSObject      evSObject;
+
+    /* an archive writes class information only before the first object of
+     * the class, so the first record must be read before jumping to an
+     * arbitrary position */
+    try
+    {
+        if ( record.fastEventsDataOffset > fastEventsDataStart )
+        {
+            *evFastArchive >> evFastSObject;
+            fastEventsDataStream.seekg( record.fastEventsDataOffset );
+        }
+        if ( ! columnarStore && record.eventsDataOffset > eventsDataStart )
+        {
+            *evArchive >> evSObject;
+            evArchiveIsPrimed = true;
+            eventsDataStream.seekg( record.eventsDataOffset );
+        }
+    }
+    catch ( const boost::archive::archive_exception & )
+    {
+        throw CexmcException( CexmcReadProjectIncomplete );
+    }
+
+    if ( ( ! columnarStore && ! eventsDataStream ) || ! fastEventsDataStream )
+        throw CexmcException( CexmcReadProjectIncomplete );
+}
+
+
+void  CexmcEventsReader::ReadChunk( CexmcReadEventDataChunk &  chunk )
+{
+    G4int  nmbOfRecordsInChunk( std::min( chunkSize,
+                                          nmbOfRecords - nmbOfRecordsRead ) );
+
+    chunk.resize( nmbOfRecordsInChunk );
+
+    G4int  indexRecord( firstIndexRecord + nmbOfRecordsRead );
+
+    /* fast events data and events data are read from different streams,
+     * so all fast events data records of the chunk can be read first */
+    for ( CexmcReadEventDataChunk::iterator  k( chunk.begin() );
+                                                    k != chunk.end(); ++k )
+    {
+        *evFastArchive >> k->evFastSObject;
+        k->hasEventData = eventDataWrittenOnEveryTPT ||
+                          k->evFastSObject.edDigitizerHasTriggered;
+        k->isFiltered = false;
+    }
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    G4bool  useFastTPT( filter && filter->HasFastTPT() && ! chunk.empty() );
+
+    if ( useFastTPT )
+        filter->EvalFastTPT( &chunk[ 0 ].evFastSObject,
+                             sizeof( CexmcReadEventData ), nmbOfRecordsInChunk,
+                             fastTPTResult );
+#endif
+
+    for ( CexmcReadEventDataChunk::iterator  k( chunk.begin() );
+                                        k != chunk.end(); ++k, ++indexRecord )
+    {
+        if ( ! k->hasEventData )
+            continue;
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        if ( selection )
+            k->isFiltered = ! selection->IsSelectedByTPT( indexRecord );
+        if ( ! k->isFiltered && useFastTPT )
+            k->isFiltered = ! fastTPTResult[ k - chunk.begin() ];
+        if ( k->isFiltered && SkipEventData( indexRecord ) )
+            continue;
+#endif
+        if ( columnarStore )
+        {
+            columnarStore->Read( columnarRecord++, k->evSObject );
+        }
+        else
+        {
+            *evArchive >> k->evSObject;
+            evArchiveIsPrimed = true;
+        }
+    }
+
+    nmbOfRecordsRead += nmbOfRecordsInChunk;
+}
+
+
+G4bool  CexmcEventsReader::Next( CexmcEventFastSObject &  evFastSObject,
+                                 CexmcEventSObject &  evSObject )
+{
+    if ( curRecord >= curChunk.size() )
+    {
+        curRecord = 0;
+#ifdef CEXMC_USE_THREADS
+        {
+            boost::mutex::scoped_lock  lock( mutex );
+
+            while ( chunks.empty() && ! done )
+                chunkReady.wait( lock );
+
+            if ( chunks.empty() )
+            {
+                if ( failed )
+                    throw CexmcException( CexmcReadProjectIncomplete );
+                throw CexmcException( CexmcWeirdException );
+            }
+
+            if ( ! curChunk.empty() )
+            {
+                freeChunks.push_back( CexmcReadEventDataChunk() );
+                freeChunks.back().swap( curChunk );
+            }
+            curChunk.swap( chunks.front() );
+            chunks.pop_front();
+        }
+        chunkConsumed.notify_one();
+#else
+        if ( nmbOfRecordsRead >= nmbOfRecords )
+            throw CexmcException( CexmcWeirdException );
+
+        try
+        {
+            ReadChunk( curChunk );
+        }
+        catch ( const boost::archive::archive_exception & )
+        {
+            throw CexmcException( CexmcReadProjectIncomplete );
+        }
+#endif
+    }
+
+    CexmcReadEventData &  record( curChunk[ curRecord++ ] );
+
+    evFastSObject = record.evFastSObject;
+
+    if ( ! record.hasEventData || record.isFiltered )
+        return false;
+
+    evSObject.Swap( record.evSObject );
+
+    return true;
+}
+
+
+G4bool  CexmcEventsReader::SkipEventData( G4int  indexRecord )
+{
+    if ( columnarStore )
+    {
+        ++columnarRecord;
+        return true;
+    }
+
+    /* the size of the record is found from the offset of the next events
+     * data record which is also written for records without events data */
+    if ( ! eventsIndex || ! evArchiveIsPrimed ||
+         indexRecord + 1 >= eventsIndex->GetNmbOfRecords() )
+        return false;
+
+    CexmcEventsIndexRecord  curRecordData( eventsIndex->Read( indexRecord ) );
+    CexmcEventsIndexRecord  nextRecordData(
+                                    eventsIndex->Read( indexRecord + 1 ) );
+
+    eventsDataStream.ignore( std::streamsize(
+                                        nextRecordData.eventsDataOffset -
+                                        curRecordData.eventsDataOffset ) );
+
+    if ( ! eventsDataStream )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    return true;
+}
+
+
+#ifdef CEXMC_USE_THREADS
+
+void  CexmcEventsReader::Run( void )
+{
+    try
+    {
+        while ( nmbOfRecordsRead < nmbOfRecords )
+        {
+            CexmcReadEventDataChunk  chunk;
+
+            {
+                boost::mutex::scoped_lock  lock( mutex );
+
+                if ( ! freeChunks.empty() )
+                {
+                    chunk.swap( freeChunks.front() );
+                    freeChunks.pop_front();
+                }
+            }
+
+            ReadChunk( chunk );
+
+            boost::mutex::scoped_lock  lock( mutex );
+
+            while ( G4int( chunks.size() ) >= maxChunks && ! stopped )
+                chunkConsumed.wait( lock );
+
+            if ( stopped )
+                return;
+
+            chunks.push_back( CexmcReadEventDataChunk() );
+            chunks.back().swap( chunk );
+            chunkReady.notify_one();
+        }
+    }
+    catch ( ... )
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+        failed = true;
+    }
+
+    boost::mutex::scoped_lock  lock( mutex );
+    done = true;
+    chunkReady.notify_one();
+}
+
+
+void  CexmcEventsReader::Stop( void )
+{
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+        stopped = true;
+    }
+    chunkConsumed.notify_one();
+
+    if ( thread )
+        thread->join();
+}
+
+#endif
+
+#endif
+
@@ -0,0 +1,124 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcEventsSelection.cc
+ *
+ *    Description:  custom filter decisions on events (.sel file)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 16:52:07
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+
+#include <cstring>
+#include "CexmcEventsSelection.hh"
+#include "CexmcException.hh"
+
+
+const char            CexmcEventsSelection::magic[] = "CEXMCSEL";
+
+const boost::int32_t  CexmcEventsSelection::version( 1 );
+
+const std::streamoff  CexmcEventsSelection::headerSize( 16 );
+
+
+CexmcEventsSelection::CexmcEventsSelection( G4int  nmbOfRecords ) :
+    nmbOfRecords( nmbOfRecords > 0 ? nmbOfRecords : 0 )
+{
+    tptBits.resize( ( this->nmbOfRecords + 7 ) / 8, 0 );
+    edtBits.resize( ( this->nmbOfRecords + 7 ) / 8, 0 );
+}
+
+
+CexmcEventsSelection::CexmcEventsSelection( const G4String &  fileName ) :
+    nmbOfRecords( 0 )
+{
+    std::ifstream   file( fileName.c_str(), std::ios::in | std::ios::binary );
+    char            header[ headerSize ];
+    boost::int32_t  fileVersion( 0 );
+    boost::int32_t  fileNmbOfRecords( 0 );
+
+    if ( ! file )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    if ( ! file.read( header, headerSize ) ||
+         std::memcmp( header, magic, 8 ) != 0 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    std::memcpy( &fileVersion, header + 8, sizeof( fileVersion ) );
+    std::memcpy( &fileNmbOfRecords, header + 12, sizeof( fileNmbOfRecords ) );
+    if ( fileVersion != version || fileNmbOfRecords < 0 )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    nmbOfRecords = fileNmbOfRecords;
+    tptBits.resize( ( nmbOfRecords + 7 ) / 8 );
+    edtBits.resize( ( nmbOfRecords + 7 ) / 8 );
+
+    if ( nmbOfRecords == 0 )
+        return;
+
+    if ( ! file.read( reinterpret_cast< char * >( &tptBits[ 0 ] ),
+                      tptBits.size() ) ||
+         ! file.read( reinterpret_cast< char * >( &edtBits[ 0 ] ),
+                      edtBits.size() ) )
+        throw CexmcException( CexmcReadProjectIncomplete );
+}
+
+
+void  CexmcEventsSelection::Write( const G4String &  fileName ) const
+{
+    std::ofstream   file( fileName.c_str(), std::ios::out | std::ios::trunc |
+                                            std::ios::binary );
+    char            header[ headerSize ];
+    boost::int32_t  fileNmbOfRecords( nmbOfRecords );
+
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+
+    std::memset( header, 0, headerSize );
+    std::memcpy( header, magic, 8 );
+    std::memcpy( header + 8, &version, sizeof( version ) );
+    std::memcpy( header + 12, &fileNmbOfRecords, sizeof( fileNmbOfRecords ) );
+    file.write( header, headerSize );
+
+    if ( nmbOfRecords > 0 )
+    {
+        file.write( reinterpret_cast< const char * >( &tptBits[ 0 ] ),
+                    tptBits.size() );
+        file.write( reinterpret_cast< const char * >( &edtBits[ 0 ] ),
+                    edtBits.size() );
+    }
+
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+G4int  CexmcEventsSelection::GetNmbOfSelectedByEDT( void ) const
+{
+    G4int  result( 0 );
+
+    for ( std::vector< unsigned char >::const_iterator  k( edtBits.begin() );
+                                                    k != edtBits.end(); ++k )
+    {
+        for ( unsigned char  byte( *k ); byte != 0; byte &= byte - 1 )
+            ++result;
+    }
+
+    return result;
+}
+
+#endif
+
+#endif
+
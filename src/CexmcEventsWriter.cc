@@ -0,0 +1,516 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcEventsWriter.cc
+ *
+ *    Description:  writer of events data (.fdb, .edb or .cdb and .idx files)
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 17:15:20
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <sys/stat.h>
+#include <unistd.h>
+#include "CexmcEventsWriter.hh"
+#include "CexmcColumnarEventsStore.hh"
+#include "CexmcCompressedStreambuf.hh"
+#include "CexmcException.hh"
+
+
+namespace
+{
+    /* number of events in a block of the columnar events data file */
+    const G4int  columnarBlockSize( 256 );
+
+    /* size of buffers of the events data files */
+    const std::size_t  fileBufferSize( 1 << 20 );
+}
+
+
+CexmcEventsWriter::CexmcEventsWriter( const G4String &  projectPath,
+                                CexmcEventDataFormat  eventDataFormat,
+                                CexmcEventDataCodec  eventDataCodec,
+                                const CexmcEventsWriterState *  state,
+                                G4int  maxRecords ) :
+    eventDataFormat( eventDataFormat ), eventsDataCompressor( NULL ),
+    fastEventsDataCompressor( NULL ), eventsDataStream( NULL ),
+    fastEventsDataStream( NULL ), evArchive( NULL ), evFastArchive( NULL ),
+    columnarStore( NULL ),
+    eventsIndex( projectPath + ".idx", true,
+                 state ? state->nmbOfFastEventsWritten : 0 ),
+    nmbOfFastEventsWritten( state ? state->nmbOfFastEventsWritten : 0 ),
+    nmbOfEventsWritten( state ? state->nmbOfEventsWritten : 0 ),
+    isClosed( false )
+#ifdef CEXMC_USE_THREADS
+    , maxRecords( maxRecords > 0 ? maxRecords : 1 ), failed( false ),
+    stopped( false ), writing( false ), thread( NULL )
+#endif
+{
+    evFastArchive = OpenArchive< CexmcEventFastSObject >(
+                projectPath + ".fdb", fastEventsDataFile, fastEventsDataBuffer,
+                fastEventsDataCompressor, fastEventsDataStream, eventDataCodec,
+                nmbOfFastEventsWritten, state ? state->fastEventsDataSize : 0,
+                state ? state->fastEventsDataBlockStart : 0,
+                state ? &state->fastEventsDataPending : NULL );
+
+    switch ( eventDataFormat )
+    {
+    case CexmcColumnarEventDataFormat :
+        columnarStore = new CexmcColumnarEventsStore( projectPath + ".cdb",
+                                        columnarBlockSize, nmbOfEventsWritten );
+        break;
+    default :
+        evArchive = OpenArchive< CexmcEventSObject >(
+                projectPath + ".edb", eventsDataFile, eventsDataBuffer,
+                eventsDataCompressor, eventsDataStream, eventDataCodec,
+                nmbOfEventsWritten, state ? state->eventsDataSize : 0,
+                state ? state->eventsDataBlockStart : 0,
+                state ? &state->eventsDataPending : NULL );
+        break;
+    }
+
+#ifdef CEXMC_USE_THREADS
+    records.reserve( this->maxRecords );
+    batch.reserve( this->maxRecords );
+    thread = new boost::thread( &CexmcEventsWriter::Run, this );
+#endif
+}
+
+
+CexmcEventsWriter::~CexmcEventsWriter()
+{
+    /* normally the writer is closed by its owner, here the writer gets
+     * destroyed because of another error which is being reported */
+    try
+    {
+        Close();
+    }
+    catch ( ... )
+    {
+    }
+
+#ifdef CEXMC_USE_THREADS
+    /* records which were not written because of an error */
+    for ( std::vector< CexmcWriteEventData >::iterator  k( records.begin() );
+                                                    k != records.end(); ++k )
+        delete k->evSObject;
+    for ( std::vector< CexmcWriteEventData >::iterator  k( batch.begin() );
+                                                    k != batch.end(); ++k )
+        delete k->evSObject;
+    for ( std::vector< CexmcEventSObject * >::iterator  k( freeEvents.begin() );
+                                                k != freeEvents.end(); ++k )
+        delete *k;
+#endif
+    delete columnarStore;
+    delete eventsDataCompressor;
+    delete fastEventsDataCompressor;
+}
+
+
+void  CexmcEventsWriter::WriteFast(
+                                const CexmcEventFastSObject &  evFastSObject )
+{
+#ifdef CEXMC_USE_THREADS
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        WaitForRoom( lock );
+
+        records.push_back( CexmcWriteEventData() );
+        records.back().evFastSObject = evFastSObject;
+    }
+    recordsReady.notify_one();
+#else
+    DoWriteFast( evFastSObject );
+#endif
+}
+
+
+void  CexmcEventsWriter::Write( const CexmcEventSObject &  evSObject )
+{
+#ifdef CEXMC_USE_THREADS
+    CexmcEventSObject *  sObject( NULL );
+
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        WaitForRoom( lock );
+
+        if ( ! freeEvents.empty() )
+        {
+            sObject = freeEvents.back();
+            freeEvents.pop_back();
+        }
+    }
+
+    /* events data are copied without holding the lock, this is the only
+     * thread which puts records in the queue, so the room cannot be taken */
+    if ( ! sObject )
+        sObject = new CexmcEventSObject;
+
+    try
+    {
+        *sObject = evSObject;
+    }
+    catch ( ... )
+    {
+        delete sObject;
+        throw;
+    }
+
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        records.push_back( CexmcWriteEventData() );
+        records.back().evSObject = sObject;
+    }
+    recordsReady.notify_one();
+#else
+    DoWrite( evSObject );
+#endif
+}
+
+
+void  CexmcEventsWriter::Checkpoint( CexmcEventsWriterState &  state )
+{
+#ifdef CEXMC_USE_THREADS
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        WaitUntilWritten( lock );
+    }
+    /* the writing thread waits for new records now, it won't access the files
+     * until the caller puts a record in the queue */
+#endif
+
+    state.nmbOfFastEventsWritten = nmbOfFastEventsWritten;
+    state.nmbOfEventsWritten = nmbOfEventsWritten;
+
+    GetStreamState( fastEventsDataStream, fastEventsDataCompressor,
+                    state.fastEventsDataSize, state.fastEventsDataBlockStart,
+                    state.fastEventsDataPending );
+
+    if ( columnarStore )
+    {
+        columnarStore->Flush();
+        state.eventsDataSize = 0;
+        state.eventsDataBlockStart = 0;
+        state.eventsDataPending.clear();
+    }
+    else
+    {
+        GetStreamState( eventsDataStream, eventsDataCompressor,
+                        state.eventsDataSize, state.eventsDataBlockStart,
+                        state.eventsDataPending );
+    }
+
+    if ( ! eventsIndex.Flush() )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+void  CexmcEventsWriter::Close( void )
+{
+    if ( isClosed )
+        return;
+
+    isClosed = true;
+
+    G4bool  writeFailed( false );
+
+#ifdef CEXMC_USE_THREADS
+    Stop();
+    delete thread;
+    thread = NULL;
+    writeFailed = failed;
+#endif
+
+    /* archives may write into the streams when they get deleted, so they
+     * are deleted before the compressors write their last blocks */
+    delete evArchive;
+    evArchive = NULL;
+    delete evFastArchive;
+    evFastArchive = NULL;
+
+    if ( columnarStore )
+    {
+        try
+        {
+            columnarStore->Flush();
+        }
+        catch ( CexmcException & )
+        {
+            writeFailed = true;
+        }
+    }
+
+    CexmcCompressedOutputStreambuf *  compressors[] =
+                            { eventsDataCompressor, fastEventsDataCompressor };
+
+    for ( G4int  i( 0 ); i < 2; ++i )
+    {
+        if ( ! compressors[ i ] )
+            continue;
+        try
+        {
+            compressors[ i ]->Close();
+        }
+        catch ( CexmcException & )
+        {
+            writeFailed = true;
+        }
+    }
+
+    if ( eventsDataFile.is_open() )
+    {
+        writeFailed = writeFailed || ! eventsDataStream.flush();
+        eventsDataFile.close();
+        writeFailed = writeFailed || ! eventsDataFile;
+    }
+    if ( fastEventsDataFile.is_open() )
+    {
+        writeFailed = writeFailed || ! fastEventsDataStream.flush();
+        fastEventsDataFile.close();
+        writeFailed = writeFailed || ! fastEventsDataFile;
+    }
+
+    writeFailed = writeFailed || ! eventsIndex.Flush();
+
+    if ( writeFailed )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+template  < typename  SObject >
+boost::archive::binary_oarchive *  CexmcEventsWriter::OpenArchive(
+                        const G4String &  fileName, std::ofstream &  file,
+                        std::vector< char > &  buffer,
+                        CexmcCompressedOutputStreambuf *&  compressor,
+                        std::ostream &  stream,
+                        CexmcEventDataCodec  eventDataCodec,
+                        G4int  nmbOfRecordsWritten, boost::int64_t  size,
+                        boost::int64_t  blockStart,
+                        const std::vector< char > *  pending )
+{
+    /* stream buffers must be set before the files are opened */
+    buffer.resize( fileBufferSize );
+    file.rdbuf()->pubsetbuf( &buffer[ 0 ], buffer.size() );
+
+    if ( ! pending )
+    {
+        file.open( fileName.c_str() );
+        if ( ! file )
+            throw CexmcException( CexmcSystemException );
+
+        stream.rdbuf( file.rdbuf() );
+        if ( eventDataCodec != CexmcNoEventDataCodec )
+        {
+            compressor = new CexmcCompressedOutputStreambuf( file.rdbuf(),
+                                                             eventDataCodec );
+            stream.rdbuf( compressor );
+        }
+
+        return new boost::archive::binary_oarchive( stream );
+    }
+
+    struct stat  st;
+
+    if ( stat( fileName.c_str(), &st ) != 0 || st.st_size < size )
+        throw CexmcException( CexmcReadProjectIncomplete );
+
+    file.open( fileName.c_str(), std::ios::in | std::ios::out );
+    if ( ! file || ! file.seekp( size ) )
+        throw CexmcException( CexmcSystemException );
+
+    stream.rdbuf( file.rdbuf() );
+    if ( eventDataCodec != CexmcNoEventDataCodec )
+    {
+        compressor = new CexmcCompressedOutputStreambuf( file.rdbuf(),
+                                            eventDataCodec, blockStart, size );
+        stream.rdbuf( compressor );
+    }
+
+    boost::archive::binary_oarchive *  archive(
+            new boost::archive::binary_oarchive( stream,
+                                                 boost::archive::no_header ) );
+
+    /* an archive writes class information along with the first object of the
+     * class: a dummy object is written and then discarded, so that the next
+     * objects are written exactly as they would be without interruption */
+    if ( nmbOfRecordsWritten > 0 )
+    {
+        const SObject  sObject = SObject();
+
+        archive->operator<<( sObject );
+        stream.seekp( blockStart );
+        stream.flush();
+    }
+
+    if ( ! stream || truncate( fileName.c_str(), size ) != 0 )
+    {
+        delete archive;
+        throw CexmcException( CexmcSystemException );
+    }
+
+    if ( ! pending->empty() )
+        stream.write( &pending->operator[]( 0 ), pending->size() );
+
+    return archive;
+}
+
+
+void  CexmcEventsWriter::GetStreamState( std::ostream &  stream,
+                        CexmcCompressedOutputStreambuf *  compressor,
+                        boost::int64_t &  size, boost::int64_t &  blockStart,
+                        std::vector< char > &  pending )
+{
+    stream.flush();
+    if ( ! stream )
+        throw CexmcException( CexmcSystemException );
+
+    if ( compressor )
+    {
+        size = compressor->GetStoredSize();
+        blockStart = compressor->GetBlockStart();
+        compressor->GetPendingData( pending );
+        return;
+    }
+
+    size = std::streamoff( stream.tellp() );
+    blockStart = size;
+    pending.clear();
+}
+
+
+void  CexmcEventsWriter::DoWriteFast(
+                                const CexmcEventFastSObject &  evFastSObject )
+{
+    /* in the columnar format position of an events data record is its
+     * ordinal number */
+    boost::int64_t  eventsDataOffset( columnarStore ? nmbOfEventsWritten :
+                        boost::int64_t( std::streamoff(
+                                                eventsDataStream.tellp() ) ) );
+
+    eventsIndex.Write( std::streamoff( fastEventsDataStream.tellp() ),
+                       eventsDataOffset,
+                       evFastSObject.edDigitizerHasTriggered );
+
+    evFastArchive->operator<<( evFastSObject );
+
+    ++nmbOfFastEventsWritten;
+}
+
+
+void  CexmcEventsWriter::DoWrite( const CexmcEventSObject &  evSObject )
+{
+    if ( columnarStore )
+        columnarStore->Write( evSObject );
+    else
+        evArchive->operator<<( evSObject );
+
+    ++nmbOfEventsWritten;
+}
+
+
+#ifdef CEXMC_USE_THREADS
+
+void  CexmcEventsWriter::WaitForRoom( boost::mutex::scoped_lock &  lock )
+{
+    while ( G4int( records.size() ) >= maxRecords && ! failed )
+        recordsTaken.wait( lock );
+
+    if ( failed )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+void  CexmcEventsWriter::WaitUntilWritten( boost::mutex::scoped_lock &  lock )
+{
+    while ( ( ! records.empty() || writing ) && ! failed )
+        recordsTaken.wait( lock );
+
+    if ( failed )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+void  CexmcEventsWriter::Run( void )
+{
+    try
+    {
+        for ( ;; )
+        {
+            {
+                boost::mutex::scoped_lock  lock( mutex );
+
+                while ( records.empty() && ! stopped )
+                    recordsReady.wait( lock );
+
+                /* all records are written before stopping */
+                if ( records.empty() )
+                    break;
+
+                batch.swap( records );
+                writing = true;
+            }
+            recordsTaken.notify_all();
+
+            for ( std::vector< CexmcWriteEventData >::const_iterator
+                    k( batch.begin() ); k != batch.end(); ++k )
+            {
+                if ( k->evSObject )
+                    DoWrite( *k->evSObject );
+                else
+                    DoWriteFast( k->evFastSObject );
+            }
+
+            {
+                boost::mutex::scoped_lock  lock( mutex );
+
+                for ( std::vector< CexmcWriteEventData >::const_iterator
+                        k( batch.begin() ); k != batch.end(); ++k )
+                {
+                    if ( k->evSObject )
+                        freeEvents.push_back( k->evSObject );
+                }
+                batch.clear();
+                writing = false;
+            }
+            recordsTaken.notify_all();
+        }
+    }
+    catch ( ... )
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+        failed = true;
+    }
+
+    recordsTaken.notify_all();
+}
+
+
+void  CexmcEventsWriter::Stop( void )
+{
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+        stopped = true;
+    }
+    recordsReady.notify_one();
+
+    if ( thread )
+        thread->join();
+}
+
+#endif
+
+#endif
+
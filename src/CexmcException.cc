@@ -111,6 +111,10 @@ const char *  CexmcException::what( void ) const throw()
     case CexmcInvalidAngularRange :
         return CEXMC_LINE_START "An angular range is not valid. "
                 "Check specified angular ranges.";
+    case CexmcCheckpointMismatch :
+        return CEXMC_LINE_START "Checkpoint does not match the current run. "
+                "Make sure that the project is resumed with the same macros "
+                "or remove its checkpoint file.";
 #ifdef CEXMC_USE_CUSTOM_FILTER
     case CexmcCFBadSource :
         return CEXMC_LINE_START "Custom filter source file does not exist or "
@@ -141,6 +145,10 @@ const char *  CexmcException::what( void ) const throw()
         return CEXMC_LINE_START "Custom filter: a vector variable with wrong "
                 "index. Indices of vectors should start from 1. Check your "
                 "custom filter script.";
+    case CexmcCFSelectionMismatch :
+        return CEXMC_LINE_START "Custom filter: events selection does not "
+                "match the read project. Make sure that the selection was "
+                "saved when replaying this project.";
 #endif
     case CexmcWeirdException :
         return CEXMC_LINE_START "A weird exception occured. "
@@ -94,8 +94,8 @@ void  CexmcHistoManager::Destroy( void )
 
 
 CexmcHistoManager::CexmcHistoManager() : outFile( NULL ),
-    isInitialized( false ), opName( "" ), nopName( "" ), opMass( 0. ),
-    nopMass( 0. ), verboseLevel( 0 ),
+    isInitialized( false ), isWorker( false ), opName( "" ), nopName( "" ),
+    opMass( 0. ), nopMass( 0. ), verboseLevel( 0 ),
 #ifdef CEXMC_USE_ROOTQT
     rootCanvas( NULL ), areLiveHistogramsEnabled( false ),
     isHistoMenuInitialized( false ), drawOptions1D( "" ), drawOptions2D( "" ),
@@ -113,8 +113,49 @@ CexmcHistoManager::CexmcHistoManager() : outFile( NULL ),
 }
 
 
+CexmcHistoManager::CexmcHistoManager(
+                                    const CexmcHistoManager &  histoManager ) :
+    outFile( NULL ), isInitialized( histoManager.isInitialized ),
+    isWorker( true ), opName( histoManager.opName ),
+    nopName( histoManager.nopName ), opMass( histoManager.opMass ),
+    nopMass( histoManager.nopMass ), verboseLevel( histoManager.verboseLevel ),
+#ifdef CEXMC_USE_ROOTQT
+    rootCanvas( NULL ), areLiveHistogramsEnabled( false ),
+    isHistoMenuInitialized( false ), drawOptions1D( "" ), drawOptions2D( "" ),
+    drawOptions3D( "" ), histoMenuHandle( "" ), histoMenuLabel( "" ),
+#endif
+    messenger( NULL )
+{
+    for ( CexmcHistosMap::const_iterator  k( histoManager.histos.begin() );
+                                        k != histoManager.histos.end(); ++k )
+    {
+        CexmcHistoVector &  histoVector( histos[ k->first ] );
+
+        for ( CexmcHistoVector::const_iterator  l( k->second.begin() );
+                                                l != k->second.end(); ++l )
+        {
+            TH1 *  histo( static_cast< TH1 * >( ( *l )->Clone() ) );
+            histo->SetDirectory( NULL );
+            histo->Reset();
+            histoVector.push_back( histo );
+        }
+    }
+}
+
+
 CexmcHistoManager::~CexmcHistoManager()
 {
+    if ( isWorker )
+    {
+        for ( CexmcHistosMap::iterator  k( histos.begin() );
+                                                    k != histos.end(); ++k )
+        {
+            for ( CexmcHistoVector::iterator  l( k->second.begin() );
+                                                l != k->second.end(); ++l )
+                delete *l;
+        }
+    }
+
     if ( outFile )
     {
         outFile->Write();
@@ -130,6 +171,35 @@ CexmcHistoManager::~CexmcHistoManager()
 }
 
 
+CexmcHistoManager *  CexmcHistoManager::CreateWorker( void ) const
+{
+    return new CexmcHistoManager( *this );
+}
+
+
+void  CexmcHistoManager::MergeWorker( const CexmcHistoManager *  worker )
+{
+    for ( CexmcHistosMap::iterator  k( histos.begin() ); k != histos.end();
+                                                                        ++k )
+    {
+        CexmcHistosMap::const_iterator  found( worker->histos.find(
+                                                                k->first ) );
+        if ( found == worker->histos.end() ||
+             found->second.size() != k->second.size() )
+            throw CexmcException( CexmcWeirdException );
+
+        for ( CexmcHistoVector::size_type  i( 0 ); i < k->second.size(); ++i )
+            k->second[ i ]->Add( found->second[ i ] );
+    }
+}
+
+
+void  CexmcHistoManager::DestroyWorker( CexmcHistoManager *  worker )
+{
+    delete worker;
+}
+
+
 void  CexmcHistoManager::AddHisto( const CexmcHistoData &  data,
                                    const CexmcAngularRange &  aRange )
 {
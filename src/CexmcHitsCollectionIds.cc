@@ -0,0 +1,67 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcHitsCollectionIds.cc
+ *
+ *    Description:  ids of hits collections of sensitive detectors
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 21:09:40
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#include <G4DigiManager.hh>
+#include <G4VHitsCollection.hh>
+#include <G4HCofThisEvent.hh>
+#include "CexmcHitsCollectionIds.hh"
+
+
+CexmcHitsCollectionIds::CexmcHitsCollectionIds()
+{
+    G4DigiManager *  digiManager( G4DigiManager::GetDMpointer() );
+
+    for ( G4int  i( 0 ); i < CexmcNumberOfDetectorRoles; ++i )
+    {
+        for ( G4int  j( 0 ); j < CexmcNumberOfDetectorTypes; ++j )
+        {
+            ids[ i ][ j ] = digiManager->GetHitsCollectionID(
+                    CexmcDetectorRoleName[ i ] + "/" +
+                    CexmcDetectorTypeName[ j ] );
+        }
+    }
+}
+
+
+const G4VHitsCollection *  CexmcHitsCollectionIds::GetCollection(
+                    CexmcDetectorRole  role, CexmcDetectorType  type ) const
+{
+    G4int  hcId( ids[ role ][ type ] );
+
+    if ( hcId < 0 )
+        return NULL;
+
+    return G4DigiManager::GetDMpointer()->GetHitsCollection( hcId );
+}
+
+
+const G4VHitsCollection *  CexmcHitsCollectionIds::GetCollection(
+                    G4HCofThisEvent *  hcOfThisEvent, CexmcDetectorRole  role,
+                    CexmcDetectorType  type ) const
+{
+    if ( ! hcOfThisEvent )
+        return GetCollection( role, type );
+
+    G4int  hcId( ids[ role ][ type ] );
+
+    if ( hcId < 0 )
+        return NULL;
+
+    return hcOfThisEvent->GetHC( hcId );
+}
+
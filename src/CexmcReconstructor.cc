@@ -16,6 +16,7 @@
  * ============================================================================
  */
 
+#include <algorithm>
 #include "CexmcReconstructor.hh"
 #include "CexmcReconstructorMessenger.hh"
 #include "CexmcEnergyDepositStore.hh"
@@ -34,6 +35,7 @@ CexmcReconstructor::CexmcReconstructor() : hasBasicTrigger( false ),
     const CexmcSetup *  setup( static_cast< const CexmcSetup * >(
                                 runManager->GetUserDetectorConstruction() ) );
     calorimeterGeometry = setup->GetCalorimeterGeometry();
+    calorimeterGridTables.Build( calorimeterGeometry );
     targetTransform = setup->GetTargetTransform();
     calorimeterLeftTransform = setup->GetCalorimeterLeftTransform();
     calorimeterRightTransform = setup->GetCalorimeterRightTransform();
@@ -42,6 +44,26 @@ CexmcReconstructor::CexmcReconstructor() : hasBasicTrigger( false ),
 }
 
 
+CexmcReconstructor::CexmcReconstructor(
+                        const CexmcReconstructor &  reconstructor ) :
+    hasBasicTrigger( false ),
+    epDefinitionAlgorithm( reconstructor.epDefinitionAlgorithm ),
+    epDepthDefinitionAlgorithm( reconstructor.epDepthDefinitionAlgorithm ),
+    csAlgorithm( reconstructor.csAlgorithm ),
+    useInnerRefCrystal( reconstructor.useInnerRefCrystal ),
+    epDepth( reconstructor.epDepth ), theAngle( 0 ),
+    calorimeterEDLeftAdjacent( 0 ), calorimeterEDRightAdjacent( 0 ),
+    collectEDInAdjacentCrystals( reconstructor.collectEDInAdjacentCrystals ),
+    calorimeterGeometry( reconstructor.calorimeterGeometry ),
+    calorimeterGridTables( reconstructor.calorimeterGridTables ),
+    calorimeterLeftTransform( reconstructor.calorimeterLeftTransform ),
+    calorimeterRightTransform( reconstructor.calorimeterRightTransform ),
+    targetTransform( reconstructor.targetTransform ),
+    targetEPInitialized( false ), messenger( NULL )
+{
+}
+
+
 CexmcReconstructor::~CexmcReconstructor()
 {
     delete messenger;
@@ -100,26 +122,14 @@ void  CexmcReconstructor::ReconstructEntryPoints(
     case CexmcEntryPointInTheCenter :
         break;
     case CexmcEntryPointInTheCenterOfCrystalWithMaxED :
-        {
-            G4int     nCrystalsInColumn(
-                                    calorimeterGeometry.nCrystalsInColumn );
-            G4int     nCrystalsInRow( calorimeterGeometry.nCrystalsInRow );
-            G4double  crystalWidth( calorimeterGeometry.crystalWidth );
-            G4double  crystalHeight( calorimeterGeometry.crystalHeight );
-
-            calorimeterEPLeftPosition.setX(
-                ( G4double( columnLeft ) - G4double( nCrystalsInRow ) / 2 ) *
-                                        crystalWidth  + crystalWidth / 2 );
-            calorimeterEPLeftPosition.setY(
-                ( G4double( rowLeft ) - G4double( nCrystalsInColumn ) / 2 ) *
-                                        crystalHeight + crystalHeight / 2 );
-            calorimeterEPRightPosition.setX(
-                ( G4double( columnRight ) - G4double( nCrystalsInRow ) / 2 ) *
-                                        crystalWidth  + crystalWidth / 2 );
-            calorimeterEPRightPosition.setY(
-                ( G4double( rowRight ) - G4double( nCrystalsInColumn ) / 2 ) *
-                                        crystalHeight + crystalHeight / 2 );
-        }
+        calorimeterEPLeftPosition.setX(
+                    calorimeterGridTables.GetCrystalCenterX( columnLeft ) );
+        calorimeterEPLeftPosition.setY(
+                    calorimeterGridTables.GetCrystalCenterY( rowLeft ) );
+        calorimeterEPRightPosition.setX(
+                    calorimeterGridTables.GetCrystalCenterX( columnRight ) );
+        calorimeterEPRightPosition.setY(
+                    calorimeterGridTables.GetCrystalCenterY( rowRight ) );
         break;
     case CexmcEntryPointByLinearEDWeights :
     case CexmcEntryPointBySqrtEDWeights :
@@ -256,31 +266,11 @@ void  CexmcReconstructor::CollectEDInAdjacentCrystals(
                         const CexmcEnergyDepositCalorimeterCollection &  edHits,
                         G4int  row, G4int  column, G4double &  ed )
 {
-    G4int  i( 0 );
-
-    for ( CexmcEnergyDepositCalorimeterCollection::const_iterator
-                                k( edHits.begin() ); k != edHits.end(); ++k )
-    {
-        if ( i - row > 1 || i - row < -1 )
-        {
-            ++i;
-            continue;
-        }
-
-        G4int  j( 0 );
-        for ( CexmcEnergyDepositCrystalRowCollection::const_iterator
-                  l( k->begin() ); l != k->end(); ++l )
-        {
-            if ( j - column > 1 || j - column < -1 )
-            {
-                ++j;
-                continue;
-            }
-            ed += *l;
-            ++j;
-        }
-        ++i;
-    }
+    CexmcCalorimeterGridTables::SumEnergyDeposit( edHits,
+                    std::max( row - 1, 0 ),
+                    std::min( row + 2, edHits.GetNmbOfRows() ),
+                    std::max( column - 1, 0 ),
+                    std::min( column + 2, edHits.GetNmbOfColumns() ), ed );
 }
 
 
@@ -289,61 +279,30 @@ void  CexmcReconstructor::CalculateWeightedEPPosition(
                 G4int  row, G4int  column, G4double &  x, G4double &  y,
                 G4double &  ed )
 {
-    G4int     nCrystalsInColumn( calorimeterGeometry.nCrystalsInColumn );
-    G4int     nCrystalsInRow( calorimeterGeometry.nCrystalsInRow );
-    G4double  crystalWidth( calorimeterGeometry.crystalWidth );
-    G4double  crystalHeight( calorimeterGeometry.crystalHeight );
-
-    G4int     i( 0 );
     G4double  xWeightsSum( 0 );
     G4double  yWeightsSum( 0 );
     G4double  energyWeightsSum( 0 );
+    G4int     rowBegin( 0 );
+    G4int     rowEnd( edHits.GetNmbOfRows() );
+    G4int     columnBegin( 0 );
+    G4int     columnEnd( edHits.GetNmbOfColumns() );
 
     if ( csAlgorithm == CexmcSelectAdjacentCrystals )
-        ed = 0.;
-
-    for ( CexmcEnergyDepositCalorimeterCollection::const_iterator
-                                k( edHits.begin() ); k != edHits.end(); ++k )
     {
-        if ( csAlgorithm == CexmcSelectAdjacentCrystals &&
-                                         ( i - row > 1 || i - row < -1 ) )
-        {
-            ++i;
-            continue;
-        }
-
-        G4int  j( 0 );
-        for ( CexmcEnergyDepositCrystalRowCollection::const_iterator
-                  l( k->begin() ); l != k->end(); ++l )
-        {
-            if ( csAlgorithm == CexmcSelectAdjacentCrystals &&
-                                         ( j - column > 1 || j - column < -1 ) )
-            {
-                ++j;
-                continue;
-            }
-
-            if ( csAlgorithm == CexmcSelectAdjacentCrystals )
-                ed += *l;
-            
-            G4double  xInCalorimeterOffset(
-                        ( G4double( j ) - G4double( nCrystalsInRow ) / 2 ) *
-                        crystalWidth  + crystalWidth / 2 );
-            G4double  energyWeight(
-                        epDefinitionAlgorithm ==
-                                        CexmcEntryPointBySqrtEDWeights ?
-                                                        std::sqrt( *l ) : *l );
-            xWeightsSum += energyWeight * xInCalorimeterOffset;
-            G4double  yInCalorimeterOffset(
-                        ( G4double( i ) - G4double( nCrystalsInColumn ) / 2 ) *
-                        crystalHeight  + crystalHeight / 2 );
-            yWeightsSum += energyWeight * yInCalorimeterOffset;
-            energyWeightsSum += energyWeight;
-            ++j;
-        }
-        ++i;
+        ed = 0.;
+        rowBegin = std::max( row - 1, 0 );
+        rowEnd = std::min( row + 2, rowEnd );
+        columnBegin = std::max( column - 1, 0 );
+        columnEnd = std::min( column + 2, columnEnd );
+        CexmcCalorimeterGridTables::SumEnergyDeposit( edHits, rowBegin,
+                                        rowEnd, columnBegin, columnEnd, ed );
     }
 
+    calorimeterGridTables.SumWeightedCrystalCenters( edHits, rowBegin, rowEnd,
+                    columnBegin, columnEnd,
+                    epDefinitionAlgorithm == CexmcEntryPointBySqrtEDWeights,
+                    xWeightsSum, yWeightsSum, energyWeightsSum );
+
     x = xWeightsSum / energyWeightsSum;
     y = yWeightsSum / energyWeightsSum;
 }
@@ -0,0 +1,222 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcReplayWorkers.cc
+ *
+ *    Description:  replay of events data in several threads
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 19:05:14
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+#ifdef CEXMC_USE_THREADS
+
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/thread/thread.hpp>
+#include <G4Event.hh>
+#include "CexmcReplayWorkers.hh"
+#include "CexmcEventAction.hh"
+#include "CexmcEventInfo.hh"
+#include "CexmcRun.hh"
+#include "CexmcHistoManager.hh"
+#include "CexmcException.hh"
+
+
+CexmcReplayWorkers::CexmcReplayWorkers( G4int  nmbOfThreads,
+                                        G4int  nmbOfOutputs,
+                                        const CexmcEventAction *  eventAction,
+                                        const CexmcSetup *  setup ) :
+    events( NULL ), nmbOfEvents( 0 ), blockSize( 16 ), nextEvent( 0 ),
+    exception( NULL )
+{
+    workers.resize( nmbOfThreads );
+
+    for ( std::vector< Worker >::iterator  k( workers.begin() );
+                                                    k != workers.end(); ++k )
+    {
+        k->event = new G4Event;
+        k->hits = new CexmcReplayedEventHits( *k->event, setup );
+        k->eventAction = new CexmcEventAction( *eventAction );
+        for ( G4int  i( 0 ); i < nmbOfOutputs; ++i )
+            k->runs.push_back( new CexmcRun );
+#ifdef CEXMC_USE_ROOT
+        k->histoManager = CexmcHistoManager::Instance()->CreateWorker();
+        k->eventAction->SetHistoManager( k->histoManager );
+#endif
+    }
+}
+
+
+CexmcReplayWorkers::~CexmcReplayWorkers()
+{
+    for ( std::vector< Worker >::iterator  k( workers.begin() );
+                                                    k != workers.end(); ++k )
+    {
+#ifdef CEXMC_USE_ROOT
+        CexmcHistoManager::DestroyWorker( k->histoManager );
+#endif
+        for ( std::vector< CexmcRun * >::iterator  l( k->runs.begin() );
+                                                    l != k->runs.end(); ++l )
+            delete *l;
+        delete k->eventAction;
+        /* hits must be cleared before the event deletes its collections */
+        delete k->hits;
+        delete k->event;
+    }
+
+    delete exception;
+}
+
+
+void  CexmcReplayWorkers::Replay( std::vector< CexmcReplayedEvent > &  events_,
+                                  G4int  nmbOfEvents_ )
+{
+    events = &events_;
+    nmbOfEvents = nmbOfEvents_;
+    nextEvent = 0;
+
+    boost::thread_group  threads;
+
+    for ( G4int  i( 1 ); i < G4int( workers.size() ); ++i )
+        threads.create_thread( boost::bind( &CexmcReplayWorkers::Run, this,
+                                            i ) );
+
+    Run( 0 );
+
+    threads.join_all();
+
+    events = NULL;
+
+    if ( exception )
+    {
+        CexmcException  e( *exception );
+        delete exception;
+        exception = NULL;
+        throw e;
+    }
+}
+
+
+void  CexmcReplayWorkers::Run( G4int  index )
+{
+    Worker &  worker( workers[ index ] );
+
+    try
+    {
+        while ( true )
+        {
+            G4int  first( 0 );
+            G4int  last( 0 );
+
+            {
+                boost::mutex::scoped_lock  lock( mutex );
+
+                if ( exception || nextEvent >= nmbOfEvents )
+                    return;
+
+                first = nextEvent;
+                last = std::min( first + blockSize, nmbOfEvents );
+                nextEvent = last;
+            }
+
+            for ( G4int  i( first ); i < last; ++i )
+                ReplayEvent( worker, ( *events )[ i ] );
+        }
+    }
+    catch ( CexmcException &  e )
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        if ( ! exception )
+            exception = new CexmcException( e );
+    }
+    catch ( ... )
+    {
+        boost::mutex::scoped_lock  lock( mutex );
+
+        if ( ! exception )
+            exception = new CexmcException( CexmcUnknownException );
+    }
+
+    /* the exception could be thrown before hits of the event were cleared */
+    worker.hits->Clear();
+}
+
+
+void  CexmcReplayWorkers::ReplayEvent( Worker &  worker,
+                                       CexmcReplayedEvent &  event )
+{
+    if ( ! event.isReplayed )
+        return;
+
+    G4Event *           theEvent( worker.event );
+    CexmcEventAction *  eventAction( worker.eventAction );
+
+    theEvent->SetEventID( event.evSObject.eventId );
+    worker.hits->Fill( event.evSObject );
+    eventAction->SetReplayedEventData( &event.triggeredAngularRanges,
+                                    &event.evSObject.productionModelData );
+
+    for ( G4int  j( 0 ); j < G4int( event.outputs.size() ); ++j )
+    {
+        CexmcReplayedEventOutput &  output( event.outputs[ j ] );
+
+        if ( ! output.isReplayed )
+            continue;
+
+        eventAction->SetReplayOutput( &output, worker.runs[ j ] );
+        eventAction->SetSecondaryOutput( j > 0 );
+
+        if ( output.skipEDT )
+            theEvent->SetUserInformation( new CexmcEventInfo( false, false,
+                                                              false ) );
+
+        eventAction->EndOfEventAction( theEvent );
+
+        CexmcEventInfo *  eventInfo( static_cast< CexmcEventInfo * >(
+                                            theEvent->GetUserInformation() ) );
+
+        output.edTriggerIsOk = eventInfo && eventInfo->EdTriggerIsOk();
+
+        delete eventInfo;
+        theEvent->SetUserInformation( NULL );
+    }
+
+    eventAction->SetReplayOutput( NULL, NULL );
+    eventAction->SetSecondaryOutput( false );
+    eventAction->SetReplayedEventData( NULL, NULL );
+    worker.hits->Clear();
+}
+
+
+void  CexmcReplayWorkers::MergeRuns( G4int  output, CexmcRun *  run ) const
+{
+    for ( std::vector< Worker >::const_iterator  k( workers.begin() );
+                                                    k != workers.end(); ++k )
+        run->Merge( *k->runs[ output ] );
+}
+
+
+#ifdef CEXMC_USE_ROOT
+
+void  CexmcReplayWorkers::MergeHistos( CexmcHistoManager *  histoManager ) const
+{
+    for ( std::vector< Worker >::const_iterator  k( workers.begin() );
+                                                    k != workers.end(); ++k )
+        histoManager->MergeWorker( k->histoManager );
+}
+
+#endif
+
+#endif
+#endif
+
@@ -0,0 +1,191 @@
+/*
+ * =============================================================================
+ *
+ *       Filename:  CexmcReplayedEvent.cc
+ *
+ *    Description:  replayed event data and hits
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 18:12:37
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * =============================================================================
+ */
+
+#ifdef CEXMC_USE_PERSISTENCY
+
+#include <G4Event.hh>
+#include <G4SDManager.hh>
+#include <G4HCofThisEvent.hh>
+#include "CexmcReplayedEvent.hh"
+#include "CexmcEnergyDepositInLeftRightSet.hh"
+#include "CexmcTrackPointsInLeftRightSet.hh"
+#include "CexmcTrackPointsInCalorimeter.hh"
+#include "CexmcHitsCollectionIds.hh"
+#include "CexmcSetup.hh"
+
+
+CexmcReplayedEventHits::CexmcReplayedEventHits( G4Event &  event,
+                                                const CexmcSetup *  setup ) :
+    setup( setup ), monitorED( NULL ), vetoCounterED( NULL ),
+    monitorTP( NULL ), vetoCounterTP( NULL ), calorimeterTP( NULL ),
+    targetTP( NULL )
+{
+    G4SDManager *      sdManager( G4SDManager::GetSDMpointer() );
+    event.SetHCofThisEvent( sdManager->PrepareNewEvent() );
+    G4HCofThisEvent *  hcOfThisEvent( event.GetHCofThisEvent() );
+
+    CexmcHitsCollectionIds  hcIds;
+
+    G4int  hcId( hcIds.Get( CexmcMonitorDetectorRole, CexmcEDDetector ) );
+    monitorED = new CexmcEnergyDepositCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, monitorED );
+    hcId = hcIds.Get( CexmcVetoCounterDetectorRole, CexmcEDDetector );
+    vetoCounterED = new CexmcEnergyDepositCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, vetoCounterED );
+    hcId = hcIds.Get( CexmcCalorimeterDetectorRole, CexmcEDDetector );
+    hcOfThisEvent->AddHitsCollection( hcId,
+            new CexmcEnergyDepositArrayCollection( "", "",
+                                                   &calorimeterEDArray ) );
+    hcId = hcIds.Get( CexmcMonitorDetectorRole, CexmcTPDetector );
+    monitorTP = new CexmcTrackPointsCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, monitorTP );
+    hcId = hcIds.Get( CexmcVetoCounterDetectorRole, CexmcTPDetector );
+    vetoCounterTP = new CexmcTrackPointsCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, vetoCounterTP );
+    hcId = hcIds.Get( CexmcCalorimeterDetectorRole, CexmcTPDetector );
+    calorimeterTP = new CexmcTrackPointsCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, calorimeterTP );
+    hcId = hcIds.Get( CexmcTargetDetectorRole, CexmcTPDetector );
+    targetTP = new CexmcTrackPointsCollection;
+    hcOfThisEvent->AddHitsCollection( hcId, targetTP );
+}
+
+
+CexmcReplayedEventHits::~CexmcReplayedEventHits()
+{
+    Clear();
+}
+
+
+void  CexmcReplayedEventHits::Fill( CexmcEventSObject &  evSObject )
+{
+    monitorED->GetMap()->operator[]( 0 ) = &evSObject.monitorED;
+    vetoCounterED->GetMap()->operator[]( 0 ) = &evSObject.vetoCounterEDLeft;
+    vetoCounterED->GetMap()->operator[]( 1 <<
+                CexmcEnergyDepositInLeftRightSet::GetLeftRightBitsOffset() ) =
+                                                &evSObject.vetoCounterEDRight;
+    G4int  nmbOfRows( evSObject.calorimeterEDLeftCollection.GetNmbOfRows() );
+    G4int  nmbOfColumns(
+                    evSObject.calorimeterEDLeftCollection.GetNmbOfColumns() );
+    if ( calorimeterEDArray.GetNmbOfRows() != nmbOfRows ||
+         calorimeterEDArray.GetNmbOfColumns() != nmbOfColumns )
+    {
+        calorimeterEDArray.Resize( nmbOfRows, nmbOfColumns );
+    }
+    else
+    {
+        calorimeterEDArray.Reset();
+    }
+    for ( G4int  row( 0 ); row < nmbOfRows; ++row )
+    {
+        for ( G4int  column( 0 ); column < nmbOfColumns; ++column )
+        {
+            calorimeterEDArray.Add( CexmcLeft, row, column,
+                    evSObject.calorimeterEDLeftCollection[ row ][ column ] );
+            calorimeterEDArray.Add( CexmcRight, row, column,
+                    evSObject.calorimeterEDRightCollection[ row ][ column ] );
+        }
+    }
+
+    monitorTPInfo = evSObject.monitorTP;
+    targetTPBeamParticleInfo = evSObject.targetTPBeamParticle;
+    targetTPOutputParticleInfo = evSObject.targetTPOutputParticle;
+    targetTPNucleusParticleInfo = evSObject.targetTPNucleusParticle;
+    targetTPOutputParticleDecayProductParticle1Info =
+                        evSObject.targetTPOutputParticleDecayProductParticle1;
+    targetTPOutputParticleDecayProductParticle2Info =
+                        evSObject.targetTPOutputParticleDecayProductParticle2;
+    vetoCounterTPLeftInfo = evSObject.vetoCounterTPLeft;
+    vetoCounterTPRightInfo = evSObject.vetoCounterTPRight;
+    calorimeterTPLeftInfo = evSObject.calorimeterTPLeft;
+    calorimeterTPRightInfo = evSObject.calorimeterTPRight;
+
+    if ( monitorTPInfo.IsValid() )
+        monitorTP->GetMap()->operator[]( monitorTPInfo.trackId ) =
+                                                &monitorTPInfo;
+    if ( targetTPBeamParticleInfo.IsValid() )
+        targetTP->GetMap()->operator[](
+                targetTPBeamParticleInfo.trackId ) =
+                                                &targetTPBeamParticleInfo;
+    if ( targetTPOutputParticleInfo.IsValid() )
+        targetTP->GetMap()->operator[](
+                targetTPOutputParticleInfo.trackId ) =
+                                                &targetTPOutputParticleInfo;
+    if ( targetTPNucleusParticleInfo.IsValid() )
+        targetTP->GetMap()->operator[](
+                targetTPNucleusParticleInfo.trackId ) =
+                                                &targetTPNucleusParticleInfo;
+    if ( targetTPOutputParticleDecayProductParticle1Info.IsValid() )
+        targetTP->GetMap()->operator[](
+                targetTPOutputParticleDecayProductParticle1Info.trackId ) =
+                            &targetTPOutputParticleDecayProductParticle1Info;
+    if ( targetTPOutputParticleDecayProductParticle2Info.IsValid() )
+        targetTP->GetMap()->operator[](
+                targetTPOutputParticleDecayProductParticle2Info.trackId ) =
+                            &targetTPOutputParticleDecayProductParticle2Info;
+    if ( vetoCounterTPLeftInfo.IsValid() )
+        vetoCounterTP->GetMap()->operator[](
+                vetoCounterTPLeftInfo.trackId ) = &vetoCounterTPLeftInfo;
+    if ( vetoCounterTPRightInfo.IsValid() )
+        vetoCounterTP->GetMap()->operator[](
+                1 << CexmcTrackPointsInLeftRightSet::GetLeftRightBitsOffset() |
+                vetoCounterTPRightInfo.trackId ) = &vetoCounterTPRightInfo;
+
+    G4int          row( 0 );
+    G4int          column( 0 );
+    G4ThreeVector  pos;
+    if ( calorimeterTPLeftInfo.IsValid() )
+    {
+        pos = calorimeterTPLeftInfo.positionLocal;
+        setup->ConvertToCrystalGeometry(
+                calorimeterTPLeftInfo.positionLocal, row, column, pos );
+        calorimeterTPLeftInfo.positionLocal = pos;
+        calorimeterTP->GetMap()->operator[](
+            row << CexmcTrackPointsInCalorimeter::GetCopyDepth1BitsOffset() |
+            column << CexmcTrackPointsInCalorimeter::
+                                                GetCopyDepth0BitsOffset() |
+            calorimeterTPLeftInfo.trackId ) = &calorimeterTPLeftInfo;
+    }
+    if ( calorimeterTPRightInfo.IsValid() )
+    {
+        pos = calorimeterTPRightInfo.positionLocal;
+        setup->ConvertToCrystalGeometry(
+                calorimeterTPRightInfo.positionLocal, row, column, pos );
+        calorimeterTPRightInfo.positionLocal = pos;
+        calorimeterTP->GetMap()->operator[](
+            1 << CexmcTrackPointsInLeftRightSet::GetLeftRightBitsOffset() |
+            row << CexmcTrackPointsInCalorimeter::GetCopyDepth1BitsOffset() |
+            column << CexmcTrackPointsInCalorimeter::
+                                                GetCopyDepth0BitsOffset() |
+            calorimeterTPRightInfo.trackId ) = &calorimeterTPRightInfo;
+    }
+}
+
+
+void  CexmcReplayedEventHits::Clear( void )
+{
+    monitorED->GetMap()->clear();
+    vetoCounterED->GetMap()->clear();
+    monitorTP->GetMap()->clear();
+    targetTP->GetMap()->clear();
+    vetoCounterTP->GetMap()->clear();
+    calorimeterTP->GetMap()->clear();
+}
+
+#endif
+
@@ -106,3 +106,34 @@ void  CexmcRun::IncrementNmbOfSavedFastEvents( void )
     ++nmbOfSavedFastEvents;
 }
 
+
+void  CexmcRun::Merge( const CexmcRun &  run )
+{
+    MergeNmbOfHitsInRanges( nmbOfHitsSampled, run.nmbOfHitsSampled );
+    MergeNmbOfHitsInRanges( nmbOfHitsSampledFull, run.nmbOfHitsSampledFull );
+    MergeNmbOfHitsInRanges( nmbOfHitsTriggeredRealRange,
+                            run.nmbOfHitsTriggeredRealRange );
+    MergeNmbOfHitsInRanges( nmbOfHitsTriggeredRecRange,
+                            run.nmbOfHitsTriggeredRecRange );
+    MergeNmbOfHitsInRanges( nmbOfOrphanHits, run.nmbOfOrphanHits );
+    nmbOfFalseHitsTriggeredEDT += run.nmbOfFalseHitsTriggeredEDT;
+    nmbOfFalseHitsTriggeredRec += run.nmbOfFalseHitsTriggeredRec;
+    nmbOfSavedEvents += run.nmbOfSavedEvents;
+    nmbOfSavedFastEvents += run.nmbOfSavedFastEvents;
+}
+
+
+void  CexmcRun::MergeNmbOfHitsInRanges( CexmcNmbOfHitsInRanges &  dst,
+                                        const CexmcNmbOfHitsInRanges &  src )
+{
+    for ( CexmcNmbOfHitsInRanges::const_iterator  k( src.begin() );
+                                                    k != src.end(); ++k )
+    {
+        CexmcNmbOfHitsInRanges::iterator  found( dst.find( k->first ) );
+        if ( found == dst.end() )
+            dst.insert( *k );
+        else
+            found->second += k->second;
+    }
+}
+
@@ -21,6 +21,7 @@
 #include <string>
 #include <iostream>
 #include <iomanip>
+#include <cmath>
 #include "CexmcRunAction.hh"
 #include "CexmcPhysicsManager.hh"
 #include "CexmcProductionModel.hh"
@@ -202,6 +203,59 @@ void  CexmcRunAction::PrintResults(
 }
 
 
+namespace
+{
+    /* relative binomial error of acceptance triggered / total; it is
+     * sqrt( ( 1 - acc ) / triggered ) and infinite if nothing triggered */
+    G4double  GetAcceptanceRelativeError( G4int  total, G4int  triggered )
+    {
+        if ( total <= 0 || triggered <= 0 )
+            return std::numeric_limits< G4double >::infinity();
+
+        return std::sqrt( ( 1. - G4double( triggered ) / total ) / triggered );
+    }
+
+
+    G4int  GetNmbOfHits( const CexmcNmbOfHitsInRanges &  nmbOfHits,
+                         G4int  index )
+    {
+        CexmcNmbOfHitsInRanges::const_iterator  found(
+                                                    nmbOfHits.find( index ) );
+
+        return found == nmbOfHits.end() ? 0 : found->second;
+    }
+}
+
+
+G4double  CexmcRunAction::GetMaxAcceptanceRelativeError(
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsSampled,
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsTriggeredRealRange,
+                    const CexmcNmbOfHitsInRanges &  nmbOfHitsTriggeredRecRange,
+                    const CexmcAngularRangeList &  angularRanges )
+{
+    G4double  maxError( 0 );
+
+    for ( CexmcAngularRangeList::const_iterator  k( angularRanges.begin() );
+                                                k != angularRanges.end(); ++k )
+    {
+        G4int     total( GetNmbOfHits( nmbOfHitsSampled, k->index ) );
+        G4double  error( GetAcceptanceRelativeError( total,
+                    GetNmbOfHits( nmbOfHitsTriggeredRealRange, k->index ) ) );
+
+        if ( error > maxError )
+            maxError = error;
+
+        error = GetAcceptanceRelativeError( total,
+                    GetNmbOfHits( nmbOfHitsTriggeredRecRange, k->index ) );
+
+        if ( error > maxError )
+            maxError = error;
+    }
+
+    return maxError;
+}
+
+
 void  CexmcRunAction::EndOfRunAction( const G4Run *  run )
 {
     const CexmcRun *  theRun( static_cast< const CexmcRun * >( run ) );
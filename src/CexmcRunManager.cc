@@ -17,9 +17,12 @@
  */
 
 #include <stdlib.h>
+#include <stdio.h>
 #include <sys/stat.h>
 #include <vector>
+#include <algorithm>
 #include <fstream>
+#include <sstream>
 #ifdef CEXMC_USE_PERSISTENCY
 #include <boost/archive/binary_iarchive.hpp>
 #include <boost/archive/binary_oarchive.hpp>
@@ -39,10 +42,12 @@
 #include <G4Scene.hh>
 #include <G4VModel.hh>
 #include <G4Version.hh>
+#include <Randomize.hh>
 #include "CexmcRunManager.hh"
 #include "CexmcRunManagerMessenger.hh"
 #include "CexmcRunAction.hh"
 #include "CexmcRun.hh"
+#include "CexmcHistoManager.hh"
 #include "CexmcPhysicsManager.hh"
 #include "CexmcProductionModel.hh"
 #include "CexmcSimpleDecayTableStore.hh"
@@ -50,7 +55,7 @@
 #include "CexmcEnergyDepositDigitizer.hh"
 #include "CexmcSimpleEnergyDeposit.hh"
 #include "CexmcEnergyDepositInLeftRightSet.hh"
-#include "CexmcEnergyDepositInCalorimeter.hh"
+#include "CexmcEnergyDepositArray.hh"
 #include "CexmcTrackPoints.hh"
 #include "CexmcTrackPointsInLeftRightSet.hh"
 #include "CexmcTrackPointsInCalorimeter.hh"
@@ -62,18 +67,34 @@
 #include "CexmcSetup.hh"
 #include "CexmcEventSObject.hh"
 #include "CexmcEventFastSObject.hh"
+#include "CexmcEventsReader.hh"
+#include "CexmcEventsWriter.hh"
+#include "CexmcEventsIndex.hh"
+#include "CexmcEventsSelection.hh"
+#include "CexmcReplayedEvent.hh"
+#include "CexmcReplayWorkers.hh"
+#include "CexmcColumnarEventsStore.hh"
+#include "CexmcCompressedStreambuf.hh"
+#include "CexmcCheckpointSObject.hh"
 #include "CexmcTrackPointInfo.hh"
 #include "CexmcEventInfo.hh"
 #include "CexmcBasicPhysicsSettings.hh"
 #include "CexmcSensitiveDetectorsAttributes.hh"
 #include "CexmcCustomFilterEval.hh"
 #include "CexmcScenePrimitives.hh"
+#include "CexmcStageProfiler.hh"
 
 
 namespace
 {
     G4String  gdmlFileExtension( ".gdml" );
     G4String  gdmlbz2FileExtension( ".gdml.bz2" );
+#ifdef CEXMC_USE_PERSISTENCY
+#ifdef CEXMC_USE_THREADS
+    /* number of replayed events processed by replay workers at once */
+    const G4int  replayBatchSize( 1024 );
+#endif
+#endif
 }
 
 
@@ -88,12 +109,21 @@ CexmcRunManager::CexmcRunManager( const G4String &  projectId,
     eventCountPolicy( CexmcCountAllEvents ),
     skipInteractionsWithoutEDTonWrite( true ),
     evDataVerboseLevel( CexmcWriteEventDataOnEveryEDT ),
-    rEvDataVerboseLevel( CexmcWriteNoEventData ), numberOfEventsProcessed( 0 ),
+    rEvDataVerboseLevel( CexmcWriteNoEventData ), targetAccError( 0 ),
+    precisionCheckInterval( 1000 ), eventBudget( 0 ), timeBudget( 0 ),
+    numberOfEventsProcessed( 0 ),
     numberOfEventsProcessedEffective( 0 ), curEventRead( 0 ),
 #ifdef CEXMC_USE_PERSISTENCY
-    eventsArchive( NULL ), fastEventsArchive( NULL ),
+    eventDataFormat( CexmcBoostArchiveEventDataFormat ),
+    calorimeterEDFloor( 0 ), eventDataCodec( CexmcNoEventDataCodec ),
+    checkpointInterval( 0 ), resumeFromCheckpoint( false ),
+    eventsWriter( NULL ),
+#ifdef CEXMC_USE_THREADS
+    replayThreads( 0 ),
+#endif
 #ifdef CEXMC_USE_CUSTOM_FILTER
-    customFilter( NULL ),
+    customFilter( NULL ), curReplayOutput( 0 ), rEventsSelection( NULL ),
+    wEventsSelection( NULL ),
 #endif
 #endif
     physicsManager( NULL ), messenger( NULL )
@@ -125,7 +155,16 @@ CexmcRunManager::CexmcRunManager( const G4String &  projectId,
 CexmcRunManager::~CexmcRunManager()
 {
 #ifdef CEXMC_USE_CUSTOM_FILTER
+    SwitchReplayOutput( 0 );
+    for ( CexmcReplayOutputList::iterator  k( replayOutputs.begin() );
+                                            k != replayOutputs.end(); ++k )
+    {
+        delete k->customFilter;
+        delete k->run;
+    }
     delete customFilter;
+    delete rEventsSelection;
+    delete wEventsSelection;
 #endif
     delete messenger;
 }
@@ -298,6 +337,7 @@ void  CexmcRunManager::ReadProject( void )
 
     rEvDataVerboseLevel = sObject.evDataVerboseLevel;
     evDataVerboseLevel = rEvDataVerboseLevel;
+    calorimeterEDFloor = sObject.calorimeterEDFloor;
 }
 
 
@@ -306,6 +346,11 @@ void  CexmcRunManager::SaveProject( void )
     if ( ! ProjectIsSaved() )
         return;
 
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    /* the main project could have been left not current by an exception */
+    SwitchReplayOutput( 0 );
+#endif
+
     /* save run data */
     if ( ! physicsManager )
         throw CexmcException( CexmcWeirdException );
@@ -420,7 +465,8 @@ void  CexmcRunManager::SaveProject( void )
         numberOfEventToBeProcessed, rProject, skipInteractionsWithoutEDTonWrite,
         cfFileName, evDataVerboseLevel, physicsManager->GetProposedMaxIL(),
         reconstructor->GetExpectedMomentumAmp(),
-        reconstructor->GetEDCollectionAlgorithm(), 0 };
+        reconstructor->GetEDCollectionAlgorithm(), eventDataFormat,
+        calorimeterEDFloor, eventDataCodec, 0 };
 
     std::ofstream   runDataFile( ( projectsDir + "/" + projectId + ".rdb" ).
                                         c_str() );
@@ -429,48 +475,128 @@ void  CexmcRunManager::SaveProject( void )
         boost::archive::binary_oarchive  archive( runDataFile );
         archive << sObjectToWrite;
     }
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    /* replay outputs share everything with the main project except run
+     * counters and custom filter */
+    for ( CexmcReplayOutputList::const_iterator  k( replayOutputs.begin() );
+                                            k != replayOutputs.end(); ++k )
+    {
+        CexmcRunSObject  outputSObject( sObjectToWrite );
+
+        outputSObject.nmbOfHitsSampled.clear();
+        outputSObject.nmbOfHitsSampledFull.clear();
+        outputSObject.nmbOfHitsTriggeredRealRange.clear();
+        outputSObject.nmbOfHitsTriggeredRecRange.clear();
+        outputSObject.nmbOfOrphanHits.clear();
+        outputSObject.nmbOfFalseHitsTriggeredEDT = 0;
+        outputSObject.nmbOfFalseHitsTriggeredRec = 0;
+        outputSObject.nmbOfSavedEvents = 0;
+        outputSObject.nmbOfSavedFastEvents = 0;
+
+        if ( k->run )
+        {
+            outputSObject.nmbOfHitsSampled = k->run->GetNmbOfHitsSampled();
+            outputSObject.nmbOfHitsSampledFull =
+                                        k->run->GetNmbOfHitsSampledFull();
+            outputSObject.nmbOfHitsTriggeredRealRange =
+                                    k->run->GetNmbOfHitsTriggeredRealRange();
+            outputSObject.nmbOfHitsTriggeredRecRange =
+                                    k->run->GetNmbOfHitsTriggeredRecRange();
+            outputSObject.nmbOfOrphanHits = k->run->GetNmbOfOrphanHits();
+            outputSObject.nmbOfFalseHitsTriggeredEDT =
+                                    k->run->GetNmbOfFalseHitsTriggeredEDT();
+            outputSObject.nmbOfFalseHitsTriggeredRec =
+                                    k->run->GetNmbOfFalseHitsTriggeredRec();
+            outputSObject.nmbOfSavedEvents = k->run->GetNmbOfSavedEvents();
+            outputSObject.nmbOfSavedFastEvents =
+                                        k->run->GetNmbOfSavedFastEvents();
+        }
+
+        outputSObject.numberOfEventsProcessedEffective =
+                                        k->numberOfEventsProcessedEffective;
+        outputSObject.cfFileName = k->cfFileName;
+
+        std::ofstream  outputRunDataFile( ( projectsDir + "/" + k->projectId +
+                                            ".rdb" ).c_str() );
+
+        boost::archive::binary_oarchive  archive( outputRunDataFile );
+        archive << outputSObject;
+    }
+#endif
+
+    /* the project is complete, its checkpoint is not needed anymore */
+    remove( GetCheckpointFileName().c_str() );
 }
 
 #endif
 
 
+G4bool  CexmcRunManager::EventIsEffective(
+                                const CexmcEventInfo *  eventInfo ) const
+{
+    /* the policy is checked against event info only, so every event loop
+     * counts events in the same way */
+    switch ( eventCountPolicy )
+    {
+    case CexmcCountAllEvents :
+        return true;
+    case CexmcCountEventsWithInteraction :
+        return eventInfo->TpTriggerIsOk();
+    case CexmcCountEventsWithTrigger :
+        return eventInfo->EdTriggerIsOk();
+    default :
+        break;
+    }
+
+    return true;
+}
+
+
 void  CexmcRunManager::DoCommonEventLoop( G4int  nEvent, const G4String &  cmd,
-                                          G4int  nSelect )
+                                          G4int  nSelect, G4int  firstEvent,
+                                          G4int  nmbOfEffectiveEventsBefore )
 {
-    G4int  iEvent( 0 );
-    G4int  iEventEffective( 0 );
+    G4int    iEvent( 0 );
+    G4int    iEventEffective( nmbOfEffectiveEventsBefore );
+    G4Timer  runTimer;
 
-    for ( iEvent = 0; iEventEffective < nEvent; ++iEvent )
+    runTimer.Start();
+
+    for ( iEvent = firstEvent; iEventEffective < nEvent; ++iEvent )
     {
+        CEXMC_PROFILER_START( CexmcEventStage );
+        CEXMC_PROFILER_START( CexmcPrimaryGenerationStage );
         currentEvent = GenerateEvent( iEvent );
+        CEXMC_PROFILER_STOP( CexmcPrimaryGenerationStage );
+        /* transport stage is stopped in the beginning of
+         * CexmcEventAction::EndOfEventAction() */
+        CEXMC_PROFILER_START( CexmcTransportStage );
         eventManager->ProcessOneEvent( currentEvent );
+        CEXMC_PROFILER_STOP( CexmcTransportStage );
         CexmcEventInfo *  eventInfo( static_cast< CexmcEventInfo * >(
                                         currentEvent->GetUserInformation() ) );
-        switch ( eventCountPolicy )
-        {
-        case CexmcCountAllEvents :
-            ++iEventEffective;
-            break;
-        case CexmcCountEventsWithInteraction :
-            if ( eventInfo->TpTriggerIsOk() )
-                ++iEventEffective;
-            break;
-        case CexmcCountEventsWithTrigger :
-            if ( eventInfo->EdTriggerIsOk() )
-                ++iEventEffective;
-            break;
-        default :
+        if ( EventIsEffective( eventInfo ) )
             ++iEventEffective;
-            break;
-        }
         AnalyzeEvent( currentEvent );
         UpdateScoring();
         if ( iEvent < nSelect )
             G4UImanager::GetUIpointer()->ApplyCommand( cmd );
         StackPreviousEvent( currentEvent );
         currentEvent = 0;
+        CEXMC_PROFILER_STOP( CexmcEventStage );
         if ( runAborted )
             break;
+#ifdef CEXMC_USE_PERSISTENCY
+        if ( eventsWriter && checkpointInterval > 0 &&
+             ( iEvent + 1 ) % checkpointInterval == 0 )
+            SaveCheckpoint( iEvent + 1, iEventEffective );
+#endif
+        if ( RunShouldBeStopped( iEvent + 1, runTimer ) )
+        {
+            ++iEvent;
+            break;
+        }
     }
 
     numberOfEventsProcessed = iEvent;
@@ -478,6 +604,59 @@ void  CexmcRunManager::DoCommonEventLoop( G4int  nEvent, const G4String &  cmd,
 }
 
 
+G4bool  CexmcRunManager::RunShouldBeStopped( G4int  nmbOfEvents,
+                                             G4Timer &  runTimer )
+{
+    /* number of events from beamOn (counted according to eventCountPolicy)
+     * remains the upper limit, budgets and target acceptance error may only
+     * stop the run earlier */
+    if ( eventBudget > 0 && nmbOfEvents >= eventBudget )
+    {
+        G4cout << CEXMC_LINE_START << "Run is stopped: event budget (" <<
+                  eventBudget << ") is exhausted" << G4endl;
+        return true;
+    }
+
+    if ( timeBudget > 0 )
+    {
+        runTimer.Stop();
+        if ( runTimer.GetRealElapsed() * s >= timeBudget )
+        {
+            G4cout << CEXMC_LINE_START << "Run is stopped: time budget (" <<
+                      timeBudget / s << " s) is exhausted after " <<
+                      nmbOfEvents << " events" << G4endl;
+            return true;
+        }
+    }
+
+    if ( targetAccError <= 0 || precisionCheckInterval <= 0 ||
+         nmbOfEvents % precisionCheckInterval != 0 )
+        return false;
+
+    const CexmcRun *  run( static_cast< const CexmcRun * >( currentRun ) );
+    CexmcProductionModel *  productionModel(
+                                        physicsManager->GetProductionModel() );
+
+    if ( ! run || ! productionModel )
+        return false;
+
+    G4double  maxError( CexmcRunAction::GetMaxAcceptanceRelativeError(
+                                run->GetNmbOfHitsSampled(),
+                                run->GetNmbOfHitsTriggeredRealRange(),
+                                run->GetNmbOfHitsTriggeredRecRange(),
+                                productionModel->GetAngularRanges() ) );
+
+    if ( maxError > targetAccError )
+        return false;
+
+    G4cout << CEXMC_LINE_START << "Run is stopped: acceptances errors are "
+              "within " << targetAccError << " (max " << maxError <<
+              ") after " << nmbOfEvents << " events" << G4endl;
+
+    return true;
+}
+
+
 #ifdef CEXMC_USE_PERSISTENCY
 
 void  CexmcRunManager::DoReadEventLoop( G4int  nEvent )
@@ -504,334 +683,433 @@ void  CexmcRunManager::DoReadEventLoop( G4int  nEvent )
     CexmcEventSObject      evSObject;
     CexmcEventFastSObject  evFastSObject;
 
-    /* read events data */
-    std::ifstream   eventsDataFile(
-                        ( projectsDir + "/" + rProject + ".edb" ).c_str() );
-    if ( ! eventsDataFile )
-        throw CexmcException( CexmcReadProjectIncomplete );
+    G4int   nmbOfSavedEvents( rEvDataVerboseLevel == CexmcWriteNoEventData ? 0 :
+                             sObject.nmbOfSavedFastEvents );
+    G4bool  eventDataWrittenOnEveryTPT( rEvDataVerboseLevel ==
+                                        CexmcWriteEventDataOnEveryTPT );
 
-    boost::archive::binary_iarchive  evArchive( eventsDataFile );
+    /* find where to start reading from in the events index */
+    G4int                   firstRecord( 0 );
+    CexmcEventsIndexRecord  firstRecordData = { 0, 0, 0, 0 };
+    CexmcEventsIndex        rEventsIndex( projectsDir + "/" + rProject + ".idx",
+                                          false );
+    G4bool                  rEventsIndexIsValid( rEventsIndex.IsOpen() &&
+                        rEventsIndex.GetNmbOfRecords() == nmbOfSavedEvents );
 
-    std::ifstream   eventsFastDataFile(
-                        ( projectsDir + "/" + rProject + ".fdb" ).c_str() );
-    if ( ! eventsFastDataFile )
-        throw CexmcException( CexmcReadProjectIncomplete );
+    if ( curEventRead > 0 && rEventsIndexIsValid )
+    {
+        firstRecord = rEventsIndex.FindFirstRecordAfterEDT( curEventRead );
+        if ( firstRecord < nmbOfSavedEvents )
+        {
+            firstRecordData = rEventsIndex.Read( firstRecord );
+            nEventCount = firstRecordData.nmbOfEDTBefore;
+        }
+        else
+        {
+            nEventCount = rEventsIndex.GetNmbOfEDT();
+        }
+    }
 
-    boost::archive::binary_iarchive  evFastArchive( eventsFastDataFile );
+    /* TPT expressions of the custom filter which do not need events data
+     * are evaluated by the reader, so that events data of the events they
+     * reject are not decoded; the events index is used by the reader from
+     * now on. Events data are shared by all replay outputs, so they are
+     * decoded regardless of the filters if there are replay outputs. The
+     * events selection is applied to all outputs, so events data of records
+     * it rejects are never decoded. When the custom filter is profiled,
+     * all its expressions are evaluated here to be counted only once */
+    const CexmcCustomFilterEval *  fastFilter( NULL );
+    const CexmcEventsSelection *   selection( NULL );
+    G4int                          nmbOfOutputs( 1 );
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    G4bool                         filterIsProfiled( false );
+#ifdef CEXMC_USE_PROFILER
+    filterIsProfiled = CexmcStageProfiler::Instance()->IsEnabled();
+#endif
+    nmbOfOutputs += G4int( replayOutputs.size() );
+    if ( nmbOfOutputs == 1 && ! filterIsProfiled )
+        fastFilter = customFilter;
+    else if ( customFilter && customFilter->HasFastTPT() )
+        G4cout << CEXMC_LINE_START << "All expressions of custom filters are "
+                  "evaluated after decoding events data because there are "
+                  "several replay outputs or the filter is profiled" << G4endl;
+    selection = rEventsSelection;
+
+    if ( ! wEventsSelectionName.empty() && ! wEventsSelection )
+        wEventsSelection = new CexmcEventsSelection(
+                                            sObject.nmbOfSavedFastEvents );
+#endif
 
-    G4Event  event;
+    /* read events data */
+    G4String  eventsDataFileExtension(
+                    sObject.eventDataFormat == CexmcColumnarEventDataFormat ?
+                    ".cdb" : ".edb" );
+    CexmcEventsReader  eventsReader(
+                        projectsDir + "/" + rProject + eventsDataFileExtension,
+                        projectsDir + "/" + rProject + ".fdb",
+                        nmbOfSavedEvents - firstRecord,
+                        eventDataWrittenOnEveryTPT, sObject.eventDataFormat,
+                        sObject.eventDataCodec,
+                        firstRecord > 0 && firstRecord < nmbOfSavedEvents ?
+                                                &firstRecordData : NULL,
+                        fastFilter,
+                        rEventsIndexIsValid ? &rEventsIndex : NULL,
+                        firstRecord, selection );
+
+    G4Event                 event;
     currentEvent = &event;
-    G4SDManager *      sdManager( G4SDManager::GetSDMpointer() );
-    event.SetHCofThisEvent( sdManager->PrepareNewEvent() );
-    G4HCofThisEvent *  hcOfThisEvent( event.GetHCofThisEvent() );
-
-    G4DigiManager *  digiManager( G4DigiManager::GetDMpointer() );
-
-    G4int  hcId( digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcMonitorDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcEDDetector ] ) );
-    CexmcEnergyDepositCollection *  monitorED(
-                                            new CexmcEnergyDepositCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, monitorED );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcVetoCounterDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcEDDetector ] );
-    CexmcEnergyDepositCollection *  vetoCounterED(
-                                            new CexmcEnergyDepositCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, vetoCounterED );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcCalorimeterDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcEDDetector ] );
-    CexmcEnergyDepositCollection *  calorimeterED(
-                                            new CexmcEnergyDepositCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, calorimeterED );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcMonitorDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
-    CexmcTrackPointsCollection *  monitorTP( new CexmcTrackPointsCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, monitorTP );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcVetoCounterDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
-    CexmcTrackPointsCollection *  vetoCounterTP(
-                                            new CexmcTrackPointsCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, vetoCounterTP );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcCalorimeterDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
-    CexmcTrackPointsCollection *  calorimeterTP(
-                                            new CexmcTrackPointsCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, calorimeterTP );
-    hcId = digiManager->GetHitsCollectionID(
-                        CexmcDetectorRoleName[ CexmcTargetDetectorRole ] +
-                        "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
-    CexmcTrackPointsCollection *  targetTP( new CexmcTrackPointsCollection );
-    hcOfThisEvent->AddHitsCollection( hcId, targetTP );
+    CexmcReplayedEventHits  hits( event, setup );
 
 #ifdef CEXMC_USE_CUSTOM_FILTER
-    if ( customFilter )
+    for ( G4int  j( 0 ); j < nmbOfOutputs; ++j )
+    {
+        SwitchReplayOutput( j );
+        if ( ! customFilter )
+            continue;
         customFilter->SetAddressedData( &evFastSObject, &evSObject );
+#ifdef CEXMC_USE_PROFILER
+        customFilter->EnableProfiling( filterIsProfiled );
+        customFilter->ResetProfile();
+#endif
+    }
+    SwitchReplayOutput( 0 );
 #endif
 
-    G4int   nmbOfSavedEvents( rEvDataVerboseLevel == CexmcWriteNoEventData ? 0 :
-                             sObject.nmbOfSavedFastEvents );
-    G4bool  eventDataWrittenOnEveryTPT( rEvDataVerboseLevel ==
-                                        CexmcWriteEventDataOnEveryTPT );
+    const CexmcEventAction *  eventAction(
+                static_cast< const CexmcEventAction * >( userEventAction ) );
+    if ( ! eventAction )
+        throw CexmcException( CexmcEventActionIsNotInitialized );
 
-    for ( int  i( 0 ); i < nmbOfSavedEvents; ++i )
+    CexmcEventAction *  theEventAction( const_cast< CexmcEventAction * >(
+                                                                eventAction ) );
+
+    /* events are replayed in batches: what every output does with an event
+     * is decided in the order of records, then events of the batch are
+     * replayed, and then their results are written in the order of records.
+     * Without replay workers a batch contains one event which is replayed by
+     * the event action in this thread */
+    G4int   batchSize( 1 );
+    G4bool  replayInThreads( false );
+#ifdef CEXMC_USE_THREADS
+    if ( replayThreads > 1 )
     {
-        evFastArchive >> evFastSObject;
+        G4bool  replayIsProfiled( false );
+#ifdef CEXMC_USE_PROFILER
+        replayIsProfiled = CexmcStageProfiler::Instance()->IsEnabled();
+#endif
+        replayInThreads = ! replayIsProfiled &&
+                          ! eventAction->EventsArePrintedOrDrawn();
+        if ( replayInThreads )
+            batchSize = replayBatchSize;
+        else
+            G4cout << CEXMC_LINE_START << "Events are replayed in the main "
+                      "thread because they are printed, drawn or "
+                      "profiled" << G4endl;
+    }
+
+    CexmcReplayWorkers  replayWorkers( replayInThreads ? replayThreads : 0,
+                                       nmbOfOutputs, eventAction, setup );
+#endif
+
+    std::vector< CexmcReplayedEvent >  replayedEvents( batchSize );
+
+    for ( std::vector< CexmcReplayedEvent >::iterator
+            k( replayedEvents.begin() ); k != replayedEvents.end(); ++k )
+        k->outputs.resize( nmbOfOutputs );
 
-        if ( nEventCount < curEventRead )
+    G4int  i( firstRecord );
+
+    while ( i < nmbOfSavedEvents )
+    {
+        G4int  nmbOfEventsInBatch( 0 );
+        G4int  nmbOfMainOutputEventsInBatch( 0 );
+
+        while ( i < nmbOfSavedEvents && nmbOfEventsInBatch < batchSize )
         {
-            if ( eventDataWrittenOnEveryTPT ||
-                 evFastSObject.edDigitizerHasTriggered )
+            G4int  record( i++ );
+
+            CEXMC_PROFILER_START( CexmcEventStage );
+            CEXMC_PROFILER_START( CexmcReadEventStage );
+            eventsReader.Next( evFastSObject, evSObject );
+            CEXMC_PROFILER_STOP( CexmcReadEventStage );
+
+            if ( nEventCount < curEventRead )
             {
-                evArchive >> evSObject;
                 if ( evFastSObject.edDigitizerHasTriggered )
                     ++nEventCount;
+                continue;
             }
-            continue;
-        }
 
-        ++iEvent;
+            ++iEvent;
 
-        productionModel->SetTriggeredAngularRanges(
+            productionModel->SetTriggeredAngularRanges(
                                                 evFastSObject.opCosThetaSCM );
-        const CexmcAngularRangeList &  triggeredAngularRanges(
+            const CexmcAngularRangeList &  triggeredAngularRanges(
                                 productionModel->GetTriggeredAngularRanges() );
 
-        if ( ! eventDataWrittenOnEveryTPT &&
-             ! evFastSObject.edDigitizerHasTriggered )
-        {
+            CexmcReplayedEvent &  replayedEvent(
+                                        replayedEvents[ nmbOfEventsInBatch ] );
+            G4bool                eventMustBeWritten( false );
+
+            replayedEvent.isReplayed = false;
+
+            for ( G4int  j( 0 ); j < nmbOfOutputs; ++j )
+            {
 #ifdef CEXMC_USE_CUSTOM_FILTER
-            /* user must be aware that using tpt commands in custom filter
-             * scripts for poor event data sets can easily lead to logical
-             * errors! This is because most of tpt data is only available for
-             * events with EDT trigger. There is no such problem if event data
-             * was written on every TPT event. */
-            if ( customFilter && ! customFilter->EvalTPT() )
-                continue;
+                SwitchReplayOutput( j );
+                if ( customFilter )
+                    customFilter->InvalidateCache();
 #endif
-            SaveCurrentTPTEvent( evFastSObject, triggeredAngularRanges,
-                     ProjectIsSaved() && ! skipInteractionsWithoutEDTonWrite );
-            continue;
-        }
+                CexmcReplayedEventOutput &  output(
+                                                replayedEvent.outputs[ j ] );
+                output.isReplayed = EventMustBeReplayed( evFastSObject,
+                                    triggeredAngularRanges,
+                                    eventDataWrittenOnEveryTPT,
+                                    eventsReader.LastRecordIsFiltered(),
+                                    record, output.skipEDT,
+                                    output.tptEventMustBeWritten );
+                output.edTriggerIsOk = false;
+                output.fastEventIsSaved = false;
+                output.eventIsSaved = false;
+                output.error = "";
+                replayedEvent.isReplayed = replayedEvent.isReplayed ||
+                                           output.isReplayed;
+                eventMustBeWritten = eventMustBeWritten ||
+                                     output.tptEventMustBeWritten;
+            }
 
-        evArchive >> evSObject;
+#ifdef CEXMC_USE_CUSTOM_FILTER
+            SwitchReplayOutput( 0 );
+#endif
 
-        G4bool  skipEDTOnThisEvent( false );
+            if ( ! replayedEvent.isReplayed && ! eventMustBeWritten )
+                continue;
 
-#ifdef CEXMC_USE_CUSTOM_FILTER
-        if ( customFilter && ! customFilter->EvalTPT() )
-            continue;
-        if ( customFilter && ! customFilter->EvalEDT() )
-        {
-            if ( ! eventDataWrittenOnEveryTPT )
-            {
-                SaveCurrentTPTEvent( evFastSObject, triggeredAngularRanges,
-                                     ProjectIsSaved() );
+            replayedEvent.evFastSObject = evFastSObject;
+            ++nmbOfEventsInBatch;
+
+            if ( ! replayedEvent.isReplayed )
                 continue;
-            }
-            skipEDTOnThisEvent = true;
+
+            replayedEvent.evSObject.Swap( evSObject );
+            replayedEvent.triggeredAngularRanges = triggeredAngularRanges;
+
+            /* every event replayed by the main project may be the last
+             * effective event, no records after it must be read */
+            if ( replayedEvent.outputs[ 0 ].isReplayed && nEvent > 0 &&
+                 ++nmbOfMainOutputEventsInBatch == nEvent - iEventEffective )
+                break;
         }
+
+#ifdef CEXMC_USE_THREADS
+        if ( replayInThreads )
+            replayWorkers.Replay( replayedEvents, nmbOfEventsInBatch );
 #endif
 
-        event.SetEventID( evSObject.eventId );
-
-        /* AAA: beware! If something throws an exception between AAA and CCC
-         * then there would be segmentation violation in ~THitsMap() as it
-         * would try to delete local variable evSObject's fields.
-         * See also BBB */
-
-        monitorED->GetMap()->operator[]( 0 ) = &evSObject.monitorED;
-        vetoCounterED->GetMap()->operator[]( 0 ) = &evSObject.vetoCounterEDLeft;
-        vetoCounterED->GetMap()->operator[]( 1 <<
-                CexmcEnergyDepositInLeftRightSet::GetLeftRightBitsOffset() ) =
-                                                &evSObject.vetoCounterEDRight;
-        G4int  row( 0 );
-        G4int  column( 0 );
-        for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                k( evSObject.calorimeterEDLeftCollection.begin() );
-                    k != evSObject.calorimeterEDLeftCollection.end(); ++k )
+        for ( G4int  k( 0 ); k < nmbOfEventsInBatch; ++k )
         {
-            G4int  index( row <<
-                CexmcEnergyDepositInCalorimeter::GetCopyDepth1BitsOffset() );
-            column = 0;
-            for ( CexmcEnergyDepositCrystalRowCollection::iterator
-                    l( k->begin() ); l != k->end(); ++l )
+            CexmcReplayedEvent &  replayedEvent( replayedEvents[ k ] );
+
+            if ( replayedEvent.isReplayed && ! replayInThreads )
             {
-                calorimeterED->GetMap()->operator[]( index | column ) = &*l;
-                ++column;
+                event.SetEventID( replayedEvent.evSObject.eventId );
+                hits.Fill( replayedEvent.evSObject );
+                productionModel->SetProductionModelData(
+                                replayedEvent.evSObject.productionModelData );
+                theEventAction->SetReplayedEventData(
+                                &replayedEvent.triggeredAngularRanges,
+                                &replayedEvent.evSObject.productionModelData );
             }
-            ++row;
-        }
-        row = 0;
-        for ( CexmcEnergyDepositCalorimeterCollection::iterator
-                k( evSObject.calorimeterEDRightCollection.begin() );
-                    k != evSObject.calorimeterEDRightCollection.end(); ++k )
-        {
-            G4int  index(
-                1 << CexmcEnergyDepositInLeftRightSet::GetLeftRightBitsOffset()
-                | row <<
-                CexmcEnergyDepositInCalorimeter::GetCopyDepth1BitsOffset() );
-            column = 0;
-            for ( CexmcEnergyDepositCrystalRowCollection::iterator
-                    l( k->begin() ); l != k->end(); ++l )
+
+            for ( G4int  j( 0 ); j < nmbOfOutputs; ++j )
             {
-                calorimeterED->GetMap()->operator[]( index | column ) = &*l;
-                ++column;
-            }
-            ++row;
-        }
+                CexmcReplayedEventOutput &  output(
+                                                replayedEvent.outputs[ j ] );
 
-        CexmcTrackPointInfo  monitorTPInfo( evSObject.monitorTP );
-        CexmcTrackPointInfo  targetTPBeamParticleInfo(
-                                        evSObject.targetTPBeamParticle );
-        CexmcTrackPointInfo  targetTPOutputParticleInfo(
-                                        evSObject.targetTPOutputParticle );
-        CexmcTrackPointInfo  targetTPNucleusParticleInfo(
-                                        evSObject.targetTPNucleusParticle );
-        CexmcTrackPointInfo  targetTPOutputParticleDecayProductParticle1Info(
-                        evSObject.targetTPOutputParticleDecayProductParticle1 );
-        CexmcTrackPointInfo  targetTPOutputParticleDecayProductParticle2Info(
-                        evSObject.targetTPOutputParticleDecayProductParticle2 );
-        CexmcTrackPointInfo  vetoCounterTPLeftInfo(
-                                                evSObject.vetoCounterTPLeft );
-        CexmcTrackPointInfo  vetoCounterTPRightInfo(
-                                                evSObject.vetoCounterTPRight );
-        CexmcTrackPointInfo  calorimeterTPLeftInfo(
-                                                evSObject.calorimeterTPLeft );
-        CexmcTrackPointInfo  calorimeterTPRightInfo(
-                                                evSObject.calorimeterTPRight );
-
-        if ( monitorTPInfo.IsValid() )
-            monitorTP->GetMap()->operator[]( monitorTPInfo.trackId ) =
-                                                &monitorTPInfo;
-        if ( targetTPBeamParticleInfo.IsValid() )
-            targetTP->GetMap()->operator[](
-                    targetTPBeamParticleInfo.trackId ) =
-                                                &targetTPBeamParticleInfo;
-        if ( targetTPOutputParticleInfo.IsValid() )
-            targetTP->GetMap()->operator[](
-                    targetTPOutputParticleInfo.trackId ) =
-                                                &targetTPOutputParticleInfo;
-        if ( targetTPNucleusParticleInfo.IsValid() )
-            targetTP->GetMap()->operator[](
-                    targetTPNucleusParticleInfo.trackId ) =
-                                                &targetTPNucleusParticleInfo;
-        if ( targetTPOutputParticleDecayProductParticle1Info.IsValid() )
-            targetTP->GetMap()->operator[](
-                    targetTPOutputParticleDecayProductParticle1Info.trackId ) =
-                            &targetTPOutputParticleDecayProductParticle1Info;
-        if ( targetTPOutputParticleDecayProductParticle2Info.IsValid() )
-            targetTP->GetMap()->operator[](
-                    targetTPOutputParticleDecayProductParticle2Info.trackId ) =
-                            &targetTPOutputParticleDecayProductParticle2Info;
-        if ( vetoCounterTPLeftInfo.IsValid() )
-            vetoCounterTP->GetMap()->operator[](
-                    vetoCounterTPLeftInfo.trackId ) = &vetoCounterTPLeftInfo;
-        if ( vetoCounterTPRightInfo.IsValid() )
-            vetoCounterTP->GetMap()->operator[](
-                1 << CexmcTrackPointsInLeftRightSet::GetLeftRightBitsOffset() |
-                    vetoCounterTPRightInfo.trackId ) = &vetoCounterTPRightInfo;
-
-        G4ThreeVector  pos;
-        if ( calorimeterTPLeftInfo.IsValid() )
-        {
-            pos = calorimeterTPLeftInfo.positionLocal;
-            setup->ConvertToCrystalGeometry(
-                    calorimeterTPLeftInfo.positionLocal, row, column, pos );
-            calorimeterTPLeftInfo.positionLocal = pos;
-            calorimeterTP->GetMap()->operator[](
-                row << CexmcTrackPointsInCalorimeter::
-                                                GetCopyDepth1BitsOffset() |
-                column << CexmcTrackPointsInCalorimeter::
-                                                GetCopyDepth0BitsOffset() |
-                calorimeterTPLeftInfo.trackId ) = &calorimeterTPLeftInfo;
-        }
-        if ( calorimeterTPRightInfo.IsValid() )
-        {
-            pos = calorimeterTPRightInfo.positionLocal;
-            setup->ConvertToCrystalGeometry(
-                    calorimeterTPRightInfo.positionLocal, row, column, pos );
-            calorimeterTPRightInfo.positionLocal = pos;
-            calorimeterTP->GetMap()->operator[](
-                1 << CexmcTrackPointsInLeftRightSet::GetLeftRightBitsOffset() |
-                row << CexmcTrackPointsInCalorimeter::
-                                                GetCopyDepth1BitsOffset() |
-                column << CexmcTrackPointsInCalorimeter::
-                                                GetCopyDepth0BitsOffset() |
-                calorimeterTPRightInfo.trackId ) = &calorimeterTPRightInfo;
-        }
+#ifdef CEXMC_USE_CUSTOM_FILTER
+                SwitchReplayOutput( j );
+#endif
+                if ( output.tptEventMustBeWritten )
+                    WriteTPTEvent( replayedEvent.evFastSObject );
 
-        productionModel->SetProductionModelData(
-                                            evSObject.productionModelData );
+                if ( ! output.isReplayed )
+                    continue;
 
-        const CexmcEventAction *  eventAction(
-                static_cast< const CexmcEventAction * >( userEventAction ) );
-        if ( ! eventAction )
-        {
-            /* BBB: all hits collections must be cleared before throwing
-             * anything from here, otherwise ~THitsMap() will try to delete
-             * local variable evSObject's fields like monitorED etc. */
-            monitorED->GetMap()->clear();
-            vetoCounterED->GetMap()->clear();
-            calorimeterED->GetMap()->clear();
-            monitorTP->GetMap()->clear();
-            targetTP->GetMap()->clear();
-            vetoCounterTP->GetMap()->clear();
-            calorimeterTP->GetMap()->clear();
-            throw CexmcException( CexmcEventActionIsNotInitialized );
-        }
+                if ( replayInThreads )
+                {
+                    WriteReplayedEvent( output );
+                }
+                else
+                {
+                    theEventAction->SetSecondaryOutput( j > 0 );
 
-        if ( skipEDTOnThisEvent )
-            event.SetUserInformation( new CexmcEventInfo( false, false,
-                                                          false ) );
+                    if ( output.skipEDT )
+                        event.SetUserInformation( new CexmcEventInfo( false,
+                                                            false, false ) );
 
-        CexmcEventAction *  theEventAction( const_cast< CexmcEventAction * >(
-                                                                eventAction ) );
-        theEventAction->EndOfEventAction( &event );
+                    theEventAction->EndOfEventAction( &event );
 
-        CexmcEventInfo *  eventInfo( static_cast< CexmcEventInfo * >(
+                    CexmcEventInfo *  eventInfo(
+                                static_cast< CexmcEventInfo * >(
                                                 event.GetUserInformation() ) );
 
-        if ( eventInfo->EdTriggerIsOk() )
-            ++iEventEffective;
+                    output.edTriggerIsOk = eventInfo->EdTriggerIsOk();
 
-        delete eventInfo;
-        event.SetUserInformation( NULL );
+                    delete eventInfo;
+                    event.SetUserInformation( NULL );
+                }
 
-        monitorED->GetMap()->clear();
-        vetoCounterED->GetMap()->clear();
-        calorimeterED->GetMap()->clear();
-        monitorTP->GetMap()->clear();
-        targetTP->GetMap()->clear();
-        vetoCounterTP->GetMap()->clear();
-        calorimeterTP->GetMap()->clear();
+                if ( output.edTriggerIsOk )
+                {
+#ifdef CEXMC_USE_CUSTOM_FILTER
+                    if ( j > 0 )
+                        ++replayOutputs[ j - 1 ].
+                                            numberOfEventsProcessedEffective;
+                    else
+#endif
+                        ++iEventEffective;
+                }
+            }
 
-        /* CCC: see AAA */
+#ifdef CEXMC_USE_CUSTOM_FILTER
+            SwitchReplayOutput( 0 );
+#endif
+
+            if ( replayedEvent.isReplayed )
+            {
+                if ( ! replayInThreads )
+                {
+                    theEventAction->SetSecondaryOutput( false );
+                    theEventAction->SetReplayedEventData( NULL, NULL );
+                    hits.Clear();
+                }
+                CEXMC_PROFILER_STOP( CexmcEventStage );
+            }
+        }
 
         if ( nEvent > 0 && iEventEffective == nEvent )
             break;
     }
 
+#ifdef CEXMC_USE_THREADS
+    if ( replayInThreads )
+    {
+        for ( G4int  j( 0 ); j < nmbOfOutputs; ++j )
+        {
+#ifdef CEXMC_USE_CUSTOM_FILTER
+            SwitchReplayOutput( j );
+#endif
+            replayWorkers.MergeRuns( j,
+                                    static_cast< CexmcRun * >( currentRun ) );
+        }
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        SwitchReplayOutput( 0 );
+#endif
+#ifdef CEXMC_USE_ROOT
+        replayWorkers.MergeHistos( CexmcHistoManager::Instance() );
+#endif
+    }
+#endif
+
     curEventRead = nEventCount + iEventEffective;
 
     numberOfEventsProcessed = iEvent;
     numberOfEventsProcessedEffective = iEventEffective;
 
 #ifdef CEXMC_USE_CUSTOM_FILTER
-    if ( customFilter )
-        customFilter->SetAddressedData( NULL, NULL );
+    for ( G4int  j( 0 ); j < nmbOfOutputs; ++j )
+    {
+        SwitchReplayOutput( j );
+        if ( customFilter )
+        {
+            customFilter->SetAddressedData( NULL, NULL );
+#ifdef CEXMC_USE_PROFILER
+            customFilter->PrintProfile();
+#endif
+        }
+        if ( j > 0 )
+            G4cout << CEXMC_LINE_START << "Project '" <<
+                      replayOutputs[ j - 1 ].projectId << "': " <<
+                      replayOutputs[ j - 1 ].numberOfEventsProcessedEffective <<
+                      " events processed effectively" << G4endl;
+    }
+    SwitchReplayOutput( 0 );
+
+    if ( wEventsSelection )
+    {
+        wEventsSelection->Write( GetEventsSelectionFileName(
+                                                    wEventsSelectionName ) );
+        G4cout << CEXMC_LINE_START << "Events selection '" <<
+                  wEventsSelectionName << "' saved: " <<
+                  wEventsSelection->GetNmbOfSelectedByEDT() << " of " <<
+                  wEventsSelection->GetNmbOfRecords() <<
+                  " records selected" << G4endl;
+    }
 #endif
 }
 
 
-void  CexmcRunManager::SaveCurrentTPTEvent(
+G4bool  CexmcRunManager::EventMustBeReplayed(
                                 const CexmcEventFastSObject &  evFastSObject,
                                 const CexmcAngularRangeList &  angularRanges,
-                                G4bool  writeToDatabase )
+                                G4bool  eventDataWrittenOnEveryTPT,
+                                G4bool  eventIsFiltered, G4int  record,
+                                G4bool &  skipEDTOnThisEvent,
+                                G4bool &  tptEventMustBeWritten )
+{
+    skipEDTOnThisEvent = false;
+    tptEventMustBeWritten = false;
+
+    if ( ! eventDataWrittenOnEveryTPT &&
+         ! evFastSObject.edDigitizerHasTriggered )
+    {
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        /* user must be aware that using tpt commands in custom filter
+         * scripts for poor event data sets can easily lead to logical
+         * errors! This is because most of tpt data is only available for
+         * events with EDT trigger. There is no such problem if event data
+         * was written on every TPT event. */
+        G4bool  isSelectedByTPT( EventIsSelectedByTPT( record ) );
+        SelectEvent( record, isSelectedByTPT, false );
+        if ( ! isSelectedByTPT )
+            return false;
+#endif
+        CountTPTEvent( evFastSObject, angularRanges );
+        tptEventMustBeWritten = ProjectIsSaved() &&
+                                ! skipInteractionsWithoutEDTonWrite;
+        return false;
+    }
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    G4bool  isSelectedByTPT( ! eventIsFiltered &&
+                             EventIsSelectedByTPT( record ) );
+    G4bool  isSelectedByEDT( isSelectedByTPT &&
+                             EventIsSelectedByEDT( record ) );
+    SelectEvent( record, isSelectedByTPT, isSelectedByEDT );
+    if ( ! isSelectedByTPT )
+        return false;
+    if ( ! isSelectedByEDT )
+    {
+        if ( ! eventDataWrittenOnEveryTPT )
+        {
+            CountTPTEvent( evFastSObject, angularRanges );
+            tptEventMustBeWritten = ProjectIsSaved();
+            return false;
+        }
+        skipEDTOnThisEvent = true;
+    }
+#else
+    if ( eventIsFiltered )
+        return false;
+#endif
+
+    return true;
+}
+
+
+void  CexmcRunManager::CountTPTEvent(
+                                const CexmcEventFastSObject &  evFastSObject,
+                                const CexmcAngularRangeList &  angularRanges )
 {
     CexmcRun *  run( static_cast< CexmcRun * >( currentRun ) );
 
@@ -845,12 +1123,128 @@ void  CexmcRunManager::SaveCurrentTPTEvent(
         if ( evFastSObject.edDigitizerMonitorHasTriggered )
             run->IncrementNmbOfHitsSampled( k->index );
     }
+}
+
+
+void  CexmcRunManager::WriteTPTEvent(
+                                const CexmcEventFastSObject &  evFastSObject )
+{
+    CexmcRun *  run( static_cast< CexmcRun * >( currentRun ) );
+
+    if ( ! run )
+        return;
 
-    if ( writeToDatabase )
+    eventsWriter->WriteFast( evFastSObject );
+    run->IncrementNmbOfSavedFastEvents();
+}
+
+
+void  CexmcRunManager::WriteReplayedEvent(
+                                    const CexmcReplayedEventOutput &  output )
+{
+    if ( ! output.error.empty() )
+        G4cout << output.error << G4endl;
+
+    if ( ! eventsWriter )
+        return;
+
+    CexmcRun *  run( static_cast< CexmcRun * >( currentRun ) );
+
+    if ( output.fastEventIsSaved )
     {
-        fastEventsArchive->operator<<( evFastSObject );
+        eventsWriter->WriteFast( output.fastEvent );
         run->IncrementNmbOfSavedFastEvents();
     }
+
+    if ( output.eventIsSaved )
+    {
+        eventsWriter->Write( output.event );
+        run->IncrementNmbOfSavedEvents();
+    }
+}
+
+
+void  CexmcRunManager::SaveCheckpoint( G4int  nmbOfEvents,
+                                      G4int  nmbOfEventsEffective )
+{
+    CexmcRun *  run( static_cast< CexmcRun * >( currentRun ) );
+
+    if ( ! run )
+        return;
+
+    CexmcCheckpointSObject  checkpoint;
+    std::ostringstream      rndmStatus;
+
+    CLHEP::HepRandom::saveFullState( rndmStatus );
+
+    checkpoint.runId = run->GetRunID();
+    checkpoint.numberOfEventsToBeProcessed = numberOfEventToBeProcessed;
+    checkpoint.numberOfEventsProcessed = nmbOfEvents;
+    checkpoint.numberOfEventsProcessedEffective = nmbOfEventsEffective;
+    checkpoint.rndmStatus = rndmStatus.str();
+    eventsWriter->Checkpoint( checkpoint.eventsWriterState );
+
+    G4String       fileName( GetCheckpointFileName() );
+    G4String       tmpFileName( fileName + ".tmp" );
+    std::ofstream  checkpointFile( tmpFileName.c_str() );
+
+    if ( ! checkpointFile )
+        throw CexmcException( CexmcSystemException );
+
+    {
+        const CexmcRun &                 theRun( *run );
+        boost::archive::binary_oarchive  archive( checkpointFile );
+        archive << checkpoint;
+        archive << theRun;
+    }
+
+    checkpointFile.close();
+
+    /* the previous checkpoint is replaced only by a complete new one */
+    if ( ! checkpointFile ||
+         rename( tmpFileName.c_str(), fileName.c_str() ) != 0 )
+        throw CexmcException( CexmcSystemException );
+}
+
+
+G4bool  CexmcRunManager::ReadCheckpoint( CexmcCheckpointSObject &  checkpoint )
+{
+    /* only the first run after start can be resumed */
+    resumeFromCheckpoint = false;
+
+    std::ifstream  checkpointFile( GetCheckpointFileName().c_str() );
+
+    if ( ! checkpointFile )
+        return false;
+
+    CexmcRun *  run( static_cast< CexmcRun * >( currentRun ) );
+
+    if ( ! run )
+        throw CexmcException( CexmcWeirdException );
+
+    {
+        boost::archive::binary_iarchive  archive( checkpointFile );
+        archive >> checkpoint;
+        archive >> *run;
+    }
+
+    if ( checkpoint.runId != run->GetRunID() ||
+         checkpoint.numberOfEventsToBeProcessed != numberOfEventToBeProcessed )
+        throw CexmcException( CexmcCheckpointMismatch );
+
+    std::istringstream  rndmStatus( checkpoint.rndmStatus );
+
+    CLHEP::HepRandom::restoreFullState( rndmStatus );
+
+    G4cout << CEXMC_LINE_START << "Run is resumed after event " <<
+              checkpoint.numberOfEventsProcessed << G4endl;
+#ifdef CEXMC_USE_ROOT
+    G4cout << CEXMC_LINE_START "WARNING: Histograms are not checkpointed, "
+              "they will contain only\n              events processed after "
+              "resuming; replay the project to rebuild them" << G4endl;
+#endif
+
+    return true;
 }
 
 #endif
@@ -879,23 +1273,62 @@ void  CexmcRunManager::DoEventLoop( G4int  nEvent, const char *  macroFile,
     numberOfEventsProcessed = 0;
     numberOfEventsProcessedEffective = 0;
 
+#ifdef CEXMC_USE_PROFILER
+    CexmcStageProfiler::Instance()->Reset();
+#endif
+
 #ifdef CEXMC_USE_PERSISTENCY
-    eventsArchive = NULL;
-    fastEventsArchive = NULL;
+    eventsWriter = NULL;
     if ( ProjectIsRead() )
     {
         if ( ProjectIsSaved() )
         {
-            std::ofstream   eventsDataFile(
-                        ( projectsDir + "/" + projectId + ".edb" ).c_str() );
-            boost::archive::binary_oarchive  eventsArchive_( eventsDataFile );
-            std::ofstream   fastEventsDataFile(
-                        ( projectsDir + "/" + projectId + ".fdb" ).c_str() );
-            boost::archive::binary_oarchive  fastEventsArchive_(
-                                                        fastEventsDataFile );
-            eventsArchive = &eventsArchive_;
-            fastEventsArchive = &fastEventsArchive_;
+            CexmcEventsWriter  eventsWriter_( projectsDir + "/" + projectId,
+                                              eventDataFormat, eventDataCodec );
+            eventsWriter = &eventsWriter_;
+#ifdef CEXMC_USE_CUSTOM_FILTER
+            for ( CexmcReplayOutputList::iterator  k( replayOutputs.begin() );
+                                            k != replayOutputs.end(); ++k )
+            {
+                k->eventsWriter = new CexmcEventsWriter(
+                                    projectsDir + "/" + k->projectId,
+                                    eventDataFormat, eventDataCodec );
+                delete k->run;
+                k->run = new CexmcRun;
+                k->numberOfEventsProcessedEffective = 0;
+            }
+            try
+            {
+                DoReadEventLoop( nEvent );
+                for ( CexmcReplayOutputList::iterator
+                        k( replayOutputs.begin() ); k != replayOutputs.end();
+                        ++k )
+                    k->eventsWriter->Close();
+            }
+            catch ( ... )
+            {
+                SwitchReplayOutput( 0 );
+                for ( CexmcReplayOutputList::iterator
+                        k( replayOutputs.begin() ); k != replayOutputs.end();
+                        ++k )
+                {
+                    delete k->eventsWriter;
+                    k->eventsWriter = NULL;
+                }
+                throw;
+            }
+            for ( CexmcReplayOutputList::iterator  k( replayOutputs.begin() );
+                                            k != replayOutputs.end(); ++k )
+            {
+                delete k->eventsWriter;
+                k->eventsWriter = NULL;
+            }
+#else
             DoReadEventLoop( nEvent );
+#endif
+            /* a failure to write the last records must not be left
+             * unnoticed: the project would be saved as complete */
+            eventsWriter_.Close();
         }
         else
         {
@@ -906,24 +1339,28 @@ void  CexmcRunManager::DoEventLoop( G4int  nEvent, const char *  macroFile,
     {
         if ( ProjectIsSaved() )
         {
-            std::ofstream   eventsDataFile(
-                        ( projectsDir + "/" + projectId + ".edb" ).c_str() );
-            boost::archive::binary_oarchive  eventsArchive_( eventsDataFile );
-            std::ofstream   fastEventsDataFile(
-                        ( projectsDir + "/" + projectId + ".fdb" ).c_str() );
-            boost::archive::binary_oarchive  fastEventsArchive_(
-                                                        fastEventsDataFile );
-            eventsArchive = &eventsArchive_;
-            fastEventsArchive = &fastEventsArchive_;
-            DoCommonEventLoop( nEvent, cmd, nSelect );
+            CexmcCheckpointSObject  checkpoint;
+            G4bool                  resumed( resumeFromCheckpoint &&
+                                             ReadCheckpoint( checkpoint ) );
+            CexmcEventsWriter       eventsWriter_(
+                                projectsDir + "/" + projectId, eventDataFormat,
+                                eventDataCodec, resumed ?
+                                    &checkpoint.eventsWriterState : NULL );
+            eventsWriter = &eventsWriter_;
+            if ( resumed )
+                DoCommonEventLoop( nEvent, cmd, nSelect,
+                            checkpoint.numberOfEventsProcessed,
+                            checkpoint.numberOfEventsProcessedEffective );
+            else
+                DoCommonEventLoop( nEvent, cmd, nSelect );
+            eventsWriter_.Close();
         }
         else
         {
             DoCommonEventLoop( nEvent, cmd, nSelect );
         }
     }
-    eventsArchive = NULL;
-    fastEventsArchive = NULL;
+    eventsWriter = NULL;
 #else
     DoCommonEventLoop( nEvent, cmd, nSelect );
 #endif
@@ -946,6 +1383,12 @@ void  CexmcRunManager::DoEventLoop( G4int  nEvent, const char *  macroFile,
         }
         G4cout << "  "  << *timer << G4endl;
     }
+
+#ifdef CEXMC_USE_PROFILER
+    CexmcStageProfiler *  profiler( CexmcStageProfiler::Instance() );
+    profiler->PrintResults();
+    profiler->SaveResults( currentRun->GetRunID() );
+#endif
 }
 
 
@@ -972,6 +1415,15 @@ void  CexmcRunManager::PrintReadRunData( void ) const
     }
     G4cout << "  -- Event data verbose level (0 - not saved, 1 - triggers, "
               "2 - interactions): " << sObject.evDataVerboseLevel << G4endl;
+    G4cout << "  -- Event data format (0 - boost archive, 1 - columnar): " <<
+              sObject.eventDataFormat << G4endl;
+    G4cout << "  -- Event data codec (0 - none, 1 - lz): " <<
+              sObject.eventDataCodec << G4endl;
+    if ( sObject.calorimeterEDFloor > 0 )
+    {
+        G4cout << "  -- Calorimeter ED floor (less ED in crystals not saved): "
+               << G4BestUnit( sObject.calorimeterEDFloor, "Energy" ) << G4endl;
+    }
     if ( ! sObject.rProject.empty() )
     {
         if ( sObject.evDataVerboseLevel == CexmcWriteEventDataOnEveryEDT )
@@ -1155,43 +1607,83 @@ void  CexmcRunManager::ReadAndPrintEventsData( void ) const
 
     CexmcEventSObject  evSObject;
 
+    if ( sObject.eventDataFormat == CexmcColumnarEventDataFormat )
+    {
+        CexmcColumnarEventsStore  columnarStore(
+                                projectsDir + "/" + rProject + ".cdb" );
+
+        for ( int  i( 0 ); i < sObject.nmbOfSavedEvents; ++i )
+        {
+            columnarStore.Read( i, evSObject );
+            PrintEventData( evSObject );
+        }
+
+        return;
+    }
+
     /* read events data */
     std::ifstream   eventsDataFile(
                         ( projectsDir + "/" + rProject + ".edb" ).c_str() );
     if ( ! eventsDataFile )
         throw CexmcException( CexmcReadProjectIncomplete );
 
-    boost::archive::binary_iarchive  evArchive( eventsDataFile );
+    std::istream                     eventsDataStream(
+                                                eventsDataFile.rdbuf() );
+    CexmcCompressedInputStreambuf *  eventsDataDecompressor( NULL );
 
-    for ( int  i( 0 ); i < sObject.nmbOfSavedEvents; ++i )
+    if ( sObject.eventDataCodec != CexmcNoEventDataCodec )
     {
-        evArchive >> evSObject;
+        eventsDataDecompressor = new CexmcCompressedInputStreambuf(
+                            eventsDataFile.rdbuf(), sObject.eventDataCodec );
+        eventsDataStream.rdbuf( eventsDataDecompressor );
+    }
 
-        if ( ! evSObject.edDigitizerMonitorHasTriggered )
-            continue;
+    try
+    {
+        boost::archive::binary_iarchive  evArchive( eventsDataStream );
 
-        CexmcEnergyDepositStore  edStore( evSObject.monitorED,
-            evSObject.vetoCounterEDLeft, evSObject.vetoCounterEDRight,
-            evSObject.calorimeterEDLeft, evSObject.calorimeterEDRight,
-            0, 0, 0, 0, evSObject.calorimeterEDLeftCollection,
-            evSObject.calorimeterEDRightCollection );
-
-        CexmcTrackPointsStore    tpStore( evSObject.monitorTP,
-            evSObject.targetTPBeamParticle, evSObject.targetTPOutputParticle,
-            evSObject.targetTPNucleusParticle,
-            evSObject.targetTPOutputParticleDecayProductParticle1,
-            evSObject.targetTPOutputParticleDecayProductParticle2,
-            evSObject.vetoCounterTPLeft, evSObject.vetoCounterTPRight,
-            evSObject.calorimeterTPLeft, evSObject.calorimeterTPRight );
-
-        const CexmcProductionModelData &  pmData(
+        for ( int  i( 0 ); i < sObject.nmbOfSavedEvents; ++i )
+        {
+            evArchive >> evSObject;
+            PrintEventData( evSObject );
+        }
+    }
+    catch ( ... )
+    {
+        delete eventsDataDecompressor;
+        throw;
+    }
+
+    delete eventsDataDecompressor;
+}
+
+
+void  CexmcRunManager::PrintEventData( const CexmcEventSObject &  evSObject )
+{
+    if ( ! evSObject.edDigitizerMonitorHasTriggered )
+        return;
+
+    CexmcEnergyDepositStore  edStore( evSObject.monitorED,
+        evSObject.vetoCounterEDLeft, evSObject.vetoCounterEDRight,
+        evSObject.calorimeterEDLeft, evSObject.calorimeterEDRight,
+        0, 0, 0, 0, evSObject.calorimeterEDLeftCollection,
+        evSObject.calorimeterEDRightCollection );
+
+    CexmcTrackPointsStore    tpStore( evSObject.monitorTP,
+        evSObject.targetTPBeamParticle, evSObject.targetTPOutputParticle,
+        evSObject.targetTPNucleusParticle,
+        evSObject.targetTPOutputParticleDecayProductParticle1,
+        evSObject.targetTPOutputParticleDecayProductParticle2,
+        evSObject.vetoCounterTPLeft, evSObject.vetoCounterTPRight,
+        evSObject.calorimeterTPLeft, evSObject.calorimeterTPRight );
+
+    const CexmcProductionModelData &  pmData(
                                             evSObject.productionModelData );
 
-        G4cout << "Event " << evSObject.eventId << G4endl;
-        CexmcEventAction::PrintTrackPoints( &tpStore );
-        G4cout << " --- Production model data: " << pmData;
-        CexmcEventAction::PrintEnergyDeposit( &edStore );
-    }
+    G4cout << "Event " << evSObject.eventId << G4endl;
+    CexmcEventAction::PrintTrackPoints( &tpStore );
+    G4cout << " --- Production model data: " << pmData;
+    CexmcEventAction::PrintEnergyDeposit( &edStore );
 }
 
 
@@ -1275,6 +1767,138 @@ void  CexmcRunManager::SetCustomFilter( const G4String &  cfFileName_ )
     customFilter = new CexmcCustomFilterEval( cfFileName );
 }
 
+
+void  CexmcRunManager::AddReplayOutput( const G4String &  projectId_,
+                                        const G4String &  cfFileName_,
+                                        G4bool  overrideExistingProject )
+{
+    /* should not get here */
+    if ( ! ProjectIsRead() || ! ProjectIsSaved() )
+        throw CexmcException( CexmcCmdIsNotAllowed );
+
+    /* this exception must be caught before calling the method! */
+    if ( projectId_ == rProject || projectId_ == projectId )
+        throw CexmcException( CexmcWeirdException );
+
+    struct stat  tmp;
+    if ( stat( ( projectsDir + "/" + projectId_ + ".rdb" ).c_str(), &tmp ) == 0
+         && ! overrideExistingProject )
+        throw CexmcException( CexmcProjectExists );
+
+    /* the read project's gdml file has been already unzipped if needed */
+    G4String  cmd( G4String( "cp " ) + gdmlFileName + " " + projectsDir + "/" +
+                   projectId_ + gdmlFileExtension );
+    if ( zipGdmlFile )
+        cmd = G4String( "bzip2 -c " ) + gdmlFileName + " > " + projectsDir +
+                "/" + projectId_ + gdmlbz2FileExtension;
+    if ( system( cmd ) != 0 )
+        throw CexmcException( zipGdmlFile ? CexmcFileCompressException :
+                                            CexmcReadProjectIncomplete );
+
+    CexmcReplayOutput  output = { projectId_, cfFileName_, NULL, NULL, NULL,
+                                  0 };
+
+    if ( ! cfFileName_.empty() )
+        output.customFilter = new CexmcCustomFilterEval( cfFileName_ );
+
+    replayOutputs.push_back( output );
+}
+
+
+void  CexmcRunManager::SwitchReplayOutput( G4int  index )
+{
+    if ( index == curReplayOutput )
+        return;
+
+    if ( curReplayOutput > 0 )
+        SwapReplayOutput( replayOutputs[ curReplayOutput - 1 ] );
+
+    if ( index > 0 )
+        SwapReplayOutput( replayOutputs[ index - 1 ] );
+
+    curReplayOutput = index;
+}
+
+
+void  CexmcRunManager::SwapReplayOutput( CexmcReplayOutput &  output )
+{
+    std::swap( customFilter, output.customFilter );
+    std::swap( eventsWriter, output.eventsWriter );
+
+    /* events action updates counters of the current run */
+    G4Run *  run( output.run );
+    output.run = static_cast< CexmcRun * >( currentRun );
+    currentRun = run;
+}
+
+
+void  CexmcRunManager::SaveEventsSelection( const G4String &  name )
+{
+    if ( ! ProjectIsRead() )
+        throw CexmcException( CexmcCmdIsNotAllowed );
+
+    delete wEventsSelection;
+    wEventsSelection = NULL;
+    wEventsSelectionName = name;
+}
+
+
+void  CexmcRunManager::UseEventsSelection( const G4String &  name )
+{
+    if ( ! ProjectIsRead() )
+        throw CexmcException( CexmcCmdIsNotAllowed );
+
+    delete rEventsSelection;
+    rEventsSelection = NULL;
+
+    if ( name.empty() )
+        return;
+
+    CexmcEventsSelection *  selection( new CexmcEventsSelection(
+                                    GetEventsSelectionFileName( name ) ) );
+
+    if ( selection->GetNmbOfRecords() != sObject.nmbOfSavedFastEvents )
+    {
+        delete selection;
+        throw CexmcException( CexmcCFSelectionMismatch );
+    }
+
+    rEventsSelection = selection;
+}
+
+
+G4bool  CexmcRunManager::EventIsSelectedByTPT( G4int  record ) const
+{
+    if ( rEventsSelection && ! rEventsSelection->IsSelectedByTPT( record ) )
+        return false;
+
+    return ! customFilter || customFilter->EvalTPT();
+}
+
+
+G4bool  CexmcRunManager::EventIsSelectedByEDT( G4int  record ) const
+{
+    if ( rEventsSelection && ! rEventsSelection->IsSelectedByEDT( record ) )
+        return false;
+
+    return ! customFilter || customFilter->EvalEDT();
+}
+
+
+void  CexmcRunManager::SelectEvent( G4int  record, G4bool  byTPT,
+                                    G4bool  byEDT )
+{
+    if ( curReplayOutput == 0 && wEventsSelection )
+        wEventsSelection->Select( record, byTPT, byEDT );
+}
+
+
+G4String  CexmcRunManager::GetEventsSelectionFileName(
+                                                const G4String &  name ) const
+{
+    return projectsDir + "/" + rProject + "." + name + ".sel";
+}
+
 #endif
 
 #endif
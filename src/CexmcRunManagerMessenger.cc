@@ -19,9 +19,12 @@
 #include <G4UIcmdWithAString.hh>
 #include <G4UIcmdWithAnInteger.hh>
 #include <G4UIcmdWithABool.hh>
+#include <G4UIcmdWithADouble.hh>
+#include <G4UIcmdWithADoubleAndUnit.hh>
 #include <G4UIcmdWithoutParameter.hh>
 #include "CexmcRunManager.hh"
 #include "CexmcRunManagerMessenger.hh"
+#include "CexmcStageProfiler.hh"
 #include "CexmcMessenger.hh"
 
 
@@ -29,9 +32,22 @@ CexmcRunManagerMessenger::CexmcRunManagerMessenger(
                                 CexmcRunManager *  runManager ) :
     runManager( runManager ), setProductionModel( NULL ), setGdmlFile( NULL ),
     setGuiMacro( NULL ), setEventCountPolicy( NULL ),
-    setEventDataVerboseLevel( NULL ),
+    setEventDataVerboseLevel( NULL ), setTargetAccError( NULL ),
+    setPrecisionCheckInterval( NULL ), setEventBudget( NULL ),
+    setTimeBudget( NULL ),
 #ifdef CEXMC_USE_PERSISTENCY
     replayEvents( NULL ), seekTo( NULL ), skipInteractionsWithoutEDT( NULL ), 
+    setEventDataFormat( NULL ), setEventDataCodec( NULL ),
+    setCalorimeterEDFloor( NULL ), setCheckpointInterval( NULL ),
+#ifdef CEXMC_USE_THREADS
+    setReplayThreads( NULL ),
+#endif
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    saveEventsSelection( NULL ), useEventsSelection( NULL ),
+#endif
+#endif
+#ifdef CEXMC_USE_PROFILER
+    enableProfiler( NULL ), setProfilerOutputFile( NULL ),
 #endif
     registerScenePrimitives( NULL ), validateGdmlFile( NULL )
 {
@@ -79,6 +95,49 @@ CexmcRunManagerMessenger::CexmcRunManagerMessenger(
     setEventDataVerboseLevel->AvailableForStates( G4State_PreInit,
                                                   G4State_Idle );
 
+    setTargetAccError = new G4UIcmdWithADouble(
+        ( CexmcMessenger::runDirName + "targetAccError" ).c_str(), this );
+    setTargetAccError->SetGuidance( "Stop the run when relative statistical "
+        "errors of real and\n    reconstructed acceptances in all angular "
+        "ranges are not greater\n    than this value (0 - never). Number of "
+        "events in beamOn is still\n    the upper limit" );
+    setTargetAccError->SetParameterName( "TargetAccError", false );
+    setTargetAccError->SetRange( "TargetAccError >= 0" );
+    setTargetAccError->SetDefaultValue( 0 );
+    setTargetAccError->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    setPrecisionCheckInterval = new G4UIcmdWithAnInteger(
+        ( CexmcMessenger::runDirName + "precisionCheckInterval" ).c_str(),
+        this );
+    setPrecisionCheckInterval->SetGuidance( "Check acceptances errors every "
+        "specified number of events" );
+    setPrecisionCheckInterval->SetParameterName( "PrecisionCheckInterval",
+                                                 false );
+    setPrecisionCheckInterval->SetRange( "PrecisionCheckInterval > 0" );
+    setPrecisionCheckInterval->SetDefaultValue( 1000 );
+    setPrecisionCheckInterval->AvailableForStates( G4State_PreInit,
+                                                   G4State_Idle );
+
+    setEventBudget = new G4UIcmdWithAnInteger(
+        ( CexmcMessenger::runDirName + "eventBudget" ).c_str(), this );
+    setEventBudget->SetGuidance( "Stop the run after specified number of "
+        "sampled events\n    regardless of event count policy (0 - no limit)" );
+    setEventBudget->SetParameterName( "EventBudget", false );
+    setEventBudget->SetRange( "EventBudget >= 0" );
+    setEventBudget->SetDefaultValue( 0 );
+    setEventBudget->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    setTimeBudget = new G4UIcmdWithADoubleAndUnit(
+        ( CexmcMessenger::runDirName + "timeBudget" ).c_str(), this );
+    setTimeBudget->SetGuidance( "Stop the run when its event loop lasts "
+        "longer than specified\n    (real) time (0 - no limit)" );
+    setTimeBudget->SetParameterName( "TimeBudget", false );
+    setTimeBudget->SetRange( "TimeBudget >= 0" );
+    setTimeBudget->SetDefaultValue( 0 );
+    setTimeBudget->SetUnitCandidates( "ms s" );
+    setTimeBudget->SetDefaultUnit( "s" );
+    setTimeBudget->AvailableForStates( G4State_PreInit, G4State_Idle );
+
 #ifdef CEXMC_USE_PERSISTENCY
     replayEvents = new G4UIcmdWithAnInteger(
         ( CexmcMessenger::runDirName + "replay" ).c_str(), this );
@@ -115,6 +174,109 @@ CexmcRunManagerMessenger::CexmcRunManagerMessenger(
     skipInteractionsWithoutEDT->SetDefaultValue( true );
     skipInteractionsWithoutEDT->AvailableForStates( G4State_PreInit,
                                                     G4State_Idle );
+
+    setEventDataFormat = new G4UIcmdWithAString(
+        ( CexmcMessenger::runDirName + "eventDataFormat" ).c_str(), this );
+    setEventDataFormat->SetGuidance( "Format of saved events data.\n"
+            "    boost - boost binary archive (.edb file),\n"
+            "    columnar - fixed-width column blocks which can be"
+            "\n               memory-mapped (.cdb file)" );
+    setEventDataFormat->SetParameterName( "EventDataFormat", false );
+    setEventDataFormat->SetCandidates( "boost columnar" );
+    setEventDataFormat->SetDefaultValue( "boost" );
+    setEventDataFormat->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    setEventDataCodec = new G4UIcmdWithAString(
+        ( CexmcMessenger::runDirName + "eventDataCodec" ).c_str(), this );
+    setEventDataCodec->SetGuidance( "Block compression of saved events data "
+            "(.fdb and .edb files).\n"
+            "    none - not compressed,\n"
+            "    lz - fast built-in LZ77 codec" );
+    setEventDataCodec->SetParameterName( "EventDataCodec", false );
+    setEventDataCodec->SetCandidates( "none lz" );
+    setEventDataCodec->SetDefaultValue( "none" );
+    setEventDataCodec->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    setCalorimeterEDFloor = new G4UIcmdWithADoubleAndUnit(
+        ( CexmcMessenger::runDirName + "calorimeterEDFloor" ).c_str(), this );
+    setCalorimeterEDFloor->SetGuidance( "Energy deposit in calorimeter "
+        "crystals less than this value\n    is not saved (replayed as zero)" );
+    setCalorimeterEDFloor->SetParameterName( "CalorimeterEDFloor", false );
+    setCalorimeterEDFloor->SetRange( "CalorimeterEDFloor >= 0" );
+    setCalorimeterEDFloor->SetDefaultValue( 0 );
+    setCalorimeterEDFloor->SetUnitCandidates( "eV keV MeV GeV" );
+    setCalorimeterEDFloor->SetDefaultUnit( "MeV" );
+    setCalorimeterEDFloor->AvailableForStates( G4State_PreInit,
+                                               G4State_Idle );
+
+    setCheckpointInterval = new G4UIcmdWithAnInteger(
+        ( CexmcMessenger::runDirName + "checkpointInterval" ).c_str(), this );
+    setCheckpointInterval->SetGuidance( "Save a checkpoint of the written "
+        "project every specified number\n    of events (0 - never). A run "
+        "which was interrupted can be resumed from\n    its last checkpoint "
+        "using command line option '-c'" );
+    setCheckpointInterval->SetParameterName( "CheckpointInterval", false );
+    setCheckpointInterval->SetRange( "CheckpointInterval >= 0" );
+    setCheckpointInterval->SetDefaultValue( 0 );
+    setCheckpointInterval->AvailableForStates( G4State_PreInit,
+                                               G4State_Idle );
+
+#ifdef CEXMC_USE_THREADS
+    setReplayThreads = new G4UIcmdWithAnInteger(
+        ( CexmcMessenger::runDirName + "replayThreads" ).c_str(), this );
+    setReplayThreads->SetGuidance( "Number of threads which process events "
+        "when replaying a project\n    (0 or 1 - events are processed in the "
+        "main thread). Events are processed\n    in the main thread anyway if "
+        "they are printed, drawn or profiled" );
+    setReplayThreads->SetParameterName( "ReplayThreads", false );
+    setReplayThreads->SetRange( "ReplayThreads >= 0" );
+    setReplayThreads->SetDefaultValue( 0 );
+    setReplayThreads->AvailableForStates( G4State_PreInit, G4State_Idle );
+#endif
+
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    saveEventsSelection = new G4UIcmdWithAString(
+        ( CexmcMessenger::runDirName + "saveSelection" ).c_str(), this );
+    saveEventsSelection->SetGuidance( "Save decisions of the custom filter on "
+        "replayed events in\n    specified selection of the read project "
+        "(available only if a project\n    is read). The selection is saved "
+        "after every replay, events which\n    were not replayed are not "
+        "selected. Empty name cancels saving" );
+    saveEventsSelection->SetParameterName( "SaveSelection", true );
+    saveEventsSelection->SetDefaultValue( "" );
+    saveEventsSelection->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    useEventsSelection = new G4UIcmdWithAString(
+        ( CexmcMessenger::runDirName + "useSelection" ).c_str(), this );
+    useEventsSelection->SetGuidance( "Replay only events selected in "
+        "specified selection of the\n    read project, events data of other "
+        "events are skipped without\n    decoding (available only if a project "
+        "is read). Custom filter is\n    still applied to selected events. "
+        "Empty name cancels the selection" );
+    useEventsSelection->SetParameterName( "UseSelection", true );
+    useEventsSelection->SetDefaultValue( "" );
+    useEventsSelection->AvailableForStates( G4State_PreInit, G4State_Idle );
+#endif
+#endif
+
+#ifdef CEXMC_USE_PROFILER
+    enableProfiler = new G4UIcmdWithABool(
+        ( CexmcMessenger::runDirName + "profile" ).c_str(), this );
+    enableProfiler->SetGuidance( "Measure time spent in stages of event "
+        "processing (generation,\n    transport, digitization, reconstruction "
+        "etc.) and print them\n    in the run summary" );
+    enableProfiler->SetParameterName( "Profile", true );
+    enableProfiler->SetDefaultValue( true );
+    enableProfiler->AvailableForStates( G4State_PreInit, G4State_Idle );
+
+    setProfilerOutputFile = new G4UIcmdWithAString(
+        ( CexmcMessenger::runDirName + "profileFile" ).c_str(), this );
+    setProfilerOutputFile->SetGuidance( "File where measured times of stages "
+        "of event processing\n    will be appended in a plain table after "
+        "every run, the first\n    column of the table is the run id" );
+    setProfilerOutputFile->SetParameterName( "ProfileFile", false );
+    setProfilerOutputFile->AvailableForStates( G4State_PreInit,
+                                               G4State_Idle );
 #endif
 
     registerScenePrimitives = new G4UIcmdWithoutParameter(
@@ -142,10 +304,29 @@ CexmcRunManagerMessenger::~CexmcRunManagerMessenger()
     delete setGuiMacro;
     delete setEventCountPolicy;
     delete setEventDataVerboseLevel;
+    delete setTargetAccError;
+    delete setPrecisionCheckInterval;
+    delete setEventBudget;
+    delete setTimeBudget;
 #ifdef CEXMC_USE_PERSISTENCY
     delete replayEvents;
     delete seekTo;
     delete skipInteractionsWithoutEDT;
+    delete setEventDataFormat;
+    delete setEventDataCodec;
+    delete setCalorimeterEDFloor;
+    delete setCheckpointInterval;
+#ifdef CEXMC_USE_THREADS
+    delete setReplayThreads;
+#endif
+#ifdef CEXMC_USE_CUSTOM_FILTER
+    delete saveEventsSelection;
+    delete useEventsSelection;
+#endif
+#endif
+#ifdef CEXMC_USE_PROFILER
+    delete enableProfiler;
+    delete setProfilerOutputFile;
 #endif
     delete registerScenePrimitives;
     delete validateGdmlFile;
@@ -231,6 +412,30 @@ void  CexmcRunManagerMessenger::SetNewValue( G4UIcommand *  cmd,
             runManager->SetEventDataVerboseLevel( eventDataVerboseLevel );
             break;
         }
+        if ( cmd == setTargetAccError )
+        {
+            runManager->SetTargetAcceptanceError(
+                            G4UIcmdWithADouble::GetNewDoubleValue( value ) );
+            break;
+        }
+        if ( cmd == setPrecisionCheckInterval )
+        {
+            runManager->SetPrecisionCheckInterval(
+                                G4UIcmdWithAnInteger::GetNewIntValue( value ) );
+            break;
+        }
+        if ( cmd == setEventBudget )
+        {
+            runManager->SetEventBudget(
+                                G4UIcmdWithAnInteger::GetNewIntValue( value ) );
+            break;
+        }
+        if ( cmd == setTimeBudget )
+        {
+            runManager->SetTimeBudget(
+                    G4UIcmdWithADoubleAndUnit::GetNewDoubleValue( value ) );
+            break;
+        }
 #ifdef CEXMC_USE_PERSISTENCY
         if ( cmd == replayEvents )
         {
@@ -249,6 +454,80 @@ void  CexmcRunManagerMessenger::SetNewValue( G4UIcommand *  cmd,
                                 G4UIcmdWithABool::GetNewBoolValue( value ) );
             break;
         }
+        if ( cmd == setEventDataFormat )
+        {
+            CexmcEventDataFormat  eventDataFormat(
+                                            CexmcBoostArchiveEventDataFormat );
+            do
+            {
+                if ( value == "columnar" )
+                {
+                    eventDataFormat = CexmcColumnarEventDataFormat;
+                    break;
+                }
+            } while ( false );
+            runManager->SetEventDataFormat( eventDataFormat );
+            break;
+        }
+        if ( cmd == setEventDataCodec )
+        {
+            CexmcEventDataCodec  eventDataCodec( CexmcNoEventDataCodec );
+            do
+            {
+                if ( value == "lz" )
+                {
+                    eventDataCodec = CexmcLZEventDataCodec;
+                    break;
+                }
+            } while ( false );
+            runManager->SetEventDataCodec( eventDataCodec );
+            break;
+        }
+        if ( cmd == setCalorimeterEDFloor )
+        {
+            runManager->SetCalorimeterEDFloor(
+                    G4UIcmdWithADoubleAndUnit::GetNewDoubleValue( value ) );
+            break;
+        }
+        if ( cmd == setCheckpointInterval )
+        {
+            runManager->SetCheckpointInterval(
+                                G4UIcmdWithAnInteger::GetNewIntValue( value ) );
+            break;
+        }
+#ifdef CEXMC_USE_THREADS
+        if ( cmd == setReplayThreads )
+        {
+            runManager->SetReplayThreads(
+                                G4UIcmdWithAnInteger::GetNewIntValue( value ) );
+            break;
+        }
+#endif
+#ifdef CEXMC_USE_CUSTOM_FILTER
+        if ( cmd == saveEventsSelection )
+        {
+            runManager->SaveEventsSelection( value );
+            break;
+        }
+        if ( cmd == useEventsSelection )
+        {
+            runManager->UseEventsSelection( value );
+            break;
+        }
+#endif
+#endif
+#ifdef CEXMC_USE_PROFILER
+        if ( cmd == enableProfiler )
+        {
+            CexmcStageProfiler::Instance()->Enable(
+                                G4UIcmdWithABool::GetNewBoolValue( value ) );
+            break;
+        }
+        if ( cmd == setProfilerOutputFile )
+        {
+            CexmcStageProfiler::Instance()->SetOutputFileName( value );
+            break;
+        }
 #endif
         if ( cmd == registerScenePrimitives )
         {
@@ -0,0 +1,222 @@
+/*
+ * ============================================================================
+ *
+ *       Filename:  CexmcStageProfiler.cc
+ *
+ *    Description:  timing of stages of the event pipeline
+ *
+ *        Version:  1.0
+ *        Created:  17.10.2026 21:29:06
+ *       Revision:  none
+ *       Compiler:  gcc
+ *
+ *         Author:  Alexey Radkov (), 
+ *        Company:  PNPI
+ *
+ * ============================================================================
+ */
+
+#ifdef CEXMC_USE_PROFILER
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <G4ios.hh>
+#include "CexmcStageProfiler.hh"
+#include "CexmcException.hh"
+#include "CexmcCommon.hh"
+
+
+namespace
+{
+    const char *  stageNames[] =
+    {
+        "event", "generation", "transport", "edDigitize", "tpDigitize",
+        "reconstruction", "save", "histos", "read"
+    };
+
+    /* each power of 2 of durations in nanoseconds is split into 8 buckets,
+     * this gives about 9% resolution of percentiles up to several hours */
+    const G4int  nmbOfSubBuckets( 8 );
+
+    const G4int  nmbOfBuckets( 48 * nmbOfSubBuckets );
+
+
+    G4int  GetBucket( G4double  duration )
+    {
+        if ( duration < 1. )
+            return 0;
+
+        G4int     exponent( 0 );
+        G4double  mantissa( std::frexp( duration, &exponent ) );
+        G4int     bucket( exponent * nmbOfSubBuckets +
+                          G4int( ( mantissa - 0.5 ) * 2 * nmbOfSubBuckets ) );
+
+        return bucket < nmbOfBuckets ? bucket : nmbOfBuckets - 1;
+    }
+
+
+    G4double  GetBucketValue( G4int  bucket )
+    {
+        G4int  exponent( bucket / nmbOfSubBuckets );
+        G4int  subBucket( bucket % nmbOfSubBuckets );
+
+        return std::ldexp( 0.5 + ( subBucket + 0.5 ) / ( 2 * nmbOfSubBuckets ),
+                           exponent );
+    }
+}
+
+
+CexmcStageProfiler::CexmcStageData::CexmcStageData() :
+    isStarted( false ), start( 0 ), count( 0 ), total( 0 ), max( 0 ),
+    buckets( nmbOfBuckets, 0 )
+{
+}
+
+
+CexmcStageProfiler *  CexmcStageProfiler::instance( NULL );
+
+
+CexmcStageProfiler *  CexmcStageProfiler::Instance( void )
+{
+    if ( instance == NULL )
+        instance = new CexmcStageProfiler;
+
+    return instance;
+}
+
+
+void  CexmcStageProfiler::Destroy( void )
+{
+    delete instance;
+    instance = NULL;
+}
+
+
+CexmcStageProfiler::CexmcStageProfiler() : isEnabled( false )
+{
+}
+
+
+void  CexmcStageProfiler::Enable( G4bool  on )
+{
+    isEnabled = on;
+}
+
+
+void  CexmcStageProfiler::SetOutputFileName( const G4String &  value )
+{
+    outputFileName = value;
+}
+
+
+void  CexmcStageProfiler::Reset( void )
+{
+    for ( G4int  i( 0 ); i < CexmcProfiledStage_SIZE; ++i )
+        stages[ i ] = CexmcStageData();
+}
+
+
+void  CexmcStageProfiler::Record( CexmcStageData &  data, G4double  duration )
+{
+    ++data.count;
+    data.total += duration;
+    if ( duration > data.max )
+        data.max = duration;
+    ++data.buckets[ GetBucket( duration ) ];
+}
+
+
+G4double  CexmcStageProfiler::GetPercentile( const CexmcStageData &  data,
+                                             G4double  fraction )
+{
+    G4double  threshold( fraction * data.count );
+    G4int     accumulated( 0 );
+
+    for ( G4int  i( 0 ); i < nmbOfBuckets; ++i )
+    {
+        accumulated += data.buckets[ i ];
+        if ( accumulated >= threshold && accumulated > 0 )
+        {
+            G4double  value( GetBucketValue( i ) );
+            return value < data.max ? value : data.max;
+        }
+    }
+
+    return data.max;
+}
+
+
+void  CexmcStageProfiler::PrintResults( void ) const
+{
+    if ( ! isEnabled )
+        return;
+
+    G4cout << " --- Profiled stages (count | total, s | mean / p50 / p90 / "
+              "p99 / max, us):" << G4endl;
+
+    std::ios_base::fmtflags  flags( G4cout.flags() );
+    std::streamsize          precision( G4cout.precision() );
+
+    G4cout.setf( std::ios::fixed );
+
+    for ( G4int  i( 0 ); i < CexmcProfiledStage_SIZE; ++i )
+    {
+        const CexmcStageData &  data( stages[ i ] );
+
+        if ( data.count == 0 )
+            continue;
+
+        G4cout << "       " << std::setw( 14 ) << stageNames[ i ] << "  | " <<
+                  std::setw( 10 ) << data.count << " | " <<
+                  std::setprecision( 3 ) << std::setw( 10 ) <<
+                  data.total / 1e9 << " | " << std::setprecision( 1 ) <<
+                  data.total / data.count / 1e3 << " / " <<
+                  GetPercentile( data, 0.5 ) / 1e3 << " / " <<
+                  GetPercentile( data, 0.9 ) / 1e3 << " / " <<
+                  GetPercentile( data, 0.99 ) / 1e3 << " / " <<
+                  data.max / 1e3 << G4endl;
+    }
+
+    G4cout.flags( flags );
+    G4cout.precision( precision );
+}
+
+
+void  CexmcStageProfiler::SaveResults( G4int  runId ) const
+{
+    if ( ! isEnabled || outputFileName == "" )
+        return;
+
+    /* results of every run are appended to the file, so that profiles of all
+     * runs of a macro are kept */
+    std::ofstream  file( outputFileName.c_str(), std::ios::app );
+
+    if ( ! file || ! file.seekp( 0, std::ios::end ) )
+        throw CexmcException( CexmcSystemException );
+
+    if ( file.tellp() == std::streampos( 0 ) )
+        file << "# run stage count total_s mean_us p50_us p90_us p99_us "
+                "max_us" << std::endl;
+
+    for ( G4int  i( 0 ); i < CexmcProfiledStage_SIZE; ++i )
+    {
+        const CexmcStageData &  data( stages[ i ] );
+
+        if ( data.count == 0 )
+            continue;
+
+        file << runId << " " << stageNames[ i ] << " " << data.count << " " <<
+                data.total / 1e9 << " " << data.total / data.count / 1e3 <<
+                " " << GetPercentile( data, 0.5 ) / 1e3 << " " <<
+                GetPercentile( data, 0.9 ) / 1e3 << " " <<
+                GetPercentile( data, 0.99 ) / 1e3 << " " << data.max / 1e3 <<
+                std::endl;
+    }
+
+    if ( ! file )
+        throw CexmcException( CexmcSystemException );
+}
+
+#endif
+
@@ -16,7 +16,6 @@
  * ============================================================================
  */
 
-#include <G4DigiManager.hh>
 #include <G4RunManager.hh>
 #include <G4String.hh>
 #include "CexmcTrackPointsDigitizer.hh"
@@ -56,6 +55,12 @@ void  CexmcTrackPointsDigitizer::InitializeData( void )
 
 
 void  CexmcTrackPointsDigitizer::Digitize( void )
+{
+    Digitize( NULL );
+}
+
+
+void  CexmcTrackPointsDigitizer::Digitize( G4HCofThisEvent *  hcOfThisEvent )
 {
     InitializeData();
 
@@ -64,13 +69,11 @@ void  CexmcTrackPointsDigitizer::Digitize( void )
     G4double  crystalWidth( calorimeterGeometry.crystalWidth );
     G4double  crystalHeight( calorimeterGeometry.crystalHeight );
 
-    G4DigiManager *  digiManager( G4DigiManager::GetDMpointer() );
-    G4int    hcId( digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcMonitorDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcTPDetector ] ) );
     const CexmcTrackPointsCollection *
              hitsCollection( static_cast< const CexmcTrackPointsCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcMonitorDetectorRole,
+                                                 CexmcTPDetector ) ) );
 
     if ( hitsCollection )
     {
@@ -83,11 +86,10 @@ void  CexmcTrackPointsDigitizer::Digitize( void )
         }
     }
 
-    hcId = digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcTargetDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
     hitsCollection = static_cast< const CexmcTrackPointsCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcTargetDetectorRole,
+                                                 CexmcTPDetector ) );
 
     if ( hitsCollection )
     {
@@ -133,11 +135,10 @@ void  CexmcTrackPointsDigitizer::Digitize( void )
         }
     }
 
-    hcId = digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcVetoCounterDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
     hitsCollection = static_cast< const CexmcTrackPointsCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcVetoCounterDetectorRole,
+                                                 CexmcTPDetector ) );
 
     if ( hitsCollection )
     {
@@ -165,11 +166,10 @@ void  CexmcTrackPointsDigitizer::Digitize( void )
         }
     }
 
-    hcId = digiManager->GetHitsCollectionID(
-                    CexmcDetectorRoleName[ CexmcCalorimeterDetectorRole ] +
-                    "/" + CexmcDetectorTypeName[ CexmcTPDetector ] );
     hitsCollection = static_cast< const CexmcTrackPointsCollection * >(
-                                    digiManager->GetHitsCollection( hcId ) );
+                            hcIds.GetCollection( hcOfThisEvent,
+                                                 CexmcCalorimeterDetectorRole,
+                                                 CexmcTPDetector ) );
 
     if ( hitsCollection )
     {
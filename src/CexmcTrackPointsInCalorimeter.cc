@@ -35,19 +35,18 @@ CexmcTrackPointsInCalorimeter::CexmcTrackPointsInCalorimeter(
 
 G4int  CexmcTrackPointsInCalorimeter::GetIndex( G4Step *  step )
 {
-    G4int                        ret( GetTrackId( step ) );
-    G4StepPoint *                preStep( step->GetPreStepPoint() );
-    const G4VTouchable *         touchable( preStep->GetTouchable() );
-    const G4NavigationHistory *  navHistory( touchable->GetHistory() );
-    G4int                        navDepth( navHistory->GetDepth() );
-    G4VPhysicalVolume *          pVolume( navHistory->GetVolume(
-                                                        navDepth - 2 ) );
+    G4int      ret( GetTrackId( step ) );
+    CexmcSide  side( CexmcLeft );
+    G4int      row( 0 );
+    G4int      column( 0 );
 
-    if ( setup->IsRightCalorimeter( pVolume ) )
-        ret |= 1 << leftRightBitsOffset;
+    setup->GetCalorimeterCrystal(
+                    step->GetPreStepPoint()->GetTouchable()->GetHistory(),
+                    side, row, column );
 
-    ret |= touchable->GetReplicaNumber( 0 ) << copyDepth0BitsOffset;
-    ret |= touchable->GetReplicaNumber( 1 ) << copyDepth1BitsOffset;
+    ret |= side << leftRightBitsOffset;
+    ret |= column << copyDepth0BitsOffset;
+    ret |= row << copyDepth1BitsOffset;
 
     return ret;
 }